@@ -0,0 +1,578 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "scanner.h"
+
+#ifndef SCANNER_VARIANT
+#define SCANNER_VARIANT "default"
+#endif
+
+#ifndef SCANNER_FLEX_OPTIONS
+#define SCANNER_FLEX_OPTIONS ""
+#endif
+
+/* Largest generated source, in MiB. */
+#define MAX_SOURCE_MIB 1024
+#define NUM_IDENTIFIERS 64
+#define NUM_FUNCTIONS 16
+
+/* Every token the scanner can return for valid input: TOK_KW_INT to TOK_SEMICOLON. */
+#define FIRST_TOKEN TOK_KW_INT
+#define NUM_TOKEN_KINDS (TOK_SEMICOLON - TOK_KW_INT + 1)
+
+typedef enum input_mode {
+	/* The source is scanned in place with scanner_set_buffer. */
+	INPUT_BUFFER = 0,
+	/* The source is read from a temporary file with scanner_set_file, so -Cr's read() is measured. */
+	INPUT_FILE,
+	INPUT_COUNT
+} input_mode;
+
+static const char *const input_names[INPUT_COUNT] = {"buffer", "file"};
+
+typedef enum source_mix {
+	/* Functions of random statements, using every token kind. */
+	MIX_CODE = 0,
+	/* Lines of keywords and of identifiers that look like them, for the keyword lookup. */
+	MIX_KEYWORDS,
+	MIX_COUNT
+} source_mix;
+
+static const char *const mix_names[MIX_COUNT] = {"code", "keywords"};
+
+/* Token kinds each mix must produce: every kind, or the keywords, TOK_IDENTIFIER and TOK_SEMICOLON. */
+static const int mix_token_kinds[MIX_COUNT] = {NUM_TOKEN_KINDS, TOK_IDENTIFIER - TOK_KW_INT + 2};
+
+typedef struct source_buffer {
+	char *data;
+	size_t length;
+	size_t capacity;
+	uint64_t random_state;
+} source_buffer;
+
+typedef struct scan_result {
+	double seconds;
+	long tokens;
+	long errors;
+	long token_counts[NUM_TOKEN_KINDS];
+} scan_result;
+
+/* Reads the wall clock, in seconds. */
+static double now_seconds(void)
+{
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/*
+ * Draws the next number of the generator's xorshift sequence, in [0, bound);
+ * bound is at least 1.
+ */
+static unsigned pick(source_buffer *source, unsigned bound)
+{
+	uint64_t x = source->random_state;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	source->random_state = x;
+	return (unsigned)(x % bound);
+}
+
+/* Appends text to the generated source; the buffer was sized up front. */
+static void emit(source_buffer *source, const char *text)
+{
+	size_t length = strlen(text);
+	if (source->length + length + 2 > source->capacity) {
+		return;
+	}
+	memcpy(source->data + source->length, text, length);
+	source->length += length;
+}
+
+/*
+ * Appends a prefix followed by a small decimal number, such as "value_12". The
+ * prefix is an identifier stem, or "" for a plain number.
+ */
+static void emit_number(source_buffer *source, const char *prefix, unsigned value)
+{
+	char text[32];
+	snprintf(text, sizeof(text), "%s%u", prefix, value);
+	emit(source, text);
+}
+
+/*
+ * Appends a random expression using every literal kind and operator. At depth 0
+ * only primaries are emitted.
+ */
+static void emit_expression(source_buffer *source, int depth)
+{
+	static const char *const binary_operators[] = {
+		" + ", " - ", " * ", " / ", " % ", " < ", " <= ", " > ", " >= ", " == ", " != ", " && ", " || "};
+	static const char *const floats[] = {".25", "1.5e3", "3.0E-2", "42e+1"};
+	static const char *const chars[] = {"'c'", "'\\n'", "'\\''"};
+	static const char *const strings[] = {"\"text\"", "\"say \\\"hi\\\"\\n\"", "\"\""};
+
+	unsigned shape = depth > 0 ? pick(source, 12) : pick(source, 6);
+	switch (shape) {
+		case 0:
+		case 1:
+			emit_number(source, "value_", pick(source, NUM_IDENTIFIERS));
+			break;
+		case 2:
+			emit_number(source, "", pick(source, 100000));
+			break;
+		case 3:
+			emit(source, floats[pick(source, sizeof(floats) / sizeof(floats[0]))]);
+			break;
+		case 4:
+			emit(source, chars[pick(source, sizeof(chars) / sizeof(chars[0]))]);
+			break;
+		case 5:
+			emit(source, strings[pick(source, sizeof(strings) / sizeof(strings[0]))]);
+			break;
+		case 6:
+		case 7:
+			emit_expression(source, depth - 1);
+			emit(source, binary_operators[pick(source, sizeof(binary_operators) / sizeof(binary_operators[0]))]);
+			emit_expression(source, depth - 1);
+			break;
+		case 8:
+			emit(source, pick(source, 2) == 0 ? "!(" : "-(");
+			emit_expression(source, depth - 1);
+			emit(source, ")");
+			break;
+		case 9:
+			emit_number(source, "table_", pick(source, NUM_IDENTIFIERS));
+			emit(source, "[");
+			emit_expression(source, depth - 1);
+			emit(source, "]");
+			break;
+		default:
+			emit_number(source, "function_", pick(source, NUM_FUNCTIONS));
+			emit(source, "(");
+			emit_expression(source, depth - 1);
+			emit(source, ", ");
+			emit_expression(source, depth - 1);
+			emit(source, ")");
+			break;
+	}
+}
+
+/*
+ * Appends a random statement; together the shapes use every keyword. depth is
+ * the remaining block nesting.
+ */
+static void emit_statement(source_buffer *source, int depth)
+{
+	static const char *const types[] = {"int", "float", "double", "char"};
+	static const char *const assignments[] = {" = ", " += ", " -= ", " *= ", " /= ", " %= "};
+
+	unsigned shape = depth > 0 ? pick(source, 11) : pick(source, 6);
+	switch (shape) {
+		case 0:
+			emit(source, "\t");
+			emit(source, types[pick(source, sizeof(types) / sizeof(types[0]))]);
+			emit_number(source, " local_", pick(source, NUM_IDENTIFIERS));
+			emit(source, " = ");
+			emit_expression(source, 2);
+			emit(source, ";\n");
+			break;
+		case 1:
+			emit_number(source, "\tvalue_", pick(source, NUM_IDENTIFIERS));
+			emit(source, assignments[pick(source, sizeof(assignments) / sizeof(assignments[0]))]);
+			emit_expression(source, 3);
+			emit(source, ";\n");
+			break;
+		case 2:
+			emit_number(source, "\tfunction_", pick(source, NUM_FUNCTIONS));
+			emit(source, "(");
+			emit_expression(source, 2);
+			emit(source, ", \"argument\");\n");
+			break;
+		case 3:
+			emit_number(source, "\tvalue_", pick(source, NUM_IDENTIFIERS));
+			emit(source, pick(source, 2) == 0 ? "++; // counter\n" : "--; // countdown\n");
+			break;
+		case 4:
+			emit(source, "\t/* checked below */ table_0[value_1] = ");
+			emit_expression(source, 1);
+			emit(source, ";\n");
+			break;
+		case 5:
+			emit(source, pick(source, 2) == 0 ? "\tbreak;\n" : "\tcontinue;\n");
+			break;
+		case 6:
+		case 7:
+			emit(source, "\tif (");
+			emit_expression(source, 2);
+			emit(source, ") {\n");
+			emit_statement(source, depth - 1);
+			emit(source, "\t} else {\n");
+			emit_statement(source, depth - 1);
+			emit(source, "\t}\n");
+			break;
+		case 8:
+			emit(source, "\twhile (");
+			emit_expression(source, 2);
+			emit(source, ") {\n");
+			emit_statement(source, depth - 1);
+			emit(source, "\t}\n");
+			break;
+		default:
+			emit(source, "\tfor (index = 0; index < ");
+			emit_number(source, "", pick(source, 1000));
+			emit(source, "; index++) {\n");
+			emit_statement(source, depth - 1);
+			emit(source, "\t}\n");
+			break;
+	}
+}
+
+/*
+ * Appends a line of keywords and look-alike identifiers ended by a semicolon.
+ * The identifiers share a keyword's length or its first and last characters,
+ * so they reach the keyword comparison instead of being turned away early.
+ */
+static void emit_keyword_line(source_buffer *source)
+{
+	static const char *const keywords[] = {
+		"int", "float", "double", "char", "void", "if", "else", "while", "for", "return", "break", "continue"};
+	static const char *const look_alikes[] = {
+		"iot", "fleet", "dowble", "chur", "vend", "of", "erie", "whale", "fur", "reborn", "brook", "centrale",
+		"integer", "doubles", "elsewhere", "format", "value_1"};
+
+	int words = 3 + (int)pick(source, 6);
+	for (int i = 0; i < words; i++) {
+		emit(source, i == 0 ? "" : " ");
+		if (pick(source, 2) == 0) {
+			emit(source, keywords[pick(source, sizeof(keywords) / sizeof(keywords[0]))]);
+		} else {
+			emit(source, look_alikes[pick(source, sizeof(look_alikes) / sizeof(look_alikes[0]))]);
+		}
+	}
+	emit(source, ";\n");
+}
+
+/*
+ * Generates a C-like source of about target_bytes for the given mix. MIX_CODE
+ * emits functions of random statements, which together use every ScannerToken;
+ * MIX_KEYWORDS emits keyword lines. The buffer ends with the two NUL bytes
+ * yy_scan_buffer needs, which the returned length excludes. The same non-zero
+ * seed always gives the same source. Returns false on allocation failure.
+ */
+static bool generate_source(size_t target_bytes, source_mix mix, uint64_t seed, source_buffer *out_source)
+{
+	/* The last function may overshoot the target by one function body. */
+	const size_t slack = 64 * 1024;
+
+	memset(out_source, 0, sizeof(*out_source));
+	out_source->capacity = target_bytes + slack;
+	out_source->data = (char *)malloc(out_source->capacity);
+	if (out_source->data == NULL) {
+		return false;
+	}
+	out_source->random_state = seed;
+
+	if (mix == MIX_KEYWORDS) {
+		while (out_source->length < target_bytes) {
+			emit_keyword_line(out_source);
+		}
+		out_source->data[out_source->length] = '\0';
+		out_source->data[out_source->length + 1] = '\0';
+		return true;
+	}
+
+	emit(out_source, "int index;\nint table_0[64];\nfloat scale = 0.5;\n");
+	unsigned function_id = 0;
+	while (out_source->length < target_bytes) {
+		emit(out_source, pick(out_source, 2) == 0 ? "int" : "void");
+		emit_number(out_source, " function_", function_id++ % NUM_FUNCTIONS);
+		emit(out_source, "(int value_0, float value_1)\n{\n");
+		int statements = 4 + (int)pick(out_source, 12);
+		for (int i = 0; i < statements; i++) {
+			emit_statement(out_source, 2);
+		}
+		emit(out_source, "\treturn value_0;\n}\n\n");
+	}
+
+	out_source->data[out_source->length] = '\0';
+	out_source->data[out_source->length + 1] = '\0';
+	return true;
+}
+
+/*
+ * Scans the source once through the given input and times it. The buffer input
+ * scans the source in place and leaves it unchanged; the file input reads the
+ * same source from file. Returns false when the input could not be set up.
+ */
+static bool run_scan(source_buffer *source, FILE *file, input_mode mode, scan_result *out_result)
+{
+	memset(out_result, 0, sizeof(*out_result));
+
+	Scanner *scanner = scanner_create();
+	if (scanner == NULL) {
+		return false;
+	}
+	int set = 0;
+	if (mode == INPUT_BUFFER) {
+		set = scanner_set_buffer(scanner, source->data, source->length);
+	} else {
+		rewind(file);
+		set = scanner_set_file(scanner, file);
+	}
+	if (set != 0) {
+		scanner_destroy(scanner);
+		return false;
+	}
+
+	double started = now_seconds();
+	int token;
+	while ((token = scanner_next_token(scanner, NULL)) != TOK_EOF) {
+		if (token >= FIRST_TOKEN && token < FIRST_TOKEN + NUM_TOKEN_KINDS) {
+			out_result->token_counts[token - FIRST_TOKEN]++;
+		} else {
+			out_result->errors++;
+		}
+		out_result->tokens++;
+	}
+	out_result->seconds = now_seconds() - started;
+
+	scanner_destroy(scanner);
+	return true;
+}
+
+/* Writes the source to an anonymous temporary file; NULL on I/O error. */
+static FILE *write_temporary_source(const source_buffer *source)
+{
+	FILE *file = tmpfile();
+	if (file == NULL) {
+		return NULL;
+	}
+	if (fwrite(source->data, 1, source->length, file) != source->length || fflush(file) != 0) {
+		fclose(file);
+		return NULL;
+	}
+	return file;
+}
+
+/*
+ * Benchmarks one source size through both inputs and writes its JSON object.
+ * Each input runs repeat times and the fastest run counts; the buffer-input
+ * throughput is returned for the summary line. Fails unless every run succeeds
+ * and produces every token kind of the mix without errors.
+ */
+static bool bench_size(FILE *out, int size_mib, source_mix mix, int repeat, double *out_bytes_per_second)
+{
+	double generate_started = now_seconds();
+	source_buffer source;
+	if (!generate_source((size_t)size_mib * 1024 * 1024, mix, 0x9e3779b97f4a7c15ULL, &source)) {
+		fprintf(stderr, "Failed to allocate a %d MiB source.\n", size_mib);
+		fprintf(out, "    {\n      \"size_mib\": %d,\n      \"error\": \"out of memory\"\n    }", size_mib);
+		return false;
+	}
+	FILE *file = write_temporary_source(&source);
+	double generate_seconds = now_seconds() - generate_started;
+	if (file == NULL) {
+		fprintf(stderr, "Failed to write a %d MiB temporary source: %s\n", size_mib, strerror(errno));
+		fprintf(out, "    {\n      \"size_mib\": %d,\n      \"error\": \"temporary file failed\"\n    }", size_mib);
+		free(source.data);
+		return false;
+	}
+
+	scan_result best[INPUT_COUNT];
+	bool ok = true;
+	for (int mode = 0; mode < INPUT_COUNT && ok; mode++) {
+		for (int run = 0; run < repeat; run++) {
+			scan_result result;
+			if (!run_scan(&source, file, (input_mode)mode, &result)) {
+				ok = false;
+				break;
+			}
+			if (run == 0 || result.seconds < best[mode].seconds) {
+				best[mode] = result;
+			}
+		}
+	}
+	fclose(file);
+	free(source.data);
+	if (!ok) {
+		fprintf(stderr, "Failed to set up the scanner input.\n");
+		fprintf(out, "    {\n      \"size_mib\": %d,\n      \"error\": \"scanner setup failed\"\n    }", size_mib);
+		return false;
+	}
+
+	int kinds_seen = 0;
+	for (int i = 0; i < NUM_TOKEN_KINDS; i++) {
+		if (best[INPUT_BUFFER].token_counts[i] > 0) {
+			kinds_seen++;
+		}
+	}
+	bool consistent = best[INPUT_FILE].tokens == best[INPUT_BUFFER].tokens;
+
+	const double bytes = (double)source.length;
+	fprintf(out, "    {\n");
+	fprintf(out, "      \"size_mib\": %d,\n", size_mib);
+	fprintf(out, "      \"bytes\": %zu,\n", source.length);
+	fprintf(out, "      \"tokens\": %ld,\n", best[INPUT_BUFFER].tokens);
+	fprintf(out, "      \"errors\": %ld,\n", best[INPUT_BUFFER].errors);
+	fprintf(out, "      \"token_kinds_seen\": %d,\n", kinds_seen);
+	fprintf(out, "      \"token_kinds\": %d,\n", mix_token_kinds[mix]);
+	fprintf(out, "      \"generate_seconds\": %.6f,\n", generate_seconds);
+	for (int mode = 0; mode < INPUT_COUNT; mode++) {
+		double seconds = best[mode].seconds > 0.0 ? best[mode].seconds : 1e-9;
+		fprintf(out, "      \"%s\": {\n", input_names[mode]);
+		fprintf(out, "        \"seconds\": %.6f,\n", best[mode].seconds);
+		fprintf(out, "        \"tokens_per_second\": %.0f,\n", (double)best[mode].tokens / seconds);
+		fprintf(out, "        \"bytes_per_second\": %.0f\n", bytes / seconds);
+		fprintf(out, "      }%s\n", mode + 1 < INPUT_COUNT ? "," : "");
+	}
+	fprintf(out, "    }");
+
+	*out_bytes_per_second = bytes / (best[INPUT_BUFFER].seconds > 0.0 ? best[INPUT_BUFFER].seconds : 1e-9);
+	if (best[INPUT_BUFFER].errors > 0 || kinds_seen < mix_token_kinds[mix] || !consistent) {
+		fprintf(stderr, "The %d MiB source scanned with %ld errors and %d of %d token kinds%s.\n",
+			size_mib, best[INPUT_BUFFER].errors, kinds_seen, mix_token_kinds[mix],
+			consistent ? "" : "; buffer and file inputs disagree");
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Returns the size of the running executable, which differs between variants
+ * only by the scanner, or -1 when it cannot be determined. argv0 is used when
+ * /proc is not available.
+ */
+static long long executable_size(const char *argv0)
+{
+	struct stat info;
+	if (stat("/proc/self/exe", &info) == 0 || stat(argv0, &info) == 0) {
+		return (long long)info.st_size;
+	}
+	return -1;
+}
+
+/*
+ * Parses a comma-separated list of source sizes in MiB, such as "1,16,64",
+ * into a newly allocated array.
+ */
+static bool parse_sizes(const char *text, int **out_sizes, int *out_count)
+{
+	int count = 1;
+	for (const char *c = text; *c != '\0'; c++) {
+		if (*c == ',') {
+			count++;
+		}
+	}
+
+	int *sizes = (int *)malloc((size_t)count * sizeof(int));
+	if (sizes == NULL) {
+		return false;
+	}
+
+	const char *cursor = text;
+	for (int i = 0; i < count; i++) {
+		char *end = NULL;
+		errno = 0;
+		long value = strtol(cursor, &end, 10);
+		if (errno != 0 || end == cursor || value < 1 || value > MAX_SOURCE_MIB || (*end != ',' && *end != '\0')) {
+			free(sizes);
+			return false;
+		}
+		sizes[i] = (int)value;
+		cursor = end + 1;
+	}
+
+	*out_sizes = sizes;
+	*out_count = count;
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *output_path = NULL;
+	int repeat = 1;
+	source_mix mix = MIX_CODE;
+	int *sizes = NULL;
+	int num_sizes = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--output=", 9) == 0) {
+			output_path = argv[i] + 9;
+		} else if (strcmp(argv[i], "--mix=code") == 0) {
+			mix = MIX_CODE;
+		} else if (strcmp(argv[i], "--mix=keywords") == 0) {
+			mix = MIX_KEYWORDS;
+		} else if (strncmp(argv[i], "--repeat=", 9) == 0) {
+			repeat = atoi(argv[i] + 9);
+		} else if (strncmp(argv[i], "--sizes=", 8) == 0) {
+			free(sizes);
+			if (!parse_sizes(argv[i] + 8, &sizes, &num_sizes)) {
+				fprintf(stderr, "Invalid --sizes list '%s' (MiB, 1 to %d).\n", argv[i] + 8, MAX_SOURCE_MIB);
+				return 1;
+			}
+		} else {
+			fprintf(stderr, "Unknown option '%s'.\n", argv[i]);
+			free(sizes);
+			return 1;
+		}
+	}
+
+	if (repeat < 1) {
+		fprintf(stderr, "Usage: %s [--output=report.json] [--mix=code|keywords] [--repeat=N] [--sizes=MIB1,MIB2,...]\n", argv[0]);
+		free(sizes);
+		return 1;
+	}
+	if (num_sizes == 0) {
+		static const int default_sizes[] = {1, 16, 64};
+		num_sizes = (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+		sizes = (int *)malloc(sizeof(default_sizes));
+		if (sizes == NULL) {
+			return 1;
+		}
+		memcpy(sizes, default_sizes, sizeof(default_sizes));
+	}
+
+	FILE *out = stdout;
+	if (output_path != NULL) {
+		out = fopen(output_path, "w");
+		if (out == NULL) {
+			fprintf(stderr, "Failed to open '%s': %s\n", output_path, strerror(errno));
+			free(sizes);
+			return 1;
+		}
+	}
+
+	long long binary_bytes = executable_size(argv[0]);
+	int failures = 0;
+	fprintf(out, "{\n  \"benchmark\": \"scanner_throughput\",\n");
+	fprintf(out, "  \"variant\": \"%s\",\n", SCANNER_VARIANT);
+	fprintf(out, "  \"flex_options\": \"%s\",\n", SCANNER_FLEX_OPTIONS);
+	fprintf(out, "  \"mix\": \"%s\",\n", mix_names[mix]);
+	fprintf(out, "  \"binary_bytes\": %lld,\n", binary_bytes);
+	fprintf(out, "  \"repeat\": %d,\n  \"sources\": [\n", repeat);
+	for (int i = 0; i < num_sizes; i++) {
+		double bytes_per_second = 0.0;
+		fprintf(out, i == 0 ? "" : ",\n");
+		if (!bench_size(out, sizes[i], mix, repeat, &bytes_per_second)) {
+			failures++;
+		}
+		fprintf(stderr, "%-13s %-4s %-8s %5d MiB  %8.1f MiB/s  binary %lld bytes\n",
+			SCANNER_VARIANT, SCANNER_FLEX_OPTIONS, mix_names[mix], sizes[i], bytes_per_second / (1024.0 * 1024.0), binary_bytes);
+	}
+	fprintf(out, "\n  ]\n}\n");
+	if (out != stdout) {
+		fclose(out);
+		printf("Benchmark report written to %s\n", output_path);
+	}
+
+	free(sizes);
+	return failures == 0 ? 0 : 1;
+}
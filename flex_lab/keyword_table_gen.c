@@ -0,0 +1,297 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Generates the keyword hash table of scanner_keywords.c from the keyword list
+ * in scanner_keywords.txt, in the layout gperf uses: the hash of a word is its
+ * length plus the weights of its first and last characters, and the weights
+ * are searched so that every keyword lands in its own slot. The smallest table
+ * is tried first, so with the current keywords the hash is minimal too. The
+ * build fails when no weights make the hash perfect.
+ *
+ * Usage: keyword_table_gen KEYWORDS_TXT OUTPUT_H
+ */
+#define MAX_KEYWORDS 64
+#define MAX_NAME_LENGTH 32
+#define MAX_TOKEN_LENGTH 64
+/* Widest table tried, as slots beyond one per keyword. */
+#define MAX_EXTRA_SLOTS 64
+/* Weight assignments tried for one table size before a wider one is tried. */
+#define MAX_SEARCH_STEPS 10000000L
+
+typedef struct KeywordEntry {
+	char name[MAX_NAME_LENGTH + 1];
+	char token[MAX_TOKEN_LENGTH + 1];
+	int length;
+} KeywordEntry;
+
+typedef struct Search {
+	const KeywordEntry *keywords;
+	int num_keywords;
+	/* Characters that begin or end a keyword, in the order weights are assigned. */
+	unsigned char chars[2 * MAX_KEYWORDS];
+	int num_chars;
+	/* For each position of chars, the keywords whose hash it completes. */
+	int completes[2 * MAX_KEYWORDS][MAX_KEYWORDS];
+	int num_completes[2 * MAX_KEYWORDS];
+	int span;
+	int weights[256];
+	/* Hash of each keyword, and the keywords hashed so far in search order. */
+	int hashes[MAX_KEYWORDS];
+	int hashed[MAX_KEYWORDS];
+	int num_hashed;
+	long steps;
+} Search;
+
+static bool read_keywords(const char *path, KeywordEntry *keywords, int *out_count)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		fprintf(stderr, "keyword_table_gen: cannot open %s\n", path);
+		return false;
+	}
+
+	char line[256];
+	int count = 0;
+	int line_number = 0;
+	bool ok = true;
+	while (ok && fgets(line, sizeof(line), file) != NULL) {
+		line_number++;
+		char name[MAX_NAME_LENGTH + 1];
+		char token[MAX_TOKEN_LENGTH + 1];
+		char extra;
+		int fields = sscanf(line, " %32s %64s %c", name, token, &extra);
+		if (fields <= 0 || name[0] == '#') {
+			continue;
+		}
+		if (fields != 2) {
+			fprintf(stderr, "%s:%d: expected a keyword and its token\n", path, line_number);
+			ok = false;
+		} else if (count == MAX_KEYWORDS) {
+			fprintf(stderr, "%s:%d: more than %d keywords\n", path, line_number, MAX_KEYWORDS);
+			ok = false;
+		} else {
+			strcpy(keywords[count].name, name);
+			strcpy(keywords[count].token, token);
+			keywords[count].length = (int)strlen(name);
+			count++;
+		}
+	}
+	fclose(file);
+
+	if (ok && count == 0) {
+		fprintf(stderr, "%s: no keywords\n", path);
+		ok = false;
+	}
+	/* Keywords of the same length, first and last character always share a hash. */
+	for (int i = 0; ok && i < count; i++) {
+		for (int j = i + 1; ok && j < count; j++) {
+			const KeywordEntry *a = &keywords[i];
+			const KeywordEntry *b = &keywords[j];
+			if (a->length == b->length && a->name[0] == b->name[0] &&
+				a->name[a->length - 1] == b->name[b->length - 1]) {
+				fprintf(stderr, "%s: %s and %s always hash alike\n", path, a->name, b->name);
+				ok = false;
+			}
+		}
+	}
+	*out_count = count;
+	return ok;
+}
+
+/*
+ * Orders the characters so that each one completes as many keyword hashes as
+ * possible, which makes collisions show up early in the search.
+ */
+static void plan_search(Search *search)
+{
+	bool assigned[256] = {false};
+	bool used[256] = {false};
+	bool hashed[MAX_KEYWORDS] = {false};
+
+	for (int i = 0; i < search->num_keywords; i++) {
+		used[(unsigned char)search->keywords[i].name[0]] = true;
+		used[(unsigned char)search->keywords[i].name[search->keywords[i].length - 1]] = true;
+	}
+
+	search->num_chars = 0;
+	for (;;) {
+		int best = -1;
+		int best_count = -1;
+		for (int c = 0; c < 256; c++) {
+			if (!used[c] || assigned[c]) {
+				continue;
+			}
+			int count = 0;
+			for (int i = 0; i < search->num_keywords; i++) {
+				unsigned char first = (unsigned char)search->keywords[i].name[0];
+				unsigned char last = (unsigned char)search->keywords[i].name[search->keywords[i].length - 1];
+				if (!hashed[i] && (first == c || assigned[first]) && (last == c || assigned[last])) {
+					count++;
+				}
+			}
+			if (count > best_count) {
+				best = c;
+				best_count = count;
+			}
+		}
+		if (best < 0) {
+			break;
+		}
+
+		int position = search->num_chars++;
+		search->chars[position] = (unsigned char)best;
+		search->num_completes[position] = 0;
+		assigned[best] = true;
+		for (int i = 0; i < search->num_keywords; i++) {
+			unsigned char first = (unsigned char)search->keywords[i].name[0];
+			unsigned char last = (unsigned char)search->keywords[i].name[search->keywords[i].length - 1];
+			if (!hashed[i] && assigned[first] && assigned[last]) {
+				hashed[i] = true;
+				search->completes[position][search->num_completes[position]++] = i;
+			}
+		}
+	}
+}
+
+/* Tries every weight in [0, span] for the character at position, then the next ones. */
+static bool assign_weights(Search *search, int position)
+{
+	if (position == search->num_chars) {
+		return true;
+	}
+
+	unsigned char c = search->chars[position];
+	for (int weight = 0; weight <= search->span && search->steps < MAX_SEARCH_STEPS; weight++) {
+		search->steps++;
+		search->weights[c] = weight;
+		int hashed_before = search->num_hashed;
+		bool fits = true;
+		for (int k = 0; fits && k < search->num_completes[position]; k++) {
+			int index = search->completes[position][k];
+			const KeywordEntry *keyword = &search->keywords[index];
+			int hash = keyword->length + search->weights[(unsigned char)keyword->name[0]] +
+				search->weights[(unsigned char)keyword->name[keyword->length - 1]];
+			/* Pairwise distinct and within span of each other: a perfect hash over span + 1 slots. */
+			for (int h = 0; fits && h < search->num_hashed; h++) {
+				int other = search->hashes[search->hashed[h]];
+				int distance = hash > other ? hash - other : other - hash;
+				fits = distance != 0 && distance <= search->span;
+			}
+			search->hashes[index] = hash;
+			search->hashed[search->num_hashed++] = index;
+		}
+		if (fits && assign_weights(search, position + 1)) {
+			return true;
+		}
+		search->num_hashed = hashed_before;
+	}
+	search->weights[c] = 0;
+	return false;
+}
+
+static void write_table(FILE *out, const char *source_name, const Search *search, int min_hash, int max_hash)
+{
+	int min_length = search->keywords[0].length;
+	int max_length = search->keywords[0].length;
+	for (int i = 1; i < search->num_keywords; i++) {
+		min_length = search->keywords[i].length < min_length ? search->keywords[i].length : min_length;
+		max_length = search->keywords[i].length > max_length ? search->keywords[i].length : max_length;
+	}
+
+	fprintf(out, "/* Generated by keyword_table_gen from %s; do not edit. */\n", source_name);
+	fprintf(out, "#define MIN_WORD_LENGTH %d\n", min_length);
+	fprintf(out, "#define MAX_WORD_LENGTH %d\n", max_length);
+	fprintf(out, "#define MIN_HASH_VALUE %d\n", min_hash);
+	fprintf(out, "#define MAX_HASH_VALUE %d\n\n", max_hash);
+
+	/* Characters that begin or end no keyword send every word using them past the table. */
+	bool used[256] = {false};
+	for (int p = 0; p < search->num_chars; p++) {
+		used[search->chars[p]] = true;
+	}
+	fprintf(out, "static const unsigned char asso_values[256] = {");
+	for (int c = 0; c < 256; c++) {
+		fprintf(out, "%s%2d", c % 16 == 0 ? "\n\t" : ", ", used[c] ? search->weights[c] : max_hash + 1);
+		if (c < 255 && c % 16 == 15) {
+			fprintf(out, ",");
+		}
+	}
+	fprintf(out, "\n};\n\n");
+
+	fprintf(out, "/* Indexed by hash - MIN_HASH_VALUE; empty slots have length 0. */\n");
+	fprintf(out, "static const Keyword keywords[MAX_HASH_VALUE - MIN_HASH_VALUE + 1] = {");
+	for (int hash = min_hash; hash <= max_hash; hash++) {
+		const KeywordEntry *keyword = NULL;
+		for (int i = 0; i < search->num_keywords; i++) {
+			if (search->hashes[i] == hash) {
+				keyword = &search->keywords[i];
+			}
+		}
+		fprintf(out, "%s\n\t", hash == min_hash ? "" : ",");
+		if (keyword != NULL) {
+			fprintf(out, "{\"%s\", %d, %s}", keyword->name, keyword->length, keyword->token);
+		} else {
+			fprintf(out, "{\"\", 0, TOK_IDENTIFIER}");
+		}
+	}
+	fprintf(out, "\n};\n");
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s KEYWORDS_TXT OUTPUT_H\n", argv[0]);
+		return 1;
+	}
+
+	static KeywordEntry keywords[MAX_KEYWORDS];
+	static Search search;
+	int num_keywords = 0;
+	if (!read_keywords(argv[1], keywords, &num_keywords)) {
+		return 1;
+	}
+
+	search.keywords = keywords;
+	search.num_keywords = num_keywords;
+	plan_search(&search);
+
+	bool found = false;
+	for (int extra = 0; !found && extra <= MAX_EXTRA_SLOTS; extra++) {
+		search.span = num_keywords - 1 + extra;
+		search.num_hashed = 0;
+		search.steps = 0;
+		found = assign_weights(&search, 0);
+	}
+	if (!found) {
+		fprintf(stderr, "keyword_table_gen: no perfect hash for the keywords of %s\n", argv[1]);
+		return 1;
+	}
+
+	int min_hash = search.hashes[0];
+	int max_hash = search.hashes[0];
+	for (int i = 1; i < num_keywords; i++) {
+		min_hash = search.hashes[i] < min_hash ? search.hashes[i] : min_hash;
+		max_hash = search.hashes[i] > max_hash ? search.hashes[i] : max_hash;
+	}
+	/* The weight of unused characters, max_hash + 1, must fit asso_values. */
+	if (max_hash >= 255) {
+		fprintf(stderr, "keyword_table_gen: hash values do not fit asso_values\n");
+		return 1;
+	}
+
+	FILE *out = fopen(argv[2], "w");
+	if (out == NULL) {
+		fprintf(stderr, "keyword_table_gen: cannot write %s\n", argv[2]);
+		return 1;
+	}
+	const char *source_name = strrchr(argv[1], '/');
+	write_table(out, source_name != NULL ? source_name + 1 : argv[1], &search, min_hash, max_hash);
+	if (fclose(out) != 0) {
+		fprintf(stderr, "keyword_table_gen: cannot write %s\n", argv[2]);
+		return 1;
+	}
+	return 0;
+}
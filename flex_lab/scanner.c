@@ -1,11 +1,531 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "scanner.h"
 
-extern int yylex(void);
-extern char *yytext;
+/* A split file is cut at the first line start after every this many bytes unless --split=MIB says otherwise. */
+#define DEFAULT_SPLIT_SIZE ((size_t)4 * 1024 * 1024)
+
+typedef struct ScanOptions {
+	ScannerInputMode mode;
+	/* Read files through flex's own buffer instead of in place. */
+	int stream;
+	/* Write binary records instead of [NAME:LEXEME] lines. */
+	int binary;
+	/* Scan each file as ranges of about this many bytes on the worker threads; 0 scans files whole. */
+	size_t split_size;
+} ScanOptions;
+
+/*
+ * One job of a parallel run: a whole file, or the bytes [begin, end) of the
+ * file being split. Its output is kept until the jobs before it are written.
+ */
+typedef struct ScanJob {
+	const char *path;
+	size_t begin;
+	size_t end;
+	char *output;
+	size_t output_length;
+	/* Range jobs: the newlines in the range, and whether a scan from its start ends inside a comment. */
+	size_t newlines;
+	int ends_in_comment;
+	int failed;
+	int done;
+} ScanJob;
+
+typedef struct ScanPool {
+	ScanJob *jobs;
+	int num_jobs;
+	/* Next job a worker takes. */
+	int next_job;
+	/* First job whose output is not written yet. */
+	int next_to_write;
+	/* Jobs a worker may run ahead of the writer, which bounds the output held in memory. */
+	int window;
+	const ScanOptions *options;
+	/* The file the range jobs come from; NULL when the jobs are whole files. */
+	const ScannerInput *input;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+} ScanPool;
+
+/* Called on the main thread with each finished job, in job order. */
+typedef int (*ScanJobWriter)(ScanJob *job, void *context);
+
+/*
+ * Where the sequential scan of a split file stands when the next range
+ * starts: the worker scanned that range as if no comment were open.
+ */
+typedef struct SplitMerge {
+	const ScannerInput *input;
+	const ScanOptions *options;
+	/* Rescans the ranges that start inside a comment. */
+	Scanner *scanner;
+	/* Line the next range starts on. */
+	size_t line;
+	/* A comment opened before the next range is still open when it starts. */
+	int in_comment;
+} SplitMerge;
+
+/*
+ * Scans one file and writes its tokens to `out`, as text lines, or as binary
+ * records through `records` when it is not NULL. The file is scanned in
+ * place (mapped, or read into one block) unless options->stream is set.
+ */
+static int scan_file(Scanner *scanner, const char *path, const ScanOptions *options, FILE *out, ScannerRecordWriter *records)
+{
+	ScannerInput input = {0};
+	FILE *file = NULL;
+	if (options->stream) {
+		file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+		if (file == NULL) {
+			fprintf(stderr, "Failed to read '%s': %s\n", path, strerror(errno));
+			return -1;
+		}
+		scanner_set_file(scanner, file);
+	} else {
+		if (scanner_input_open(&input, path, options->mode) != 0) {
+			fprintf(stderr, "Failed to read '%s': %s\n", path, strerror(errno));
+			return -1;
+		}
+		if (scanner_set_buffer(scanner, input.data, input.length) != 0) {
+			fprintf(stderr, "Failed to create a scanner buffer for '%s'.\n", path);
+			scanner_input_close(&input);
+			return -1;
+		}
+	}
+
+	int result = 0;
+	int token;
+	ScannerLexeme lexeme;
+	ScannerTokenRecord record = {0};
+	while ((token = scanner_next_token(scanner, &lexeme)) != TOK_EOF) {
+		if (records == NULL) {
+			fprintf(out, "[%s:%s]\n", scanner_token_name(token), lexeme.text);
+			continue;
+		}
+
+		record.offset = (uint64_t)(lexeme.text - input.data);
+		record.length = (uint32_t)lexeme.length;
+		record.line = (uint32_t)lexeme.line;
+		record.token = (uint32_t)token;
+		if (scanner_record_write(records, &record) != 0) {
+			result = -1;
+			break;
+		}
+	}
+
+	if (records != NULL && result == 0) {
+		record.offset = input.length;
+		record.length = 0;
+		record.line = (uint32_t)lexeme.line;
+		record.token = TOK_EOF;
+		result = scanner_record_write(records, &record);
+	}
+
+	if (file != NULL && file != stdin) {
+		fclose(file);
+	}
+	scanner_input_close(&input);
+	return result;
+}
+
+static size_t count_newlines(const char *data, size_t length)
+{
+	size_t count = 0;
+	const char *end = data + length;
+	while ((data = memchr(data, '\n', (size_t)(end - data))) != NULL) {
+		count++;
+		data++;
+	}
+	return count;
+}
+
+/*
+ * Scans the bytes [begin, end) of a loaded file as if it started there, on
+ * line `first_line`, and writes the tokens with their offsets in the whole
+ * file. The range is scanned from a private copy, so the NUL flex writes
+ * after each lexeme never lands in bytes another thread is scanning. A range
+ * that ends inside a comment sets *ends_in_comment; the error flex reports
+ * for it at the end of the copy is only a token when `is_last` says the end
+ * of the range is the end of the file.
+ */
+static int scan_range(Scanner *scanner, const ScannerInput *input, size_t begin, size_t end, size_t first_line, int is_last,
+	FILE *out, ScannerRecordWriter *records, int *ends_in_comment)
+{
+	size_t length = end - begin;
+	char *copy = malloc(length + 2);
+	if (copy == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	memcpy(copy, input->data + begin, length);
+	copy[length] = '\0';
+	copy[length + 1] = '\0';
+	if (scanner_set_buffer(scanner, copy, length) != 0) {
+		free(copy);
+		return -1;
+	}
+
+	*ends_in_comment = 0;
+	int result = 0;
+	int token;
+	ScannerLexeme lexeme;
+	ScannerTokenRecord record = {0};
+	while ((token = scanner_next_token(scanner, &lexeme)) != TOK_EOF) {
+		size_t offset = (size_t)(lexeme.text - copy);
+		if (token == TOK_ERROR && offset == length) {
+			/* Only <COMMENT><<EOF>> reports an error at the end of the input. */
+			*ends_in_comment = 1;
+			if (!is_last) {
+				continue;
+			}
+		}
+
+		if (records == NULL) {
+			fprintf(out, "[%s:%s]\n", scanner_token_name(token), lexeme.text);
+			continue;
+		}
+
+		record.offset = begin + offset;
+		record.length = (uint32_t)lexeme.length;
+		record.line = (uint32_t)(first_line + (size_t)lexeme.line - 1);
+		record.token = (uint32_t)token;
+		if (scanner_record_write(records, &record) != 0) {
+			result = -1;
+			break;
+		}
+	}
+
+	free(copy);
+	return result;
+}
 
-int main(void)
+/* scan_range to a stream, through a record writer without a header of its own for binary output. */
+static int write_range(Scanner *scanner, const ScannerInput *input, size_t begin, size_t end, size_t first_line,
+	const ScanOptions *options, FILE *out, int *ends_in_comment)
+{
+	int is_last = end == input->length;
+	if (!options->binary) {
+		return scan_range(scanner, input, begin, end, first_line, is_last, out, NULL, ends_in_comment);
+	}
+
+	ScannerRecordWriter records;
+	if (scanner_record_writer_attach(&records, out) != 0) {
+		return -1;
+	}
+	int result = scan_range(scanner, input, begin, end, first_line, is_last, out, &records, ends_in_comment);
+	if (scanner_record_writer_close(&records) != 0) {
+		result = -1;
+	}
+	return result;
+}
+
+/* Scans one job into an in-memory stream; the records of a binary run have no header of their own. */
+static void run_job(Scanner *scanner, ScanJob *job, const ScanPool *pool)
+{
+	FILE *out = open_memstream(&job->output, &job->output_length);
+	if (out == NULL) {
+		fprintf(stderr, "Failed to buffer the tokens of '%s': %s\n", job->path, strerror(errno));
+		job->failed = 1;
+		return;
+	}
+
+	if (pool->input != NULL) {
+		/* Lines are counted from the start of the range; the writer moves them once the lines before are known. */
+		job->newlines = count_newlines(pool->input->data + job->begin, job->end - job->begin);
+		job->failed = write_range(scanner, pool->input, job->begin, job->end, 1, pool->options, out, &job->ends_in_comment) != 0;
+	} else if (pool->options->binary) {
+		ScannerRecordWriter records;
+		if (scanner_record_writer_attach(&records, out) != 0) {
+			job->failed = 1;
+		} else {
+			job->failed = scan_file(scanner, job->path, pool->options, out, &records) != 0;
+			job->failed |= scanner_record_writer_close(&records) != 0;
+		}
+	} else {
+		job->failed = scan_file(scanner, job->path, pool->options, out, NULL) != 0;
+	}
+
+	if (fclose(out) != 0) {
+		job->failed = 1;
+	}
+}
+
+/* Worker thread: takes the next job while the writer is close enough behind. */
+static void *scan_worker(void *argument)
+{
+	ScanPool *pool = argument;
+	Scanner *scanner = scanner_create();
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		while (pool->next_job < pool->num_jobs && pool->next_job >= pool->next_to_write + pool->window) {
+			pthread_cond_wait(&pool->changed, &pool->lock);
+		}
+		if (pool->next_job >= pool->num_jobs) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		ScanJob *job = &pool->jobs[pool->next_job++];
+		pthread_mutex_unlock(&pool->lock);
+
+		if (scanner != NULL) {
+			run_job(scanner, job, pool);
+		} else {
+			fprintf(stderr, "Failed to create a scanner for '%s'.\n", job->path);
+			job->failed = 1;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		job->done = 1;
+		pthread_cond_broadcast(&pool->changed);
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	scanner_destroy(scanner);
+	return NULL;
+}
+
+/*
+ * Runs the pool's jobs on `num_threads` worker threads, each with its own
+ * Scanner, and hands every finished job to `write_job` in job order.
+ * Returns the number of jobs that failed.
+ */
+static int run_jobs(ScanPool *pool, int num_threads, ScanJobWriter write_job, void *context)
+{
+	pthread_t *threads = calloc((size_t)num_threads, sizeof(pthread_t));
+	if (threads == NULL) {
+		fprintf(stderr, "Failed to allocate %d scan threads.\n", num_threads);
+		return pool->num_jobs;
+	}
+	pool->window = 2 * num_threads;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->changed, NULL);
+
+	int started = 0;
+	for (; started < num_threads; started++) {
+		if (pthread_create(&threads[started], NULL, scan_worker, pool) != 0) {
+			break;
+		}
+	}
+	if (started == 0) {
+		/* No worker could start: scan on this thread instead. */
+		pool->window = pool->num_jobs;
+		scan_worker(pool);
+	}
+
+	int failures = 0;
+	for (int i = 0; i < pool->num_jobs; i++) {
+		ScanJob *job = &pool->jobs[i];
+		pthread_mutex_lock(&pool->lock);
+		while (!job->done) {
+			pthread_cond_wait(&pool->changed, &pool->lock);
+		}
+		pool->next_to_write = i + 1;
+		pthread_cond_broadcast(&pool->changed);
+		pthread_mutex_unlock(&pool->lock);
+
+		if (!job->failed && write_job(job, context) != 0) {
+			job->failed = 1;
+		}
+		failures += job->failed;
+		free(job->output);
+		job->output = NULL;
+	}
+
+	for (int i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	pthread_cond_destroy(&pool->changed);
+	pthread_mutex_destroy(&pool->lock);
+	free(threads);
+	return failures;
+}
+
+static int write_output(const char *output, size_t length)
+{
+	return length == 0 || fwrite(output, 1, length, stdout) == length ? 0 : -1;
+}
+
+static int write_file_job(ScanJob *job, void *context)
+{
+	(void)context;
+	return write_output(job->output, job->output_length);
+}
+
+/*
+ * Scans the files on `num_threads` worker threads, each with its own
+ * Scanner, and writes their outputs to standard output in command-line order.
+ */
+static int scan_files_in_parallel(char **paths, int num_paths, int num_threads, const ScanOptions *options)
+{
+	ScanPool pool = {0};
+	pool.jobs = calloc((size_t)num_paths, sizeof(ScanJob));
+	if (pool.jobs == NULL) {
+		fprintf(stderr, "Failed to allocate %d scan jobs.\n", num_paths);
+		return num_paths;
+	}
+	for (int i = 0; i < num_paths; i++) {
+		pool.jobs[i].path = paths[i];
+	}
+	pool.num_jobs = num_paths;
+	pool.options = options;
+
+	int failures = run_jobs(&pool, num_threads, write_file_job, NULL);
+	free(pool.jobs);
+	return failures;
+}
+
+/* Adds `delta` to the line (bytes 12-15) of each record in a run of header-less records. */
+static void shift_record_lines(char *output, size_t length, size_t delta)
+{
+	if (delta == 0) {
+		return;
+	}
+	for (size_t at = 12; at + 4 <= length; at += SCANNER_RECORD_SIZE) {
+		unsigned char *bytes = (unsigned char *)output + at;
+		uint32_t line = (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+		line += (uint32_t)delta;
+		bytes[0] = (unsigned char)line;
+		bytes[1] = (unsigned char)(line >> 8);
+		bytes[2] = (unsigned char)(line >> 16);
+		bytes[3] = (unsigned char)(line >> 24);
+	}
+}
+
+/* Writes one token that has no lexeme in the file: the end of the file, or the error of a comment left open there. */
+static int write_end_token(const SplitMerge *merge, int token, size_t line)
+{
+	if (!merge->options->binary) {
+		return token == TOK_EOF || fprintf(stdout, "[%s:]\n", scanner_token_name(token)) > 0 ? 0 : -1;
+	}
+
+	ScannerRecordWriter records;
+	if (scanner_record_writer_attach(&records, stdout) != 0) {
+		return -1;
+	}
+	ScannerTokenRecord record = {0};
+	record.offset = merge->input->length;
+	record.line = (uint32_t)line;
+	record.token = (uint32_t)token;
+	int result = scanner_record_write(&records, &record);
+	if (scanner_record_writer_close(&records) != 0) {
+		result = -1;
+	}
+	return result;
+}
+
+/* Returns the offset just after the first comment terminator in [begin, end), or 0 when there is none. */
+static size_t find_comment_end(const char *data, size_t begin, size_t end)
+{
+	const char *at = data + begin;
+	const char *stop = data + end;
+	while (stop - at >= 2 && (at = memchr(at, '*', (size_t)(stop - at - 1))) != NULL) {
+		if (at[1] == '/') {
+			return (size_t)(at - data) + 2;
+		}
+		at++;
+	}
+	return 0;
+}
+
+/*
+ * Writes one range of a split file. A range that starts outside any comment
+ * was scanned by its worker from the same state the sequential scan reaches
+ * there: no token spans a newline, and only a comment carries a start
+ * condition from one line into the next. Its output is written as is, with
+ * its lines moved down. A range that starts inside a comment is rescanned
+ * here from just after the comment closes, and nothing is kept of the
+ * worker's guess.
+ */
+static int write_range_job(ScanJob *job, void *context)
+{
+	SplitMerge *merge = context;
+	const ScannerInput *input = merge->input;
+	int result = 0;
+
+	if (!merge->in_comment) {
+		if (merge->options->binary) {
+			shift_record_lines(job->output, job->output_length, merge->line - 1);
+		}
+		result = write_output(job->output, job->output_length);
+		merge->in_comment = job->ends_in_comment;
+	} else {
+		size_t resume = find_comment_end(input->data, job->begin, job->end);
+		if (resume > 0) {
+			size_t line = merge->line + count_newlines(input->data + job->begin, resume - job->begin);
+			result = write_range(merge->scanner, input, resume, job->end, line, merge->options, stdout, &merge->in_comment);
+		} else if (job->end == input->length) {
+			/* The comment runs to the end of the file, which is the error the sequential scan reports. */
+			result = write_end_token(merge, TOK_ERROR, merge->line + job->newlines);
+		}
+	}
+
+	merge->line += job->newlines;
+	return result;
+}
+
+/*
+ * Scans one file as ranges that start at line starts, each on the next free
+ * worker, and writes the tokens in file order. The output is the output of
+ * scan_file.
+ */
+static int scan_file_split(const char *path, int num_threads, const ScanOptions *options)
+{
+	ScannerInput input;
+	if (scanner_input_open(&input, path, options->mode) != 0) {
+		fprintf(stderr, "Failed to read '%s': %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	ScanPool pool = {0};
+	SplitMerge merge = {&input, options, scanner_create(), 1, 0};
+	pool.jobs = calloc(input.length / options->split_size + 1, sizeof(ScanJob));
+	if (pool.jobs == NULL || merge.scanner == NULL) {
+		fprintf(stderr, "Failed to allocate the ranges of '%s'.\n", path);
+		free(pool.jobs);
+		scanner_destroy(merge.scanner);
+		scanner_input_close(&input);
+		return -1;
+	}
+
+	size_t begin = 0;
+	do {
+		/* The range ends after the first newline at or past its nominal end, or with the file. */
+		size_t end = input.length;
+		if (input.length - begin > options->split_size) {
+			const char *newline = memchr(input.data + begin + options->split_size - 1, '\n', input.length - begin - options->split_size + 1);
+			if (newline != NULL) {
+				end = (size_t)(newline - input.data) + 1;
+			}
+		}
+		ScanJob *job = &pool.jobs[pool.num_jobs++];
+		job->path = path;
+		job->begin = begin;
+		job->end = end;
+		begin = end;
+	} while (begin < input.length);
+	pool.options = options;
+	pool.input = &input;
+
+	int failures = run_jobs(&pool, num_threads < pool.num_jobs ? num_threads : pool.num_jobs, write_range_job, &merge);
+	if (failures == 0 && options->binary && write_end_token(&merge, TOK_EOF, merge.line) != 0) {
+		failures++;
+	}
+
+	free(pool.jobs);
+	scanner_destroy(merge.scanner);
+	scanner_input_close(&input);
+	return failures == 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
 {
 	/*
 	Plantilla guiada de main:
@@ -21,11 +541,99 @@ int main(void)
 	- Lee tokens hasta EOF.
 	- Muestra cada token y su lexema en una línea.
 	*/
-	int token;
-    	while ((token = yylex()) != TOK_EOF) {
-        printf("[%s:%s]\n", scanner_token_name(token), yytext);
-    	}
-    	return 0;
+	/*
+	Files given on the command line are scanned in place (--input=map, the
+	default, or --input=block); --input=stream reads them through flex's own
+	buffer. Without files the scanner reads standard input. --format=binary
+	writes the tokens to standard output as the records described in
+	scanner.h. --jobs=N scans the files on N threads; --split[=MIB] also
+	cuts each file into ranges of about MIB MiB for those threads. The output
+	is the same as with one thread.
+	*/
+	ScanOptions options = {SCANNER_INPUT_MAP, 0, 0, 0};
+	int num_threads = 1;
+	int first_file = 1;
+	for (; first_file < argc && strncmp(argv[first_file], "--", 2) == 0; first_file++) {
+		if (strcmp(argv[first_file], "--input=map") == 0) {
+			options.mode = SCANNER_INPUT_MAP;
+			options.stream = 0;
+		} else if (strcmp(argv[first_file], "--input=block") == 0) {
+			options.mode = SCANNER_INPUT_BLOCK;
+			options.stream = 0;
+		} else if (strcmp(argv[first_file], "--input=stream") == 0) {
+			options.stream = 1;
+		} else if (strcmp(argv[first_file], "--format=text") == 0) {
+			options.binary = 0;
+		} else if (strcmp(argv[first_file], "--format=binary") == 0) {
+			options.binary = 1;
+		} else if (strncmp(argv[first_file], "--jobs=", 7) == 0 && atoi(argv[first_file] + 7) > 0) {
+			num_threads = atoi(argv[first_file] + 7);
+		} else if (strcmp(argv[first_file], "--split") == 0) {
+			options.split_size = DEFAULT_SPLIT_SIZE;
+		} else if (strncmp(argv[first_file], "--split=", 8) == 0 && atoi(argv[first_file] + 8) > 0) {
+			options.split_size = (size_t)atoi(argv[first_file] + 8) * 1024 * 1024;
+		} else {
+			fprintf(stderr, "Usage: %s [--input=map|block|stream] [--format=text|binary] [--jobs=N] [--split[=MIB]] [file...]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	/* Offsets come from the in-place buffer, so binary output always loads the whole input. */
+	if (options.binary && options.stream) {
+		fprintf(stderr, "--format=binary needs --input=map or --input=block.\n");
+		return 1;
+	}
+	if (options.split_size > 0 && options.stream) {
+		fprintf(stderr, "--split needs --input=map or --input=block.\n");
+		return 1;
+	}
+
+	char *standard_input[] = {"-"};
+	char **paths = first_file < argc ? argv + first_file : standard_input;
+	int num_paths = first_file < argc ? argc - first_file : 1;
+	if (first_file == argc && !options.binary && options.split_size == 0) {
+		/* Standard input is read as it arrives, as before. */
+		options.stream = 1;
+	}
+
+	ScannerRecordWriter records;
+	if (options.binary && scanner_record_writer_open(&records, stdout) != 0) {
+		fprintf(stderr, "Failed to start the token stream: %s\n", strerror(errno));
+		return 1;
+	}
+
+	int failures = 0;
+	if (options.split_size > 0 || (num_threads > 1 && num_paths > 1)) {
+		/* The header goes out first; each job's records follow in order. */
+		if (options.binary && scanner_record_writer_close(&records) != 0) {
+			fprintf(stderr, "Failed to write the token stream.\n");
+			return 1;
+		}
+		if (options.split_size > 0) {
+			for (int i = 0; i < num_paths; i++) {
+				failures += scan_file_split(paths[i], num_threads, &options) != 0;
+			}
+		} else {
+			failures = scan_files_in_parallel(paths, num_paths, num_threads < num_paths ? num_threads : num_paths, &options);
+		}
+		fflush(stdout);
+		return failures == 0 ? 0 : 1;
+	}
+
+	Scanner *scanner = scanner_create();
+	if (scanner == NULL) {
+		fprintf(stderr, "Failed to create the scanner.\n");
+		return 1;
+	}
+	for (int i = 0; i < num_paths; i++) {
+		failures += scan_file(scanner, paths[i], &options, stdout, options.binary ? &records : NULL) != 0;
+	}
+	if (options.binary && scanner_record_writer_close(&records) != 0) {
+		fprintf(stderr, "Failed to write the token stream.\n");
+		failures++;
+	}
+	scanner_destroy(scanner);
+	return failures == 0 ? 0 : 1;
 }
 
 const char *scanner_token_name(int token)
@@ -1,6 +1,10 @@
 #ifndef SCANNER_H
 #define SCANNER_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
 typedef enum ScannerToken {
 	TOK_EOF = 0,
 	TOK_ERROR = 256,
@@ -62,4 +66,140 @@ typedef enum ScannerToken {
 
 const char *scanner_token_name(int token);
 
+/* Returns the TOK_KW_* token the `length` bytes at `text` spell, or TOK_IDENTIFIER. */
+int scanner_keyword_token(const char *text, size_t length);
+
+/*
+ * A reentrant scanner. Each one holds its own flex state, so several threads
+ * can scan at once as long as each uses its own Scanner.
+ */
+typedef struct Scanner Scanner;
+
+typedef struct ScannerLexeme {
+	/*
+	 * First byte of the lexeme, NUL-terminated until the next call. It points
+	 * into the buffer given to scanner_set_buffer, or into flex's own buffer
+	 * for scanner_set_file.
+	 */
+	const char *text;
+	size_t length;
+	int line;
+} ScannerLexeme;
+
+/* Creates a scanner with no input; returns NULL when out of memory. */
+Scanner *scanner_create(void);
+
+/*
+ * Scans `length` bytes at `data` in place from line 1. data[length] and
+ * data[length + 1] must be NUL and the bytes must stay writable and alive
+ * while scanning. Returns 0, or -1 with errno set.
+ */
+int scanner_set_buffer(Scanner *scanner, char *data, size_t length);
+
+/* Scans an open file through flex's own buffer from line 1. Returns 0, or -1 with errno set. */
+int scanner_set_file(Scanner *scanner, FILE *file);
+
+/* Returns the next ScannerToken, TOK_EOF at the end, and fills `lexeme` when it is not NULL. */
+int scanner_next_token(Scanner *scanner, ScannerLexeme *lexeme);
+
+void scanner_destroy(Scanner *scanner);
+
+/*
+ * A whole source file held in memory for yy_scan_buffer: `length` bytes of
+ * source followed by the two NUL bytes flex needs at the end of a buffer.
+ * The bytes are writable, because flex briefly writes a NUL after each
+ * lexeme, but changes never reach the file.
+ */
+typedef struct ScannerInput {
+	char *data;
+	size_t length;
+	/* Size of the mapping when data is mapped, 0 when it was read into a heap block. */
+	size_t mapped_length;
+} ScannerInput;
+
+typedef enum ScannerInputMode {
+	/* Map the file (copy-on-write); falls back to SCANNER_INPUT_BLOCK where mapping is not possible. */
+	SCANNER_INPUT_MAP = 0,
+	/* Read the file into one heap block. */
+	SCANNER_INPUT_BLOCK
+} ScannerInputMode;
+
+/*
+ * Loads a file for in-place scanning; a path of "-" reads standard input.
+ * Pipes and other unmappable files are read into a block. Scan it with
+ *   scanner_set_buffer(scanner, input.data, input.length)
+ * and lexemes then point into input.data. Returns 0 on success and -1 with
+ * errno set on failure.
+ */
+int scanner_input_open(ScannerInput *input, const char *path, ScannerInputMode mode);
+
+/* Releases what scanner_input_open loaded; no scanner may still be scanning it. */
+void scanner_input_close(ScannerInput *input);
+
+/*
+ * Binary token stream, as written by `scanner_cli --format=binary`: a 16-byte
+ * header (the 8 bytes of SCANNER_RECORD_MAGIC, then the version and the record
+ * size as 32-bit values) followed by fixed-size records. All integers are
+ * little-endian. The records of each input file end with a TOK_EOF record
+ * whose offset is the file length.
+ */
+#define SCANNER_RECORD_MAGIC "SCANTOK\0"
+#define SCANNER_RECORD_VERSION 1u
+#define SCANNER_RECORD_SIZE 24u
+
+typedef struct ScannerTokenRecord {
+	/* Byte offset of the lexeme from the start of its file. */
+	uint64_t offset;
+	/* Lexeme length in bytes. */
+	uint32_t length;
+	/* 1-based line of the lexeme. */
+	uint32_t line;
+	/* A ScannerToken. */
+	uint32_t token;
+	/* Written as 0. */
+	uint32_t reserved;
+} ScannerTokenRecord;
+
+/* Encodes records into a large buffer and writes it out in blocks. */
+typedef struct ScannerRecordWriter {
+	FILE *file;
+	unsigned char *buffer;
+	size_t used;
+	size_t capacity;
+	int failed;
+} ScannerRecordWriter;
+
+/* Decodes records from a stream, a block at a time. */
+typedef struct ScannerRecordReader {
+	FILE *file;
+	unsigned char *buffer;
+	size_t used;
+	size_t position;
+	size_t capacity;
+} ScannerRecordReader;
+
+/* Starts a stream on an open binary file and buffers its header. Returns 0, or -1 with errno set. */
+int scanner_record_writer_open(ScannerRecordWriter *writer, FILE *file);
+
+/*
+ * Like scanner_record_writer_open without the header, for records that are
+ * later appended to a stream started elsewhere.
+ */
+int scanner_record_writer_attach(ScannerRecordWriter *writer, FILE *file);
+
+/* Appends one record. Returns 0, or -1 once a write has failed. */
+int scanner_record_write(ScannerRecordWriter *writer, const ScannerTokenRecord *record);
+
+/* Writes out what is buffered and frees the buffer; the file stays open. Returns 0, or -1 on a write error. */
+int scanner_record_writer_close(ScannerRecordWriter *writer);
+
+/* Checks the header of a stream. Returns 0, or -1 with errno EINVAL for a foreign or newer stream. */
+int scanner_record_reader_open(ScannerRecordReader *reader, FILE *file);
+
+/* Reads the next record. Returns 1, 0 at the end of the stream, or -1 with errno set on a read error or truncated stream. */
+int scanner_record_read(ScannerRecordReader *reader, ScannerTokenRecord *record);
+
+/* Frees the reader's buffer; the file stays open. */
+void scanner_record_reader_close(ScannerRecordReader *reader);
+
 #endif // SCANNER_H
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include <errno.h>
+#include <stdlib.h>
+
+#include "scanner.h"
+#include "scanner_flex.h"
+
+struct Scanner {
+	yyscan_t flex;
+};
+
+/*
+ * Starts the flex scanner afresh, so no start condition, line number or
+ * buffer is left over from the previous input.
+ */
+static int reset_scanner(Scanner *scanner)
+{
+	if (scanner->flex != NULL) {
+		yylex_destroy(scanner->flex);
+		scanner->flex = NULL;
+	}
+	if (yylex_init(&scanner->flex) != 0) {
+		scanner->flex = NULL;
+		errno = ENOMEM;
+		return -1;
+	}
+	return 0;
+}
+
+Scanner *scanner_create(void)
+{
+	Scanner *scanner = calloc(1, sizeof(*scanner));
+	if (scanner == NULL) {
+		return NULL;
+	}
+	if (reset_scanner(scanner) != 0) {
+		free(scanner);
+		return NULL;
+	}
+	return scanner;
+}
+
+int scanner_set_buffer(Scanner *scanner, char *data, size_t length)
+{
+	if (reset_scanner(scanner) != 0) {
+		return -1;
+	}
+	if (yy_scan_buffer(data, length + 2, scanner->flex) == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	/* yy_scan_buffer leaves the line of the new buffer unset. */
+	yyset_lineno(1, scanner->flex);
+	return 0;
+}
+
+int scanner_set_file(Scanner *scanner, FILE *file)
+{
+	if (reset_scanner(scanner) != 0) {
+		return -1;
+	}
+	yyrestart(file, scanner->flex);
+	yyset_lineno(1, scanner->flex);
+	return 0;
+}
+
+int scanner_next_token(Scanner *scanner, ScannerLexeme *lexeme)
+{
+	if (scanner->flex == NULL) {
+		return TOK_EOF;
+	}
+
+	int token = yylex(scanner->flex);
+	if (lexeme != NULL) {
+		lexeme->text = yyget_text(scanner->flex);
+		lexeme->length = (size_t)yyget_leng(scanner->flex);
+		lexeme->line = yyget_lineno(scanner->flex);
+	}
+	return token;
+}
+
+void scanner_destroy(Scanner *scanner)
+{
+	if (scanner == NULL) {
+		return;
+	}
+	if (scanner->flex != NULL) {
+		yylex_destroy(scanner->flex);
+	}
+	free(scanner);
+}
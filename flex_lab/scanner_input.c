@@ -0,0 +1,145 @@
+#if !defined(_WIN32)
+#define _DEFAULT_SOURCE
+#define SCANNER_INPUT_CAN_MAP 1
+#else
+#define SCANNER_INPUT_CAN_MAP 0
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if SCANNER_INPUT_CAN_MAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "scanner.h"
+
+#if SCANNER_INPUT_CAN_MAP
+/*
+ * Maps a regular file so that two NUL bytes follow its last byte. The whole
+ * range is first reserved as zeroed anonymous memory and the file is mapped
+ * over its start: the rest of the file's last page is zero-filled by the
+ * kernel, and any page after it is still the anonymous zeroes, so the NULs are
+ * there even when the file ends at a page boundary.
+ */
+static int map_file(ScannerInput *input, int fd, size_t length)
+{
+	size_t reserved = length + 2;
+	char *base = mmap(NULL, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) {
+		return -1;
+	}
+	if (mmap(base, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		int saved = errno;
+		munmap(base, reserved);
+		errno = saved;
+		return -1;
+	}
+
+	input->data = base;
+	input->length = length;
+	input->mapped_length = reserved;
+	return 0;
+}
+#endif
+
+/* Reads a file of any kind, pipes and "-" for standard input included, into one block with the two NULs after it. */
+static int read_block(ScannerInput *input, const char *path)
+{
+	int is_stdin = strcmp(path, "-") == 0;
+	FILE *file = is_stdin ? stdin : fopen(path, "rb");
+	if (file == NULL) {
+		return -1;
+	}
+
+	size_t capacity = 64 * 1024;
+	size_t length = 0;
+	char *data = malloc(capacity);
+	while (data != NULL) {
+		length += fread(data + length, 1, capacity - length - 2, file);
+		if (length < capacity - 2) {
+			break;
+		}
+		char *grown = realloc(data, capacity * 2);
+		if (grown == NULL) {
+			free(data);
+			data = NULL;
+			errno = ENOMEM;
+			break;
+		}
+		data = grown;
+		capacity *= 2;
+	}
+
+	if (data != NULL && ferror(file)) {
+		int saved = errno;
+		free(data);
+		data = NULL;
+		errno = saved != 0 ? saved : EIO;
+	}
+	if (!is_stdin) {
+		fclose(file);
+	}
+	if (data == NULL) {
+		return -1;
+	}
+
+	data[length] = '\0';
+	data[length + 1] = '\0';
+	input->data = data;
+	input->length = length;
+	input->mapped_length = 0;
+	return 0;
+}
+
+int scanner_input_open(ScannerInput *input, const char *path, ScannerInputMode mode)
+{
+	memset(input, 0, sizeof(*input));
+
+#if SCANNER_INPUT_CAN_MAP
+	if (mode == SCANNER_INPUT_MAP && strcmp(path, "-") != 0) {
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			return -1;
+		}
+
+		struct stat info;
+		int mapped = -1;
+		if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+			mapped = map_file(input, fd, (size_t)info.st_size);
+		}
+		close(fd);
+		if (mapped == 0) {
+			return 0;
+		}
+	}
+#else
+	(void)mode;
+#endif
+
+	return read_block(input, path);
+}
+
+void scanner_input_close(ScannerInput *input)
+{
+	if (input->data == NULL) {
+		return;
+	}
+
+#if SCANNER_INPUT_CAN_MAP
+	if (input->mapped_length > 0) {
+		munmap(input->data, input->mapped_length);
+	} else {
+		free(input->data);
+	}
+#else
+	free(input->data);
+#endif
+
+	memset(input, 0, sizeof(*input));
+}
@@ -0,0 +1,39 @@
+#include <string.h>
+
+#include "scanner.h"
+
+/*
+ * Keyword lookup for the {ID} rule of scanner.l, laid out like gperf output.
+ * The hash is the word length plus the weights of its first and last
+ * characters. keyword_table_gen searches the weights for the keywords listed
+ * in scanner_keywords.txt and writes them to scanner_keyword_table.h, with
+ * each keyword in its own slot of a table with one slot per keyword, or a few
+ * more when no such weights exist. An identifier therefore costs one hash and
+ * at most one memcmp. Characters that begin or end no keyword weigh
+ * MAX_HASH_VALUE + 1, so any word using them hashes past the table.
+ */
+typedef struct Keyword {
+	const char *name;
+	size_t length;
+	int token;
+} Keyword;
+
+#include "scanner_keyword_table.h"
+
+int scanner_keyword_token(const char *text, size_t length)
+{
+	if (length < MIN_WORD_LENGTH || length > MAX_WORD_LENGTH) {
+		return TOK_IDENTIFIER;
+	}
+
+	size_t hash = length + asso_values[(unsigned char)text[0]] + asso_values[(unsigned char)text[length - 1]];
+	if (hash < MIN_HASH_VALUE || hash > MAX_HASH_VALUE) {
+		return TOK_IDENTIFIER;
+	}
+
+	const Keyword *keyword = &keywords[hash - MIN_HASH_VALUE];
+	if (keyword->length == length && memcmp(text, keyword->name, length) == 0) {
+		return keyword->token;
+	}
+	return TOK_IDENTIFIER;
+}
@@ -0,0 +1,161 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scanner.h"
+
+#define RECORD_BUFFER_SIZE (1024 * 1024)
+#define HEADER_SIZE 16
+
+static void put_u32(unsigned char *bytes, uint32_t value)
+{
+	bytes[0] = (unsigned char)value;
+	bytes[1] = (unsigned char)(value >> 8);
+	bytes[2] = (unsigned char)(value >> 16);
+	bytes[3] = (unsigned char)(value >> 24);
+}
+
+static void put_u64(unsigned char *bytes, uint64_t value)
+{
+	put_u32(bytes, (uint32_t)value);
+	put_u32(bytes + 4, (uint32_t)(value >> 32));
+}
+
+static uint32_t get_u32(const unsigned char *bytes)
+{
+	return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static uint64_t get_u64(const unsigned char *bytes)
+{
+	return (uint64_t)get_u32(bytes) | (uint64_t)get_u32(bytes + 4) << 32;
+}
+
+/* Writes out the buffered bytes; remembers the first failure so later calls fail fast. */
+static int flush_writer(ScannerRecordWriter *writer)
+{
+	if (writer->failed) {
+		return -1;
+	}
+	if (writer->used > 0 && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used) {
+		writer->failed = 1;
+		return -1;
+	}
+	writer->used = 0;
+	return 0;
+}
+
+int scanner_record_writer_attach(ScannerRecordWriter *writer, FILE *file)
+{
+	memset(writer, 0, sizeof(*writer));
+	writer->buffer = malloc(RECORD_BUFFER_SIZE);
+	if (writer->buffer == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	writer->file = file;
+	writer->capacity = RECORD_BUFFER_SIZE;
+	return 0;
+}
+
+int scanner_record_writer_open(ScannerRecordWriter *writer, FILE *file)
+{
+	if (scanner_record_writer_attach(writer, file) != 0) {
+		return -1;
+	}
+
+	memcpy(writer->buffer, SCANNER_RECORD_MAGIC, 8);
+	put_u32(writer->buffer + 8, SCANNER_RECORD_VERSION);
+	put_u32(writer->buffer + 12, SCANNER_RECORD_SIZE);
+	writer->used = HEADER_SIZE;
+	return 0;
+}
+
+int scanner_record_write(ScannerRecordWriter *writer, const ScannerTokenRecord *record)
+{
+	if (writer->used + SCANNER_RECORD_SIZE > writer->capacity && flush_writer(writer) != 0) {
+		return -1;
+	}
+
+	unsigned char *bytes = writer->buffer + writer->used;
+	put_u64(bytes, record->offset);
+	put_u32(bytes + 8, record->length);
+	put_u32(bytes + 12, record->line);
+	put_u32(bytes + 16, record->token);
+	put_u32(bytes + 20, 0);
+	writer->used += SCANNER_RECORD_SIZE;
+	return 0;
+}
+
+int scanner_record_writer_close(ScannerRecordWriter *writer)
+{
+	int result = flush_writer(writer) == 0 && fflush(writer->file) == 0 ? 0 : -1;
+	free(writer->buffer);
+	memset(writer, 0, sizeof(*writer));
+	return result;
+}
+
+int scanner_record_reader_open(ScannerRecordReader *reader, FILE *file)
+{
+	memset(reader, 0, sizeof(*reader));
+
+	unsigned char header[HEADER_SIZE];
+	if (fread(header, 1, HEADER_SIZE, file) != HEADER_SIZE) {
+		errno = ferror(file) ? EIO : EINVAL;
+		return -1;
+	}
+	if (memcmp(header, SCANNER_RECORD_MAGIC, 8) != 0 || get_u32(header + 8) != SCANNER_RECORD_VERSION ||
+		get_u32(header + 12) != SCANNER_RECORD_SIZE) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	reader->buffer = malloc(RECORD_BUFFER_SIZE);
+	if (reader->buffer == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	reader->file = file;
+	reader->capacity = RECORD_BUFFER_SIZE;
+	return 0;
+}
+
+int scanner_record_read(ScannerRecordReader *reader, ScannerTokenRecord *record)
+{
+	if (reader->position + SCANNER_RECORD_SIZE > reader->used) {
+		/* Keep a partial record, then refill behind it. */
+		size_t left = reader->used - reader->position;
+		memmove(reader->buffer, reader->buffer + reader->position, left);
+		reader->used = left + fread(reader->buffer + left, 1, reader->capacity - left, reader->file);
+		reader->position = 0;
+
+		if (reader->used < SCANNER_RECORD_SIZE) {
+			if (ferror(reader->file)) {
+				errno = EIO;
+				return -1;
+			}
+			if (reader->used > 0) {
+				/* The stream ends inside a record. */
+				errno = EINVAL;
+				return -1;
+			}
+			return 0;
+		}
+	}
+
+	const unsigned char *bytes = reader->buffer + reader->position;
+	record->offset = get_u64(bytes);
+	record->length = get_u32(bytes + 8);
+	record->line = get_u32(bytes + 12);
+	record->token = get_u32(bytes + 16);
+	record->reserved = 0;
+	reader->position += SCANNER_RECORD_SIZE;
+	return 1;
+}
+
+void scanner_record_reader_close(ScannerRecordReader *reader)
+{
+	free(reader->buffer);
+	memset(reader, 0, sizeof(*reader));
+}
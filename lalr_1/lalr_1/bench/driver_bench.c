@@ -0,0 +1,718 @@
+#include "grammar.h"
+#include "automaton.h"
+#include "parser.h"
+#include "push_parser.h"
+#include "token_map.h"
+#include "token_pipeline.h"
+#include "scanner.h"
+#include "scanner_flex.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+// Largest generated source, in MiB.
+#define MAX_SOURCE_MIB 1024
+#define NUM_IDENTIFIERS 64
+#define NUM_FUNCTIONS 16
+
+typedef enum driver_stage
+{
+    // yylex only.
+    STAGE_SCAN = 0,
+    // yylex and map_lexer_token_to_terminal_id, building the driver's token record.
+    STAGE_MAP,
+    // The full driver loop: the mapped tokens are fed to a push_parser without tracing.
+    STAGE_PARSE,
+    // The same loop with --pipeline: a scanner thread lexes and maps into the token ring.
+    STAGE_PIPELINED,
+    STAGE_COUNT
+} driver_stage;
+
+static const char *const stage_names[STAGE_COUNT] = {"scan", "scan_map", "scan_map_parse", "pipelined_parse"};
+
+typedef struct source_buffer
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+    uint64_t random_state;
+} source_buffer;
+
+typedef struct stage_result
+{
+    double seconds;
+    long tokens;
+    // Every token was lexed (and mapped) without error and, when parsing, the input was accepted.
+    bool accepted;
+} stage_result;
+
+/**
+ * @brief Reads a whole file into a null-terminated buffer.
+ * @param path File path.
+ * @return Allocated buffer, or NULL on I/O or allocation error.
+ */
+static char *read_file_all(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    if (fseek(file, 0, SEEK_END) != 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    long length = ftell(file);
+    if (length < 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    char *buffer = (char *)malloc((size_t)length + 1);
+    if (buffer == NULL)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    size_t read_count = fread(buffer, 1, (size_t)length, file);
+    fclose(file);
+    if (read_count != (size_t)length)
+    {
+        free(buffer);
+        return NULL;
+    }
+
+    buffer[length] = '\0';
+    return buffer;
+}
+
+/**
+ * @brief Reads the wall clock in seconds.
+ * @return Current time in seconds.
+ */
+static double now_seconds(void)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Draws the next number of the generator's xorshift sequence.
+ * @param source Generator state.
+ * @param bound Exclusive upper bound, at least 1.
+ * @return Number in [0, bound).
+ */
+static unsigned pick(source_buffer *source, unsigned bound)
+{
+    uint64_t x = source->random_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    source->random_state = x;
+    return (unsigned)(x % bound);
+}
+
+/**
+ * @brief Appends text to the generated source; the buffer was sized up front.
+ * @param source Destination.
+ * @param text Text to append.
+ * @return This function does not return a value.
+ */
+static void emit(source_buffer *source, const char *text)
+{
+    size_t length = strlen(text);
+    if (source->length + length + 2 > source->capacity)
+    {
+        return;
+    }
+    memcpy(source->data + source->length, text, length);
+    source->length += length;
+}
+
+/**
+ * @brief Appends one small integer as decimal text.
+ * @param source Destination.
+ * @param prefix Text written before the number (an identifier stem, or "").
+ * @param value Number to write.
+ * @return This function does not return a value.
+ */
+static void emit_number(source_buffer *source, const char *prefix, unsigned value)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%s%u", prefix, value);
+    emit(source, text);
+}
+
+/**
+ * @brief Appends a random expression of the C subset.
+ * @param source Destination.
+ * @param depth Remaining nesting; 0 only emits primaries.
+ * @return This function does not return a value.
+ */
+static void emit_expression(source_buffer *source, int depth)
+{
+    static const char *const binary_operators[] = {
+        " + ", " - ", " * ", " / ", " % ", " < ", " <= ", " > ", " >= ", " == ", " != ", " && ", " || "};
+
+    unsigned shape = depth > 0 ? pick(source, 10) : pick(source, 5);
+    switch (shape)
+    {
+    case 0:
+    case 1:
+        emit_number(source, "value_", pick(source, NUM_IDENTIFIERS));
+        break;
+    case 2:
+        emit_number(source, "", pick(source, 100000));
+        break;
+    case 3:
+        emit_number(source, "", pick(source, 1000));
+        emit(source, ".25");
+        break;
+    case 4:
+        emit(source, pick(source, 2) == 0 ? "'c'" : "\"text\"");
+        break;
+    case 5:
+    case 6:
+        emit_expression(source, depth - 1);
+        emit(source, binary_operators[pick(source, sizeof(binary_operators) / sizeof(binary_operators[0]))]);
+        emit_expression(source, depth - 1);
+        break;
+    case 7:
+        emit(source, "(");
+        emit_expression(source, depth - 1);
+        emit(source, ")");
+        break;
+    case 8:
+        emit_number(source, "table_", pick(source, NUM_IDENTIFIERS));
+        emit(source, "[");
+        emit_expression(source, depth - 1);
+        emit(source, "]");
+        break;
+    default:
+        emit_number(source, "function_", pick(source, NUM_FUNCTIONS));
+        emit(source, "(");
+        emit_expression(source, depth - 1);
+        emit(source, ", ");
+        emit_expression(source, depth - 1);
+        emit(source, ")");
+        break;
+    }
+}
+
+/**
+ * @brief Appends a random statement of the C subset.
+ * @param source Destination.
+ * @param depth Remaining block nesting.
+ * @return This function does not return a value.
+ */
+static void emit_statement(source_buffer *source, int depth)
+{
+    unsigned shape = depth > 0 ? pick(source, 9) : pick(source, 5);
+    switch (shape)
+    {
+    case 0:
+        emit_number(source, "    int local_", pick(source, NUM_IDENTIFIERS));
+        emit(source, " = ");
+        emit_expression(source, 2);
+        emit(source, ";\n");
+        break;
+    case 1:
+        emit_number(source, "    value_", pick(source, NUM_IDENTIFIERS));
+        emit(source, pick(source, 2) == 0 ? " = " : " += ");
+        emit_expression(source, 3);
+        emit(source, ";\n");
+        break;
+    case 2:
+        emit_number(source, "    function_", pick(source, NUM_FUNCTIONS));
+        emit(source, "(");
+        emit_expression(source, 2);
+        emit(source, ", \"argument\");\n");
+        break;
+    case 3:
+        emit_number(source, "    value_", pick(source, NUM_IDENTIFIERS));
+        emit(source, "++; // counter\n");
+        break;
+    case 4:
+        emit(source, "    /* checked below */ table_0[value_1] -= ");
+        emit_expression(source, 1);
+        emit(source, ";\n");
+        break;
+    case 5:
+    case 6:
+        emit(source, "    if (");
+        emit_expression(source, 2);
+        emit(source, ") {\n");
+        emit_statement(source, depth - 1);
+        emit(source, "    } else {\n");
+        emit_statement(source, depth - 1);
+        emit(source, "    }\n");
+        break;
+    case 7:
+        emit(source, "    while (");
+        emit_expression(source, 2);
+        emit(source, ") {\n");
+        emit_statement(source, depth - 1);
+        emit(source, "    }\n");
+        break;
+    default:
+        emit(source, "    for (index = 0; index < ");
+        emit_number(source, "", pick(source, 1000));
+        emit(source, "; index++) {\n");
+        emit_statement(source, depth - 1);
+        emit(source, "    }\n");
+        break;
+    }
+}
+
+/**
+ * @brief Generates a C-subset source accepted by examples/grammar_c_subset.txt.
+ *
+ * Functions of random statements are emitted until the target size is reached.
+ * The buffer ends with the two NUL bytes yy_scan_buffer needs. The same seed
+ * always gives the same source.
+ *
+ * @param target_bytes Approximate source size.
+ * @param seed Non-zero seed of the statement generator.
+ * @param out_source Output buffer; its length excludes the trailing NULs.
+ * @return true on success, false on allocation error.
+ */
+static bool generate_source(size_t target_bytes, uint64_t seed, source_buffer *out_source)
+{
+    // The last function may overshoot the target by one function body.
+    const size_t slack = 64 * 1024;
+
+    memset(out_source, 0, sizeof(*out_source));
+    out_source->capacity = target_bytes + slack;
+    out_source->data = (char *)malloc(out_source->capacity);
+    if (out_source->data == NULL)
+    {
+        return false;
+    }
+    out_source->random_state = seed;
+
+    emit(out_source, "int index;\nint table_0[64];\nfloat scale = 0.5;\n");
+    unsigned function_id = 0;
+    while (out_source->length < target_bytes)
+    {
+        emit_number(out_source, "int function_", function_id++ % NUM_FUNCTIONS);
+        emit(out_source, "(int value_0, float value_1) {\n");
+        int statements = 4 + (int)pick(out_source, 12);
+        for (int i = 0; i < statements; i++)
+        {
+            emit_statement(out_source, 2);
+        }
+        emit(out_source, "    return value_0;\n}\n\n");
+    }
+
+    out_source->data[out_source->length] = '\0';
+    out_source->data[out_source->length + 1] = '\0';
+    return true;
+}
+
+/**
+ * @brief Runs the full driver loop with the tokens taken from a token_pipeline.
+ * @param g Parsed grammar, used by the scanner thread to map tokens.
+ * @param table Conflict-free parser table.
+ * @param scanner Scanner already reading the source; the pipeline's thread lexes it.
+ * @param out_result Output timing and token count.
+ * @return true on success, false when the parser or the scanner thread could not be created.
+ */
+static bool run_pipelined_parse(const grammar *g, const parser_table *table, yyscan_t scanner, stage_result *out_result)
+{
+    push_parser *parser = create_push_parser(table);
+    if (parser == NULL)
+    {
+        return false;
+    }
+
+    // Starting the thread is part of what --pipeline costs, so it is timed.
+    double started = now_seconds();
+    token_pipeline *pipeline = start_token_pipeline(g, scanner);
+    if (pipeline == NULL)
+    {
+        free_push_parser(parser);
+        return false;
+    }
+
+    long tokens = 0;
+    bool ok = true;
+    push_parser_status status = PUSH_PARSER_NEED_MORE;
+    while (status == PUSH_PARSER_NEED_MORE)
+    {
+        token_stream token;
+        if (!token_pipeline_next(pipeline, &token))
+        {
+            ok = false;
+            break;
+        }
+        if (token.lexer_token != TOK_EOF)
+        {
+            tokens++;
+        }
+        status = push_parser_feed(parser, token.terminal_id, token.lexeme);
+    }
+    stop_token_pipeline(pipeline);
+    out_result->seconds = now_seconds() - started;
+    out_result->tokens = tokens;
+    out_result->accepted = ok && status == PUSH_PARSER_ACCEPT;
+
+    free_push_parser(parser);
+    return true;
+}
+
+/**
+ * @brief Runs one pipeline stage over an in-memory source and times it.
+ *
+ * Tokens are read with yylex from yy_scan_buffer, mapped and fed to the push
+ * parser exactly as the command line driver does with tracing off; later stages
+ * are simply left out.
+ *
+ * @param g Parsed grammar.
+ * @param table Conflict-free parser table.
+ * @param source Generated source; scanned in place and left unchanged.
+ * @param stage Last stage to run.
+ * @param out_result Output timing and token count.
+ * @return true on success, false when the scanner or parser could not be created.
+ */
+static bool run_stage(
+    const grammar *g,
+    const parser_table *table,
+    source_buffer *source,
+    driver_stage stage,
+    stage_result *out_result)
+{
+    memset(out_result, 0, sizeof(*out_result));
+
+    yyscan_t scanner = NULL;
+    if (yylex_init(&scanner) != 0)
+    {
+        return false;
+    }
+    YY_BUFFER_STATE buffer = yy_scan_buffer(source->data, source->length + 2, scanner);
+    if (buffer != NULL && stage == STAGE_PIPELINED)
+    {
+        bool started = run_pipelined_parse(g, table, scanner, out_result);
+        yy_delete_buffer(buffer, scanner);
+        yylex_destroy(scanner);
+        return started;
+    }
+    push_parser *parser = stage == STAGE_PARSE ? create_push_parser(table) : NULL;
+    if (buffer == NULL || (stage == STAGE_PARSE && parser == NULL))
+    {
+        free_push_parser(parser);
+        yylex_destroy(scanner);
+        return false;
+    }
+
+    long tokens = 0;
+    bool ok = true;
+    push_parser_status status = PUSH_PARSER_NEED_MORE;
+    double started = now_seconds();
+    while (true)
+    {
+        int lexer_token = yylex(scanner);
+        if (lexer_token == TOK_ERROR)
+        {
+            ok = false;
+            break;
+        }
+        if (lexer_token != TOK_EOF)
+        {
+            tokens++;
+        }
+
+        if (stage != STAGE_SCAN)
+        {
+            const char *text = yyget_text(scanner);
+            const char *lexeme = text != NULL ? text : "";
+            int terminal_id = map_lexer_token_to_terminal_id(g, lexer_token, lexeme);
+            int line = yyget_lineno(scanner);
+            if (terminal_id < 0 || line < 0)
+            {
+                ok = false;
+                break;
+            }
+
+            if (stage == STAGE_PARSE)
+            {
+                status = push_parser_feed(parser, terminal_id, lexeme);
+                if (status != PUSH_PARSER_NEED_MORE)
+                {
+                    break;
+                }
+                continue;
+            }
+        }
+
+        if (lexer_token == TOK_EOF)
+        {
+            break;
+        }
+    }
+    out_result->seconds = now_seconds() - started;
+    out_result->tokens = tokens;
+    out_result->accepted = ok && (stage != STAGE_PARSE || status == PUSH_PARSER_ACCEPT);
+
+    free_push_parser(parser);
+    yy_delete_buffer(buffer, scanner);
+    yylex_destroy(scanner);
+    return true;
+}
+
+/**
+ * @brief Benchmarks one source size and writes its JSON object.
+ *
+ * Each stage runs `repeat` times and the fastest run counts. Map and parse costs
+ * are the differences between the first three stages; the pipelined stage is
+ * compared with the full synchronous loop.
+ *
+ * @param out JSON destination.
+ * @param g Parsed grammar.
+ * @param table Conflict-free parser table.
+ * @param size_mib Source size in MiB.
+ * @param repeat Runs per stage.
+ * @return true when every stage ran and the source was accepted.
+ */
+static bool bench_size(FILE *out, const grammar *g, const parser_table *table, int size_mib, int repeat)
+{
+    double generate_started = now_seconds();
+    source_buffer source;
+    if (!generate_source((size_t)size_mib * 1024 * 1024, 0x9e3779b97f4a7c15ULL, &source))
+    {
+        fprintf(stderr, "Failed to allocate a %d MiB source.\n", size_mib);
+        fprintf(out, "    {\n      \"size_mib\": %d,\n      \"error\": \"out of memory\"\n    }", size_mib);
+        return false;
+    }
+    double generate_seconds = now_seconds() - generate_started;
+
+    stage_result best[STAGE_COUNT];
+    bool ok = true;
+    for (int stage = 0; stage < STAGE_COUNT && ok; stage++)
+    {
+        for (int run = 0; run < repeat; run++)
+        {
+            stage_result result;
+            if (!run_stage(g, table, &source, (driver_stage)stage, &result))
+            {
+                ok = false;
+                break;
+            }
+            if (run == 0 || result.seconds < best[stage].seconds)
+            {
+                best[stage] = result;
+            }
+        }
+    }
+    free(source.data);
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to create the scanner or parser.\n");
+        fprintf(out, "    {\n      \"size_mib\": %d,\n      \"error\": \"driver setup failed\"\n    }", size_mib);
+        return false;
+    }
+
+    const double bytes = (double)source.length;
+    const double tokens = (double)best[STAGE_PARSE].tokens;
+    double split[STAGE_COUNT];
+    split[STAGE_SCAN] = best[STAGE_SCAN].seconds;
+    split[STAGE_MAP] = best[STAGE_MAP].seconds - best[STAGE_SCAN].seconds;
+    split[STAGE_PARSE] = best[STAGE_PARSE].seconds - best[STAGE_MAP].seconds;
+    const double total = best[STAGE_PARSE].seconds > 0.0 ? best[STAGE_PARSE].seconds : 1e-9;
+
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"size_mib\": %d,\n", size_mib);
+    fprintf(out, "      \"bytes\": %zu,\n", source.length);
+    fprintf(out, "      \"tokens\": %ld,\n", best[STAGE_PARSE].tokens);
+    fprintf(out, "      \"accepted\": %s,\n", best[STAGE_PARSE].accepted ? "true" : "false");
+    fprintf(out, "      \"generate_seconds\": %.6f,\n", generate_seconds);
+    fprintf(out, "      \"seconds\": {\n");
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        fprintf(out, "        \"%s\": %.6f%s\n", stage_names[stage], best[stage].seconds, stage + 1 < STAGE_COUNT ? "," : "");
+    }
+    fprintf(out, "      },\n");
+    fprintf(out, "      \"split_percent\": {\n");
+    fprintf(out, "        \"scan\": %.1f,\n", 100.0 * split[STAGE_SCAN] / total);
+    fprintf(out, "        \"map\": %.1f,\n", 100.0 * split[STAGE_MAP] / total);
+    fprintf(out, "        \"parse\": %.1f\n", 100.0 * split[STAGE_PARSE] / total);
+    fprintf(out, "      },\n");
+    fprintf(out, "      \"tokens_per_second\": %.0f,\n", tokens / total);
+    fprintf(out, "      \"bytes_per_second\": %.0f,\n", bytes / total);
+    fprintf(out, "      \"scan_tokens_per_second\": %.0f,\n",
+            best[STAGE_SCAN].seconds > 0.0 ? tokens / best[STAGE_SCAN].seconds : 0.0);
+    fprintf(out, "      \"scan_bytes_per_second\": %.0f,\n",
+            best[STAGE_SCAN].seconds > 0.0 ? bytes / best[STAGE_SCAN].seconds : 0.0);
+    fprintf(out, "      \"pipeline_speedup\": %.2f\n",
+            best[STAGE_PIPELINED].seconds > 0.0 ? best[STAGE_PARSE].seconds / best[STAGE_PIPELINED].seconds : 0.0);
+    fprintf(out, "    }");
+
+    if (!best[STAGE_PARSE].accepted || !best[STAGE_PIPELINED].accepted)
+    {
+        fprintf(stderr, "The %d MiB source was rejected; is the grammar grammar_c_subset.txt?\n", size_mib);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a comma-separated list of source sizes in MiB.
+ * @param text List such as "1,16,64".
+ * @param out_sizes Output array, allocated.
+ * @param out_count Output number of sizes.
+ * @return true on success, false on a malformed list.
+ */
+static bool parse_sizes(const char *text, int **out_sizes, int *out_count)
+{
+    int count = 1;
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        if (*c == ',')
+        {
+            count++;
+        }
+    }
+
+    int *sizes = (int *)malloc((size_t)count * sizeof(int));
+    if (sizes == NULL)
+    {
+        return false;
+    }
+
+    const char *cursor = text;
+    for (int i = 0; i < count; i++)
+    {
+        char *end = NULL;
+        errno = 0;
+        long value = strtol(cursor, &end, 10);
+        if (errno != 0 || end == cursor || value < 1 || value > MAX_SOURCE_MIB || (*end != ',' && *end != '\0'))
+        {
+            free(sizes);
+            return false;
+        }
+        sizes[i] = (int)value;
+        cursor = end + 1;
+    }
+
+    *out_sizes = sizes;
+    *out_count = count;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *output_path = NULL;
+    const char *grammar_path = NULL;
+    int repeat = 1;
+    int *sizes = NULL;
+    int num_sizes = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--output=", 9) == 0)
+        {
+            output_path = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--repeat=", 9) == 0)
+        {
+            repeat = atoi(argv[i] + 9);
+        }
+        else if (strncmp(argv[i], "--sizes=", 8) == 0)
+        {
+            free(sizes);
+            if (!parse_sizes(argv[i] + 8, &sizes, &num_sizes))
+            {
+                fprintf(stderr, "Invalid --sizes list '%s' (MiB, 1 to %d).\n", argv[i] + 8, MAX_SOURCE_MIB);
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--", 2) == 0 || grammar_path != NULL)
+        {
+            fprintf(stderr, "Unknown option '%s'.\n", argv[i]);
+            free(sizes);
+            return 1;
+        }
+        else
+        {
+            grammar_path = argv[i];
+        }
+    }
+
+    if (repeat < 1 || grammar_path == NULL)
+    {
+        fprintf(stderr, "Usage: %s [--output=report.json] [--repeat=N] [--sizes=MIB1,MIB2,...] grammar_file\n", argv[0]);
+        free(sizes);
+        return 1;
+    }
+    if (num_sizes == 0)
+    {
+        static const int default_sizes[] = {1, 16, 64};
+        num_sizes = (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+        sizes = (int *)malloc(sizeof(default_sizes));
+        if (sizes == NULL)
+        {
+            return 1;
+        }
+        memcpy(sizes, default_sizes, sizeof(default_sizes));
+    }
+
+    char *grammar_text = read_file_all(grammar_path);
+    grammar *g = grammar_text != NULL ? create_grammar(grammar_text) : NULL;
+    free(grammar_text);
+    lalr1_automaton *automaton = g != NULL ? build_lalr1_automaton(g) : NULL;
+    parser_table *table = automaton != NULL ? build_lalr1_parser_table(g, automaton) : NULL;
+    if (table == NULL || table->has_conflicts)
+    {
+        fprintf(stderr, "Failed to build a conflict-free table from '%s'.\n", grammar_path);
+        free_parser_table(table);
+        free_lalr1_automaton(automaton);
+        free_grammar(g);
+        free(sizes);
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (output_path != NULL)
+    {
+        out = fopen(output_path, "w");
+        if (out == NULL)
+        {
+            fprintf(stderr, "Failed to open '%s': %s\n", output_path, strerror(errno));
+            free_parser_table(table);
+            free_lalr1_automaton(automaton);
+            free_grammar(g);
+            free(sizes);
+            return 1;
+        }
+    }
+
+    int failures = 0;
+    fprintf(out, "{\n  \"benchmark\": \"driver_throughput\",\n  \"repeat\": %d,\n  \"sources\": [\n", repeat);
+    for (int i = 0; i < num_sizes; i++)
+    {
+        fprintf(out, i == 0 ? "" : ",\n");
+        fprintf(stderr, "Benchmarking a %d MiB source\n", sizes[i]);
+        if (!bench_size(out, g, table, sizes[i], repeat))
+        {
+            failures++;
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+    {
+        fclose(out);
+        printf("Benchmark report written to %s\n", output_path);
+    }
+
+    free_parser_table(table);
+    free_lalr1_automaton(automaton);
+    free_grammar(g);
+    free(sizes);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,635 @@
+#include "grammar.h"
+#include "automaton.h"
+#include "parser.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct text_buffer
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+} text_buffer;
+
+typedef struct bench_result
+{
+    automaton_profile profile;
+    double table_seconds;
+    double total_seconds;
+    int num_conflicts;
+    // malloc/calloc/realloc calls made while generating, or -1 when they are not counted.
+    long heap_calls;
+    // Requests served by the LALR(1) automaton region and the heap blocks behind them.
+    size_t region_allocations;
+    size_t region_blocks;
+    size_t region_bytes;
+} bench_result;
+
+#ifdef BENCH_COUNT_HEAP_CALLS
+// The build links with --wrap=malloc,calloc,realloc, so every heap call made by the
+// grammar, automaton and table code goes through these counters first.
+static long heap_call_count;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *memory, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    heap_call_count++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    heap_call_count++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *memory, size_t size)
+{
+    heap_call_count++;
+    return __real_realloc(memory, size);
+}
+
+/**
+ * @brief Reads the number of heap calls made so far.
+ * @return Call count.
+ */
+static long heap_calls(void)
+{
+    return heap_call_count;
+}
+#else
+static long heap_calls(void)
+{
+    return -1;
+}
+#endif
+
+/**
+ * @brief Reads a whole file into a null-terminated buffer.
+ * @param path File path.
+ * @return Allocated buffer, or NULL on I/O or allocation error.
+ */
+static char *read_file_all(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    if (fseek(file, 0, SEEK_END) != 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    long length = ftell(file);
+    if (length < 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    char *buffer = (char *)malloc((size_t)length + 1);
+    if (buffer == NULL)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    size_t read_count = fread(buffer, 1, (size_t)length, file);
+    fclose(file);
+    if (read_count != (size_t)length)
+    {
+        free(buffer);
+        return NULL;
+    }
+
+    buffer[length] = '\0';
+    return buffer;
+}
+
+/**
+ * @brief Appends printf-style text to a growable buffer.
+ * @param buffer Destination buffer.
+ * @param format printf-style format.
+ * @return true on success, false on allocation error.
+ */
+static bool append_text(text_buffer *buffer, const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    int needed = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (needed < 0)
+    {
+        return false;
+    }
+
+    if (buffer->length + (size_t)needed + 1 > buffer->capacity)
+    {
+        size_t new_capacity = buffer->capacity == 0 ? 4096 : buffer->capacity;
+        while (buffer->length + (size_t)needed + 1 > new_capacity)
+        {
+            new_capacity *= 2;
+        }
+
+        char *resized = (char *)realloc(buffer->data, new_capacity);
+        if (resized == NULL)
+        {
+            return false;
+        }
+        buffer->data = resized;
+        buffer->capacity = new_capacity;
+    }
+
+    va_start(args, format);
+    vsnprintf(buffer->data + buffer->length, buffer->capacity - buffer->length, format, args);
+    va_end(args);
+    buffer->length += (size_t)needed;
+    return true;
+}
+
+/**
+ * @brief Generates a C-like grammar whose size grows linearly with scale.
+ *
+ * Every scale step adds one binary precedence level with two operators, one
+ * prefix, postfix and assignment operator, one looping and one jump statement
+ * keyword, one type keyword and one declaration qualifier (about 11 productions).
+ * Scale 16 is about the size of the ANSI C grammar: roughly 200 productions and
+ * 16 precedence levels.
+ *
+ * @param scale Size factor, at least 1.
+ * @return Allocated grammar text, or NULL on allocation error.
+ */
+static char *generate_synthetic_grammar(int scale)
+{
+    text_buffer nt = {0};
+    text_buffer t = {0};
+    text_buffer p = {0};
+    bool ok = true;
+
+    ok = ok && append_text(&nt, "Non-terminals: Program Unit Top Function Items Item Stmt Decl Type Decls Declarator");
+    ok = ok && append_text(&nt, " Expr Unary Postfix Primary Args");
+    ok = ok && append_text(&t, "Terminals: id num str ; , ( ) { } [ ] = . return");
+
+    ok = ok && append_text(&p, "Program -> Unit\n");
+    ok = ok && append_text(&p, "Unit -> Top\nUnit -> Unit Top\n");
+    ok = ok && append_text(&p, "Top -> Function\nTop -> Decl\n");
+    ok = ok && append_text(&p, "Function -> Type id ( ) { Items }\nFunction -> Type id ( ) { }\n");
+    ok = ok && append_text(&p, "Items -> Item\nItems -> Items Item\n");
+    ok = ok && append_text(&p, "Item -> Decl\nItem -> Stmt\n");
+    ok = ok && append_text(&p, "Stmt -> Expr ;\nStmt -> ;\nStmt -> { Items }\nStmt -> { }\n");
+    ok = ok && append_text(&p, "Stmt -> return Expr ;\nStmt -> return ;\n");
+    ok = ok && append_text(&p, "Decl -> Type Decls ;\n");
+    ok = ok && append_text(&p, "Decls -> Declarator\nDecls -> Decls , Declarator\n");
+    ok = ok && append_text(&p, "Declarator -> id\nDeclarator -> id = Expr\nDeclarator -> id [ num ]\n");
+    ok = ok && append_text(&p, "Expr -> E0\nExpr -> Unary = Expr\n");
+    ok = ok && append_text(&p, "Unary -> Postfix\n");
+    ok = ok && append_text(&p, "Postfix -> Primary\nPostfix -> Postfix [ Expr ]\nPostfix -> Postfix ( )\n");
+    ok = ok && append_text(&p, "Postfix -> Postfix ( Args )\nPostfix -> Postfix . id\n");
+    ok = ok && append_text(&p, "Args -> Expr\nArgs -> Args , Expr\n");
+    ok = ok && append_text(&p, "Primary -> id\nPrimary -> num\nPrimary -> str\nPrimary -> ( Expr )\n");
+
+    for (int i = 0; i < scale && ok; i++)
+    {
+        const char *next = "Unary";
+        char next_level[32];
+        if (i + 1 < scale)
+        {
+            snprintf(next_level, sizeof(next_level), "E%d", i + 1);
+            next = next_level;
+        }
+
+        ok = ok && append_text(&nt, " E%d", i);
+        ok = ok && append_text(&t, " b%d_0 b%d_1 u%d p%d a%d w%d j%d t%d q%d", i, i, i, i, i, i, i, i, i);
+        ok = ok && append_text(&p, "E%d -> E%d b%d_0 %s\nE%d -> E%d b%d_1 %s\nE%d -> %s\n",
+                               i, i, i, next, i, i, i, next, i, next);
+        ok = ok && append_text(&p, "Unary -> u%d Unary\n", i);
+        ok = ok && append_text(&p, "Postfix -> Postfix p%d\n", i);
+        ok = ok && append_text(&p, "Expr -> Unary a%d Expr\n", i);
+        ok = ok && append_text(&p, "Stmt -> w%d ( Expr ) Stmt\n", i);
+        ok = ok && append_text(&p, "Stmt -> j%d ;\n", i);
+        ok = ok && append_text(&p, "Type -> t%d\n", i);
+        ok = ok && append_text(&p, "Decl -> q%d Type Decls ;\n", i);
+    }
+
+    text_buffer grammar_text = {0};
+    ok = ok && append_text(&grammar_text, "%s\n%s\n%s", nt.data, t.data, p.data);
+
+    free(nt.data);
+    free(t.data);
+    free(p.data);
+    if (!ok)
+    {
+        free(grammar_text.data);
+        return NULL;
+    }
+
+    return grammar_text.data;
+}
+
+/**
+ * @brief Writes a JSON string literal for a grammar name.
+ * @param out Destination.
+ * @param name Name to quote; backslashes and quotes are escaped.
+ * @return This function does not return a value.
+ */
+static void write_json_name(FILE *out, const char *name)
+{
+    fputc('"', out);
+    for (const char *cursor = name; *cursor != '\0'; cursor++)
+    {
+        if (*cursor == '\\' || *cursor == '"')
+        {
+            fputc('\\', out);
+        }
+        fputc(*cursor, out);
+    }
+    fputc('"', out);
+}
+
+/**
+ * @brief Reads the wall clock in seconds.
+ * @return Current time in seconds.
+ */
+static double now_seconds(void)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Builds the automaton and table once and times every phase.
+ * @param g Parsed grammar.
+ * @param out_result Output timings and counts.
+ * @return true on success, false when generation failed.
+ */
+static bool run_generation(const grammar *g, bench_result *out_result)
+{
+    memset(out_result, 0, sizeof(*out_result));
+
+    long heap_calls_before = heap_calls();
+    double started = now_seconds();
+    lalr1_automaton *automaton = build_lalr1_automaton_profiled(g, &out_result->profile);
+    if (automaton == NULL)
+    {
+        return false;
+    }
+
+    double table_started = now_seconds();
+    parser_table *table = build_lalr1_parser_table(g, automaton);
+    double finished = now_seconds();
+    if (table == NULL)
+    {
+        free_lalr1_automaton(automaton);
+        return false;
+    }
+
+    out_result->table_seconds = finished - table_started;
+    out_result->total_seconds = finished - started;
+    out_result->num_conflicts = table->num_conflicts;
+    out_result->heap_calls = heap_calls_before < 0 ? -1 : heap_calls() - heap_calls_before;
+    out_result->region_allocations = automaton->memory.num_allocations;
+    out_result->region_blocks = automaton->memory.num_blocks;
+    out_result->region_bytes = automaton->memory.bytes_used;
+
+    free_parser_table(table);
+    free_lalr1_automaton(automaton);
+    return true;
+}
+
+/**
+ * @brief Reads the peak resident set size of the calling process.
+ * @return Peak RSS in KiB.
+ */
+static long peak_rss_kib(void)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return -1;
+    }
+
+#ifdef __APPLE__
+    // macOS reports bytes, Linux and the BSDs report KiB.
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * @brief Benchmarks one grammar and writes its JSON object.
+ *
+ * Runs in a forked child so the reported peak RSS belongs to this grammar only.
+ * The fastest of the repeated runs is reported.
+ *
+ * @param out JSON destination.
+ * @param name Grammar name written to the report.
+ * @param grammar_text Grammar source text.
+ * @param repeat Number of generation runs.
+ * @return true on success, false when the grammar could not be generated.
+ */
+static bool bench_grammar(FILE *out, const char *name, const char *grammar_text, int repeat)
+{
+    long heap_calls_before = heap_calls();
+    grammar *g = create_grammar(grammar_text);
+    long grammar_heap_calls = heap_calls_before < 0 ? -1 : heap_calls() - heap_calls_before;
+    if (g == NULL || g->num_non_terminals <= 0)
+    {
+        free_grammar(g);
+        return false;
+    }
+
+    bench_result best = {0};
+    for (int run = 0; run < repeat; run++)
+    {
+        bench_result result;
+        if (!run_generation(g, &result))
+        {
+            free_grammar(g);
+            return false;
+        }
+        if (run == 0 || result.total_seconds < best.total_seconds)
+        {
+            best = result;
+        }
+    }
+
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"name\": ");
+    write_json_name(out, name);
+    fprintf(out, ",\n");
+    fprintf(out, "      \"productions\": %d,\n", g->num_productions);
+    fprintf(out, "      \"terminals\": %d,\n", g->num_terminals);
+    fprintf(out, "      \"non_terminals\": %d,\n", g->num_non_terminals);
+    fprintf(out, "      \"lr1_states\": %d,\n", best.profile.lr1_states);
+    fprintf(out, "      \"lalr_states\": %d,\n", best.profile.lalr_states);
+    fprintf(out, "      \"conflicts\": %d,\n", best.num_conflicts);
+    fprintf(out, "      \"seconds\": {\n");
+    fprintf(out, "        \"first_sets\": %.6f,\n", best.profile.first_seconds);
+    fprintf(out, "        \"closure\": %.6f,\n", best.profile.closure_seconds);
+    fprintf(out, "        \"goto\": %.6f,\n", best.profile.goto_seconds);
+    fprintf(out, "        \"state_dedup\": %.6f,\n", best.profile.dedup_seconds);
+    fprintf(out, "        \"lalr_merge\": %.6f,\n", best.profile.merge_seconds);
+    fprintf(out, "        \"table_fill\": %.6f,\n", best.table_seconds);
+    fprintf(out, "        \"total\": %.6f\n", best.total_seconds);
+    fprintf(out, "      },\n");
+    fprintf(out, "      \"counters\": {\n");
+    fprintf(out, "        \"closure_calls\": %ld,\n", best.profile.closure_calls);
+    fprintf(out, "        \"items_created\": %ld,\n", best.profile.items_created);
+    fprintf(out, "        \"goto_calls\": %ld,\n", best.profile.goto_calls);
+    fprintf(out, "        \"state_probes\": %ld,\n", best.profile.state_probes);
+    fprintf(out, "        \"transition_probes\": %ld\n", best.profile.transition_probes);
+    fprintf(out, "      },\n");
+    fprintf(out, "      \"allocations\": {\n");
+    fprintf(out, "        \"grammar_heap_calls\": %ld,\n", grammar_heap_calls);
+    fprintf(out, "        \"grammar_region_allocations\": %zu,\n", g->memory.num_allocations);
+    fprintf(out, "        \"grammar_region_blocks\": %zu,\n", g->memory.num_blocks);
+    fprintf(out, "        \"generation_heap_calls\": %ld,\n", best.heap_calls);
+    fprintf(out, "        \"automaton_region_allocations\": %zu,\n", best.region_allocations);
+    fprintf(out, "        \"automaton_region_blocks\": %zu,\n", best.region_blocks);
+    fprintf(out, "        \"automaton_region_bytes\": %zu,\n", best.region_bytes);
+    fprintf(out, "        \"automaton_peak_bytes\": %zu\n", best.profile.peak_bytes);
+    fprintf(out, "      },\n");
+    fprintf(out, "      \"peak_rss_kib\": %ld\n", peak_rss_kib());
+    fprintf(out, "    }");
+    free_grammar(g);
+    return true;
+}
+
+/**
+ * @brief Runs bench_grammar in a child process and reports failures in its place.
+ * @param out JSON destination.
+ * @param name Grammar name written to the report.
+ * @param grammar_text Grammar source text.
+ * @param repeat Number of generation runs.
+ * @return true when the child succeeded.
+ */
+static bool bench_grammar_isolated(FILE *out, const char *name, const char *grammar_text, int repeat)
+{
+    fflush(out);
+    pid_t child = fork();
+    if (child == 0)
+    {
+        bool ok = bench_grammar(out, name, grammar_text, repeat);
+        fflush(out);
+        _exit(ok ? 0 : 1);
+    }
+
+    int status = 0;
+    if (child < 0 || waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        fprintf(stderr, "Generation failed for grammar '%s'.\n", name);
+        fprintf(out, "    {\n      \"name\": ");
+        write_json_name(out, name);
+        fprintf(out, ",\n      \"error\": \"generation failed\"\n    }");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Derives a stable report name from a grammar path: its last two components.
+ * @param path Grammar file path.
+ * @return Pointer into path.
+ */
+static const char *grammar_name(const char *path)
+{
+    const char *last = strrchr(path, '/');
+    if (last == NULL || last == path)
+    {
+        return path;
+    }
+
+    const char *name = last;
+    while (name > path && name[-1] != '/')
+    {
+        name--;
+    }
+    return name;
+}
+
+/**
+ * @brief Parses a comma-separated list of positive scales.
+ * @param text List such as "1,2,4".
+ * @param out_scales Output array, allocated.
+ * @param out_count Output number of scales.
+ * @return true on success, false on a malformed list.
+ */
+static bool parse_scales(const char *text, int **out_scales, int *out_count)
+{
+    int count = 1;
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        if (*c == ',')
+        {
+            count++;
+        }
+    }
+
+    int *scales = (int *)malloc((size_t)count * sizeof(int));
+    if (scales == NULL)
+    {
+        return false;
+    }
+
+    const char *cursor = text;
+    for (int i = 0; i < count; i++)
+    {
+        char *end = NULL;
+        errno = 0;
+        long value = strtol(cursor, &end, 10);
+        if (errno != 0 || end == cursor || value < 1 || value > 1024 || (*end != ',' && *end != '\0'))
+        {
+            free(scales);
+            return false;
+        }
+        scales[i] = (int)value;
+        cursor = end + 1;
+    }
+
+    *out_scales = scales;
+    *out_count = count;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *output_path = NULL;
+    int repeat = 1;
+    int *scales = NULL;
+    int num_scales = 0;
+    const char **grammar_paths = (const char **)malloc((size_t)argc * sizeof(const char *));
+    int num_grammars = 0;
+    if (grammar_paths == NULL)
+    {
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--output=", 9) == 0)
+        {
+            output_path = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--repeat=", 9) == 0)
+        {
+            repeat = atoi(argv[i] + 9);
+        }
+        else if (strncmp(argv[i], "--synthetic=", 12) == 0)
+        {
+            free(scales);
+            if (!parse_scales(argv[i] + 12, &scales, &num_scales))
+            {
+                fprintf(stderr, "Invalid --synthetic list '%s'.\n", argv[i] + 12);
+                free(grammar_paths);
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--", 2) == 0)
+        {
+            fprintf(stderr, "Unknown option '%s'.\n", argv[i]);
+            free(scales);
+            free(grammar_paths);
+            return 1;
+        }
+        else
+        {
+            grammar_paths[num_grammars++] = argv[i];
+        }
+    }
+
+    if (repeat < 1 || (num_grammars == 0 && num_scales == 0))
+    {
+        fprintf(stderr,
+                "Usage: %s [--output=report.json] [--repeat=N] [--synthetic=S1,S2,...] [grammar_file...]\n",
+                argv[0]);
+        free(scales);
+        free(grammar_paths);
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (output_path != NULL)
+    {
+        out = fopen(output_path, "w");
+        if (out == NULL)
+        {
+            fprintf(stderr, "Failed to open '%s': %s\n", output_path, strerror(errno));
+            free(scales);
+            free(grammar_paths);
+            return 1;
+        }
+    }
+
+    int failures = 0;
+    bool first = true;
+    fprintf(out, "{\n  \"benchmark\": \"parser_generator\",\n  \"repeat\": %d,\n  \"grammars\": [\n", repeat);
+
+    for (int i = 0; i < num_grammars; i++)
+    {
+        const char *name = grammar_name(grammar_paths[i]);
+        char *grammar_text = read_file_all(grammar_paths[i]);
+        if (grammar_text == NULL)
+        {
+            fprintf(stderr, "Failed to read grammar file '%s'.\n", grammar_paths[i]);
+            failures++;
+            continue;
+        }
+
+        fprintf(out, first ? "" : ",\n");
+        first = false;
+        fprintf(stderr, "Benchmarking %s\n", name);
+        if (!bench_grammar_isolated(out, name, grammar_text, repeat))
+        {
+            failures++;
+        }
+        free(grammar_text);
+    }
+
+    for (int i = 0; i < num_scales; i++)
+    {
+        char *grammar_text = generate_synthetic_grammar(scales[i]);
+        char name[64];
+        snprintf(name, sizeof(name), "synthetic/scale_%d", scales[i]);
+        if (grammar_text == NULL)
+        {
+            fprintf(stderr, "Failed to generate grammar '%s'.\n", name);
+            failures++;
+            continue;
+        }
+
+        fprintf(out, first ? "" : ",\n");
+        first = false;
+        fprintf(stderr, "Benchmarking %s\n", name);
+        if (!bench_grammar_isolated(out, name, grammar_text, repeat))
+        {
+            failures++;
+        }
+        free(grammar_text);
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+    {
+        fclose(out);
+        printf("Benchmark report written to %s\n", output_path);
+    }
+
+    free(scales);
+    free(grammar_paths);
+    return failures == 0 ? 0 : 1;
+}
@@ -266,7 +266,9 @@ int compute_first_for_non_terminal(const grammar *g, int non_terminal_id, symbol
  */
 int compute_first_for_start_symbol(const grammar *g, symbol **out_first)
 {
-	return compute_first_for_non_terminal(g, 0, out_first);
+	// The start symbol is that of the default entry point.
+	int start_id = g != NULL && g->num_start_symbols > 0 ? g->start_symbol_ids[0] : 0;
+	return compute_first_for_non_terminal(g, start_id, out_first);
 }
 
 /**
@@ -0,0 +1,192 @@
+#include "arena.h"
+
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+#define ARENA_MAX_BLOCK_SIZE (16 * 1024 * 1024)
+
+typedef struct arena_block
+{
+    struct arena_block *next;
+    size_t used;
+    size_t capacity;
+    max_align_t data[];
+} arena_block;
+
+static size_t align_size(size_t size);
+static arena_block *add_block(arena *region, size_t min_size);
+
+void init_arena(arena *region, size_t first_block_size)
+{
+    if (region == NULL)
+    {
+        return;
+    }
+
+    memset(region, 0, sizeof(arena));
+    region->next_block_size = first_block_size > 0 ? align_size(first_block_size) : ARENA_DEFAULT_BLOCK_SIZE;
+}
+
+void *arena_alloc(arena *region, size_t size)
+{
+    if (region == NULL || size > SIZE_MAX - alignof(max_align_t))
+    {
+        return NULL;
+    }
+
+    size_t aligned = align_size(size > 0 ? size : 1);
+    arena_block *block = region->blocks;
+    if (block == NULL || block->capacity - block->used < aligned)
+    {
+        block = add_block(region, aligned);
+        if (block == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    void *memory = (unsigned char *)block->data + block->used;
+    block->used += aligned;
+    region->last_allocation = memory;
+    region->last_size = aligned;
+    region->num_allocations++;
+    region->bytes_used += aligned;
+    return memory;
+}
+
+void *arena_calloc(arena *region, size_t count, size_t size)
+{
+    if (size != 0 && count > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+
+    void *memory = arena_alloc(region, count * size);
+    if (memory != NULL)
+    {
+        memset(memory, 0, count * size);
+    }
+    return memory;
+}
+
+void *arena_grow(arena *region, void *memory, size_t old_size, size_t new_size)
+{
+    if (region == NULL)
+    {
+        return NULL;
+    }
+    if (memory == NULL)
+    {
+        return arena_alloc(region, new_size);
+    }
+    if (new_size <= old_size)
+    {
+        return memory;
+    }
+
+    arena_block *block = region->blocks;
+    if (memory == region->last_allocation && new_size <= SIZE_MAX - alignof(max_align_t))
+    {
+        size_t aligned = align_size(new_size);
+        size_t start = block->used - region->last_size;
+        if (aligned <= block->capacity - start)
+        {
+            block->used = start + aligned;
+            region->bytes_used += aligned - region->last_size;
+            region->last_size = aligned;
+            return memory;
+        }
+    }
+
+    void *moved = arena_alloc(region, new_size);
+    if (moved != NULL)
+    {
+        memcpy(moved, memory, old_size);
+    }
+    return moved;
+}
+
+char *arena_strdup(arena *region, const char *text)
+{
+    if (text == NULL)
+    {
+        return NULL;
+    }
+
+    size_t length = strlen(text);
+    char *copy = (char *)arena_alloc(region, length + 1);
+    if (copy != NULL)
+    {
+        memcpy(copy, text, length + 1);
+    }
+    return copy;
+}
+
+void free_arena(arena *region)
+{
+    if (region == NULL)
+    {
+        return;
+    }
+
+    arena_block *block = region->blocks;
+    while (block != NULL)
+    {
+        arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    init_arena(region, 0);
+}
+
+/**
+ * @brief Rounds a size up so the next allocation stays aligned for any type.
+ * @param size Size in bytes; must leave room for the rounding.
+ * @return Aligned size.
+ */
+static size_t align_size(size_t size)
+{
+    const size_t alignment = alignof(max_align_t);
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Allocates a new current block, at least min_size bytes large.
+ * @param region Region to extend.
+ * @param min_size Aligned size of the allocation that did not fit.
+ * @return New block, or NULL on allocation error.
+ */
+static arena_block *add_block(arena *region, size_t min_size)
+{
+    size_t capacity = region->next_block_size > 0 ? region->next_block_size : ARENA_DEFAULT_BLOCK_SIZE;
+    if (capacity < min_size)
+    {
+        capacity = min_size;
+    }
+    if (capacity > SIZE_MAX - sizeof(arena_block))
+    {
+        return NULL;
+    }
+
+    arena_block *block = (arena_block *)malloc(sizeof(arena_block) + capacity);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    block->next = region->blocks;
+    block->used = 0;
+    block->capacity = capacity;
+    region->blocks = block;
+    region->num_blocks++;
+    region->bytes_reserved += capacity;
+    if (region->next_block_size < ARENA_MAX_BLOCK_SIZE)
+    {
+        region->next_block_size *= 2;
+    }
+    return block;
+}
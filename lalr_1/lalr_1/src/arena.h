@@ -0,0 +1,80 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct arena_block;
+
+typedef struct arena
+{
+    // Most recent block first; allocations bump a pointer inside it.
+    struct arena_block *blocks;
+    // Size of the next block; doubles with every block up to a cap.
+    size_t next_block_size;
+    // Last allocation, which arena_grow can extend in place.
+    void *last_allocation;
+    size_t last_size;
+    // Allocation report: requests served, heap blocks behind them and their bytes.
+    size_t num_allocations;
+    size_t num_blocks;
+    size_t bytes_used;
+    size_t bytes_reserved;
+} arena;
+
+/**
+ * @brief Initializes an empty region; no memory is reserved until the first allocation.
+ * @param region Region to initialize.
+ * @param first_block_size Size of the first block in bytes; 0 selects a default.
+ * @return This function does not return a value.
+ */
+void init_arena(arena *region, size_t first_block_size);
+
+/**
+ * @brief Allocates memory from the region by bumping a pointer.
+ * @param region Region owning the memory.
+ * @param size Number of bytes.
+ * @return Memory aligned for any type, or NULL on allocation error.
+ */
+void *arena_alloc(arena *region, size_t size);
+
+/**
+ * @brief Allocates zero-initialized memory from the region.
+ * @param region Region owning the memory.
+ * @param count Number of elements.
+ * @param size Size of one element.
+ * @return Zeroed memory, or NULL on allocation error or overflow.
+ */
+void *arena_calloc(arena *region, size_t count, size_t size);
+
+/**
+ * @brief Resizes an allocation of the region, like realloc.
+ *
+ * The last allocation grows in place while its block has room. Otherwise the
+ * contents move to a new allocation; the old one stays in the region until it
+ * is freed.
+ *
+ * @param region Region owning the memory.
+ * @param memory Allocation to grow, or NULL.
+ * @param old_size Current size of memory in bytes.
+ * @param new_size Requested size in bytes.
+ * @return Resized memory, or NULL on allocation error (memory is then unchanged).
+ */
+void *arena_grow(arena *region, void *memory, size_t old_size, size_t new_size);
+
+/**
+ * @brief Copies a string into the region.
+ * @param region Region owning the memory.
+ * @param text Null-terminated string.
+ * @return Copy of text, or NULL on allocation error.
+ */
+char *arena_strdup(arena *region, const char *text);
+
+/**
+ * @brief Releases every allocation of the region at once and leaves it empty.
+ * @param region Region to free.
+ * @return This function does not return a value.
+ */
+void free_arena(arena *region);
+
+#endif // ARENA_H
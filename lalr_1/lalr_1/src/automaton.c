@@ -1,12 +1,21 @@
 #include "automaton.h"
 
 #include <stdio.h>
+#include <time.h>
 
 typedef struct first_context
 {
 	bool *first_table;
 	bool *nullable;
+	// Per-closure scratch: lookaheads of the item being expanded.
+	bool *lookahead_buffer;
 	int epsilon_id;
+	// Closure gives every new item the EOF lookahead, which yields LR(0) item sets.
+	bool lr0_items;
+	// Counters of a profiled build, or NULL.
+	automaton_profile *profile;
+	// Owns the tables above for the duration of one build.
+	arena memory;
 } first_context;
 
 typedef struct core_item
@@ -22,10 +31,19 @@ typedef struct kernel_signature
 } kernel_signature;
 
 static bool ensure_state_capacity(lr1_state *state, int min_capacity);
+static lr1_automaton *build_lr1_kernels(const grammar *g, const first_context *ctx);
+static bool close_state(const grammar *g, const first_context *ctx, lr1_state *state, int eof_lookahead_id);
+static bool copy_state_items(const lr1_state *source, lr1_state *destination);
+static bool lr1_goto_kernel(const grammar *g, const lr1_state *from_state, int symbol_id, lr1_state *out_state);
+static double profile_clock(const automaton_profile *profile);
+static void record_region_use(automaton_profile *profile, const arena *region, size_t other_live_bytes);
 static int find_terminal_id(const grammar *g, const char *name);
-static bool build_first_context(const grammar *g, first_context *ctx);
+static bool build_first_context(const grammar *g, first_context *ctx, automaton_profile *profile);
 static void free_first_context(first_context *ctx);
+static bool *build_follow_table(const grammar *g, const first_context *ctx);
+static bool add_follow_lookaheads(const grammar *g, const bool *follow, const lr1_state *lr0_state, lr1_state *out_state);
 static int get_item_rhs_symbol(const grammar *g, const lr1_item *item, int offset);
+static int entry_start_symbol(const grammar *g, int production_index);
 static int get_item_rhs_length(const grammar *g, const lr1_item *item);
 static bool compute_first_of_suffix_with_lookahead(
 	const grammar *g,
@@ -35,20 +53,29 @@ static bool compute_first_of_suffix_with_lookahead(
 	int eof_lookahead_id,
 	bool *out_lookaheads,
 	int lookahead_capacity);
-static bool add_transition_unique(lr1_automaton *automaton, int from_state, int symbol_id, int to_state);
+static bool add_transition_unique(
+	lr1_automaton *automaton,
+	int from_state,
+	int symbol_id,
+	int to_state,
+	automaton_profile *profile);
 static bool ensure_states_capacity(lr1_automaton *automaton, int min_capacity);
 static bool ensure_transitions_capacity(lr1_automaton *automaton, int min_capacity);
 static int compare_lr1_items(const void *a, const void *b);
 static int compare_core_items(const void *a, const void *b);
 static void sort_state_items(lr1_state *state);
 static bool states_equal(const lr1_state *left, const lr1_state *right);
-static int find_state_index(const lr1_automaton *automaton, const lr1_state *state);
+static int find_state_index(const lr1_automaton *automaton, const lr1_state *state, automaton_profile *profile);
 static bool append_state_copy(lr1_automaton *automaton, const lr1_state *state, int *out_index);
 static bool collect_goto_symbols(const grammar *g, const lr1_state *state, bool *symbols_out, int symbols_count);
-static bool build_kernel_signature(const lr1_state *state, kernel_signature *signature);
-static void free_kernel_signature(kernel_signature *signature);
+static bool build_kernel_signature(const lr1_state *state, kernel_signature *signature, arena *scratch);
 static bool equal_kernel_signatures(const kernel_signature *left, const kernel_signature *right);
-static bool build_state_group_map(const lr1_automaton *lr1, int **out_state_group, int *out_group_count);
+static bool build_state_group_map(
+	const lr1_automaton *lr1,
+	arena *scratch,
+	automaton_profile *profile,
+	int **out_state_group,
+	int *out_group_count);
 static bool merge_group_items(const lr1_automaton *lr1, const int *state_group, int group_id, lr1_state *out_state);
 static bool symbol_is_terminal(const grammar *g, int encoded_symbol_id);
 static const char *symbol_name(const grammar *g, int encoded_symbol_id);
@@ -64,6 +91,7 @@ void init_lr1_state(lr1_state *state)
 	state->items = NULL;
 	state->num_items = 0;
 	state->capacity = 0;
+	state->memory = NULL;
 }
 
 void free_lr1_state(lr1_state *state)
@@ -73,7 +101,11 @@ void free_lr1_state(lr1_state *state)
 		return;
 	}
 
-	free(state->items);
+	// Region-backed items are released with their region.
+	if (state->memory == NULL)
+	{
+		free(state->items);
+	}
 	state->items = NULL;
 	state->num_items = 0;
 	state->capacity = 0;
@@ -114,97 +146,14 @@ bool lr1_closure(const grammar *g, lr1_state *state, int eof_lookahead_id)
 	}
 
 	first_context ctx = {0};
-	if (!build_first_context(g, &ctx))
+	if (!build_first_context(g, &ctx, NULL))
 	{
 		return false;
 	}
 
-	const int lookahead_count = g->num_terminals + 1;
-	bool *lookahead_buffer = (bool *)calloc((size_t)lookahead_count, sizeof(bool));
-	if (lookahead_buffer == NULL)
-	{
-		free_first_context(&ctx);
-		return false;
-	}
-
-	bool changed = true;
-	while (changed)
-	{
-		changed = false;
-
-		// Snapshot current size because closure expansion can append new items.
-		const int base_count = state->num_items;
-		for (int item_index = 0; item_index < base_count; item_index++)
-		{
-			lr1_item item = state->items[item_index];
-
-			int next_symbol = get_item_rhs_symbol(g, &item, item.dot_position);
-			if (next_symbol < g->num_terminals)
-			{
-				continue;
-			}
-
-			int non_terminal_id = next_symbol - g->num_terminals;
-			if (non_terminal_id < 0 || non_terminal_id >= g->num_non_terminals)
-			{
-				continue;
-			}
-
-			memset(lookahead_buffer, 0, (size_t)lookahead_count * sizeof(bool));
-			if (!compute_first_of_suffix_with_lookahead(
-					g,
-					&ctx,
-					&item,
-					item.dot_position,
-					eof_lookahead_id,
-					lookahead_buffer,
-					lookahead_count))
-			{
-				free(lookahead_buffer);
-				free_first_context(&ctx);
-				return false;
-			}
-
-			for (int production_index = 0; production_index < g->num_productions; production_index++)
-			{
-				if (g->productions[production_index].non_terminal_id != non_terminal_id)
-				{
-					continue;
-				}
-
-				for (int la = 0; la < lookahead_count; la++)
-				{
-					if (!lookahead_buffer[la])
-					{
-						continue;
-					}
-
-					const int before_count = state->num_items;
-					lr1_item new_item;
-					new_item.production_index = production_index;
-					new_item.dot_position = 0;
-					new_item.lookahead_id = la;
-
-					if (!add_lr1_item_unique(state, new_item))
-					{
-						free(lookahead_buffer);
-						free_first_context(&ctx);
-						return false;
-					}
-
-					if (state->num_items > before_count)
-					{
-						changed = true;
-					}
-				}
-			}
-		}
-	}
-
-	sort_state_items(state);
-	free(lookahead_buffer);
+	bool ok = close_state(g, &ctx, state, eof_lookahead_id);
 	free_first_context(&ctx);
-	return true;
+	return ok;
 }
 
 bool lr1_goto(
@@ -219,24 +168,9 @@ bool lr1_goto(
 		return false;
 	}
 
-	free_lr1_state(out_state);
-	init_lr1_state(out_state);
-
-	for (int i = 0; i < from_state->num_items; i++)
+	if (!lr1_goto_kernel(g, from_state, symbol_id, out_state))
 	{
-		lr1_item item = from_state->items[i];
-		int next_symbol = get_item_rhs_symbol(g, &item, item.dot_position);
-		if (next_symbol != symbol_id)
-		{
-			continue;
-		}
-
-		item.dot_position++;
-		if (!add_lr1_item_unique(out_state, item))
-		{
-			free_lr1_state(out_state);
-			return false;
-		}
+		return false;
 	}
 
 	if (out_state->num_items == 0)
@@ -249,43 +183,85 @@ bool lr1_goto(
 
 lr1_automaton *build_lr1_automaton(const grammar *g)
 {
-	if (g == NULL || g->num_non_terminals <= 0)
+	return build_lr1_automaton_profiled(g, NULL);
+}
+
+lr1_automaton *build_lr1_automaton_profiled(const grammar *g, automaton_profile *profile)
+{
+	first_context ctx = {0};
+	if (g == NULL || !build_first_context(g, &ctx, profile))
 	{
 		return NULL;
 	}
 
-	lr1_automaton *automaton = (lr1_automaton *)calloc(1, sizeof(lr1_automaton));
+	lr1_automaton *automaton = build_lr1_kernels(g, &ctx);
 	if (automaton == NULL)
 	{
+		free_first_context(&ctx);
 		return NULL;
 	}
 
-	automaton->g = g;
-	automaton->eof_lookahead_id = g->num_terminals;
-
-	lr1_state start_state;
-	init_lr1_state(&start_state);
+	// Construction keeps kernels only; the public automaton lists full item sets.
+	double started = profile_clock(profile);
+	for (int state_id = 0; state_id < automaton->num_states; state_id++)
+	{
+		if (!close_state(g, &ctx, &automaton->states[state_id], automaton->eof_lookahead_id))
+		{
+			free_first_context(&ctx);
+			free_lr1_automaton(automaton);
+			return NULL;
+		}
+	}
 
-	lr1_item start_item;
-	start_item.production_index = -1;
-	start_item.dot_position = 0;
-	start_item.lookahead_id = automaton->eof_lookahead_id;
+	if (profile != NULL)
+	{
+		profile->closure_seconds += profile_clock(profile) - started;
+		record_region_use(profile, &ctx.memory, automaton->memory.bytes_reserved);
+		record_region_use(profile, &automaton->memory, 0);
+	}
+	free_first_context(&ctx);
+	return automaton;
+}
 
-	if (!add_lr1_item_unique(&start_state, start_item) ||
-		!lr1_closure(g, &start_state, automaton->eof_lookahead_id))
+static lr1_automaton *build_lr1_kernels(const grammar *g, const first_context *ctx)
+{
+	automaton_profile *profile = ctx->profile;
+	if (g == NULL || g->num_non_terminals <= 0)
 	{
-		free_lr1_state(&start_state);
-		free_lr1_automaton(automaton);
 		return NULL;
 	}
 
-	int initial_index = -1;
-	if (!append_state_copy(automaton, &start_state, &initial_index))
+	lr1_automaton *automaton = (lr1_automaton *)calloc(1, sizeof(lr1_automaton));
+	if (automaton == NULL)
 	{
-		free_lr1_state(&start_state);
-		free_lr1_automaton(automaton);
 		return NULL;
 	}
+
+	automaton->g = g;
+	automaton->eof_lookahead_id = g->num_terminals;
+	init_arena(&automaton->memory, 0);
+
+	// One augmented item S'k -> . Ak per entry point; its kernel is state k.
+	lr1_state start_state;
+	init_lr1_state(&start_state);
+	const int num_entries = g->num_start_symbols > 0 ? g->num_start_symbols : 1;
+	for (int entry = 0; entry < num_entries; entry++)
+	{
+		lr1_item start_item;
+		start_item.production_index = -1 - entry;
+		start_item.dot_position = 0;
+		start_item.lookahead_id = automaton->eof_lookahead_id;
+
+		int initial_index = -1;
+		start_state.num_items = 0;
+		if (!add_lr1_item_unique(&start_state, start_item) ||
+			!append_state_copy(automaton, &start_state, &initial_index))
+		{
+			free_lr1_state(&start_state);
+			free_lr1_automaton(automaton);
+			return NULL;
+		}
+	}
 	free_lr1_state(&start_state);
 
 	const int symbols_count = g->num_terminals + g->num_non_terminals;
@@ -296,14 +272,33 @@ lr1_automaton *build_lr1_automaton(const grammar *g)
 		return NULL;
 	}
 
-	for (int state_id = 0; state_id < automaton->num_states; state_id++)
+	// States keep only their kernel; the closure of the state being expanded lives here
+	// and is dropped once its GOTO kernels are known. Every state is expanded once.
+	lr1_state closure;
+	init_lr1_state(&closure);
+	lr1_state goto_state;
+	init_lr1_state(&goto_state);
+	bool ok = true;
+
+	for (int state_id = 0; state_id < automaton->num_states && ok; state_id++)
 	{
+		double started = profile_clock(profile);
+		if (!copy_state_items(&automaton->states[state_id], &closure) ||
+			!close_state(g, ctx, &closure, automaton->eof_lookahead_id))
+		{
+			ok = false;
+			break;
+		}
+		if (profile != NULL)
+		{
+			profile->closure_seconds += profile_clock(profile) - started;
+		}
+
 		memset(symbols, 0, (size_t)symbols_count * sizeof(bool));
-		if (!collect_goto_symbols(g, &automaton->states[state_id], symbols, symbols_count))
+		if (!collect_goto_symbols(g, &closure, symbols, symbols_count))
 		{
-			free(symbols);
-			free_lr1_automaton(automaton);
-			return NULL;
+			ok = false;
+			break;
 		}
 
 		for (int symbol_id = 0; symbol_id < symbols_count; symbol_id++)
@@ -313,63 +308,161 @@ lr1_automaton *build_lr1_automaton(const grammar *g)
 				continue;
 			}
 
-			lr1_state goto_state;
-			init_lr1_state(&goto_state);
-
-			if (!lr1_goto(g, &automaton->states[state_id], symbol_id, automaton->eof_lookahead_id, &goto_state))
+			started = profile_clock(profile);
+			if (!lr1_goto_kernel(g, &closure, symbol_id, &goto_state))
 			{
-				free_lr1_state(&goto_state);
-				free(symbols);
-				free_lr1_automaton(automaton);
-				return NULL;
+				ok = false;
+				break;
+			}
+			if (profile != NULL)
+			{
+				profile->goto_calls++;
+				profile->items_created += goto_state.num_items;
 			}
-
 			if (goto_state.num_items == 0)
 			{
-				free_lr1_state(&goto_state);
 				continue;
 			}
+			sort_state_items(&goto_state);
+			double kernel_done = profile_clock(profile);
 
-			int target_id = find_state_index(automaton, &goto_state);
-			if (target_id < 0)
+			// Closure is a function of the kernel, so equal kernels mean equal LR(1) states.
+			int target_id = find_state_index(automaton, &goto_state, profile);
+			if (target_id < 0 && !append_state_copy(automaton, &goto_state, &target_id))
 			{
-				if (!append_state_copy(automaton, &goto_state, &target_id))
-				{
-					free_lr1_state(&goto_state);
-					free(symbols);
-					free_lr1_automaton(automaton);
-					return NULL;
-				}
+				ok = false;
+				break;
 			}
 
-			if (!add_transition_unique(automaton, state_id, symbol_id, target_id))
+			if (profile != NULL)
 			{
-				free_lr1_state(&goto_state);
-				free(symbols);
-				free_lr1_automaton(automaton);
-				return NULL;
+				profile->goto_seconds += kernel_done - started;
+				profile->dedup_seconds += profile_clock(profile) - kernel_done;
 			}
 
-			free_lr1_state(&goto_state);
+			if (!add_transition_unique(automaton, state_id, symbol_id, target_id, profile))
+			{
+				ok = false;
+				break;
+			}
 		}
 	}
 
+	free_lr1_state(&goto_state);
+	free_lr1_state(&closure);
 	free(symbols);
+	if (!ok)
+	{
+		free_lr1_automaton(automaton);
+		return NULL;
+	}
+
+	if (profile != NULL)
+	{
+		profile->lr1_states = automaton->num_states;
+	}
+	return automaton;
+}
+
+lr1_automaton *build_slr1_automaton(const grammar *g)
+{
+	return build_slr1_automaton_profiled(g, NULL);
+}
+
+lr1_automaton *build_slr1_automaton_profiled(const grammar *g, automaton_profile *profile)
+{
+	first_context ctx = {0};
+	if (g == NULL || !build_first_context(g, &ctx, profile))
+	{
+		return NULL;
+	}
+
+	double started = profile_clock(profile);
+	bool *follow = build_follow_table(g, &ctx);
+	if (follow == NULL)
+	{
+		free_first_context(&ctx);
+		return NULL;
+	}
+	if (profile != NULL)
+	{
+		profile->first_seconds += profile_clock(profile) - started;
+	}
+
+	ctx.lr0_items = true;
+	lr1_automaton *automaton = build_lr1_kernels(g, &ctx);
+	if (automaton == NULL)
+	{
+		free(follow);
+		free_first_context(&ctx);
+		return NULL;
+	}
+
+	lr1_state closure;
+	init_lr1_state(&closure);
+	started = profile_clock(profile);
+	for (int state_id = 0; state_id < automaton->num_states; state_id++)
+	{
+		if (!copy_state_items(&automaton->states[state_id], &closure) ||
+			!close_state(g, &ctx, &closure, automaton->eof_lookahead_id) ||
+			!add_follow_lookaheads(g, follow, &closure, &automaton->states[state_id]))
+		{
+			free_lr1_state(&closure);
+			free(follow);
+			free_first_context(&ctx);
+			free_lr1_automaton(automaton);
+			return NULL;
+		}
+	}
+
+	if (profile != NULL)
+	{
+		profile->closure_seconds += profile_clock(profile) - started;
+		record_region_use(profile, &ctx.memory, automaton->memory.bytes_reserved);
+		record_region_use(profile, &automaton->memory, 0);
+	}
+	free_lr1_state(&closure);
+	free(follow);
+	free_first_context(&ctx);
 	return automaton;
 }
 
 lalr1_automaton *build_lalr1_automaton(const grammar *g)
 {
-	lr1_automaton *lr1 = build_lr1_automaton(g);
+	return build_lalr1_automaton_profiled(g, NULL);
+}
+
+lalr1_automaton *build_lalr1_automaton_profiled(const grammar *g, automaton_profile *profile)
+{
+	first_context ctx = {0};
+	if (g == NULL || !build_first_context(g, &ctx, profile))
+	{
+		return NULL;
+	}
+
+	lr1_automaton *lr1 = build_lr1_kernels(g, &ctx);
 	if (lr1 == NULL)
 	{
+		free_first_context(&ctx);
 		return NULL;
 	}
 
+	double started = profile_clock(profile);
+
+	// Kernel signatures are scratch data, released together once the groups are known.
+	arena scratch;
+	init_arena(&scratch, 0);
 	int *state_group = NULL;
 	int group_count = 0;
-	if (!build_state_group_map(lr1, &state_group, &group_count))
+	bool grouped = build_state_group_map(lr1, &scratch, profile, &state_group, &group_count);
+	if (profile != NULL)
 	{
+		record_region_use(profile, &scratch, ctx.memory.bytes_reserved + lr1->memory.bytes_reserved);
+	}
+	free_arena(&scratch);
+	if (!grouped)
+	{
+		free_first_context(&ctx);
 		free_lr1_automaton(lr1);
 		return NULL;
 	}
@@ -378,33 +471,40 @@ lalr1_automaton *build_lalr1_automaton(const grammar *g)
 	if (lalr == NULL)
 	{
 		free(state_group);
+		free_first_context(&ctx);
 		free_lr1_automaton(lr1);
 		return NULL;
 	}
 
 	lalr->g = g;
 	lalr->eof_lookahead_id = lr1->eof_lookahead_id;
+	init_arena(&lalr->memory, 0);
 
 	if (!ensure_states_capacity(lalr, group_count))
 	{
 		free(state_group);
+		free_first_context(&ctx);
 		free_lr1_automaton(lr1);
 		free_lalr1_automaton(lalr);
 		return NULL;
 	}
 
+	// Closure distributes over union, so closing the merged kernel gives the merged item set.
 	for (int group = 0; group < group_count; group++)
 	{
 		init_lr1_state(&lalr->states[group]);
-		if (!merge_group_items(lr1, state_group, group, &lalr->states[group]))
+		lalr->states[group].memory = &lalr->memory;
+		lalr->num_states = group + 1;
+		if (!merge_group_items(lr1, state_group, group, &lalr->states[group]) ||
+			!close_state(g, &ctx, &lalr->states[group], lalr->eof_lookahead_id))
 		{
 			free(state_group);
+			free_first_context(&ctx);
 			free_lr1_automaton(lr1);
 			free_lalr1_automaton(lalr);
 			return NULL;
 		}
 	}
-	lalr->num_states = group_count;
 
 	for (int i = 0; i < lr1->num_transitions; i++)
 	{
@@ -412,17 +512,30 @@ lalr1_automaton *build_lalr1_automaton(const grammar *g)
 		int merged_from = state_group[t.from_state];
 		int merged_to = state_group[t.to_state];
 
-		if (!add_transition_unique(lalr, merged_from, t.symbol_id, merged_to))
+		if (!add_transition_unique(lalr, merged_from, t.symbol_id, merged_to, profile))
 		{
 			free(state_group);
+			free_first_context(&ctx);
 			free_lr1_automaton(lr1);
 			free_lalr1_automaton(lalr);
 			return NULL;
 		}
 	}
 
+	if (profile != NULL)
+	{
+		record_region_use(profile, &ctx.memory, lr1->memory.bytes_reserved + lalr->memory.bytes_reserved);
+		record_region_use(profile, &lr1->memory, lalr->memory.bytes_reserved);
+		record_region_use(profile, &lalr->memory, 0);
+	}
 	free(state_group);
+	free_first_context(&ctx);
 	free_lr1_automaton(lr1);
+	if (profile != NULL)
+	{
+		profile->merge_seconds += profile_clock(profile) - started;
+		profile->lalr_states = lalr->num_states;
+	}
 	return lalr;
 }
 
@@ -433,13 +546,8 @@ void free_lr1_automaton(lr1_automaton *automaton)
 		return;
 	}
 
-	for (int i = 0; i < automaton->num_states; i++)
-	{
-		free_lr1_state(&automaton->states[i]);
-	}
-
-	free(automaton->states);
-	free(automaton->transitions);
+	// States, their items and the transitions all live in the region.
+	free_arena(&automaton->memory);
 	free(automaton);
 }
 
@@ -472,7 +580,8 @@ void print_lr1_automaton(const lr1_automaton *automaton)
 				{
 					printf(". ");
 				}
-				printf("%s", automaton->g->non_terminals[0].symbol);
+				printf("%s",
+					   automaton->g->non_terminals[entry_start_symbol(automaton->g, item.production_index)].symbol);
 				if (item.dot_position == 1)
 				{
 					printf(" .");
@@ -512,6 +621,159 @@ void print_lalr1_automaton(const lalr1_automaton *automaton)
 	print_lr1_automaton(automaton);
 }
 
+static bool lr1_goto_kernel(const grammar *g, const lr1_state *from_state, int symbol_id, lr1_state *out_state)
+{
+	// Reuse the output buffer: construction computes every GOTO kernel into one scratch state.
+	out_state->num_items = 0;
+
+	for (int i = 0; i < from_state->num_items; i++)
+	{
+		lr1_item item = from_state->items[i];
+		int next_symbol = get_item_rhs_symbol(g, &item, item.dot_position);
+		if (next_symbol != symbol_id)
+		{
+			continue;
+		}
+
+		item.dot_position++;
+		if (!add_lr1_item_unique(out_state, item))
+		{
+			free_lr1_state(out_state);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool close_state(const grammar *g, const first_context *ctx, lr1_state *state, int eof_lookahead_id)
+{
+	const int lookahead_count = g->num_terminals + 1;
+	bool *lookahead_buffer = ctx->lookahead_buffer;
+	const int initial_count = state->num_items;
+
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+
+		// Snapshot current size because closure expansion can append new items.
+		const int base_count = state->num_items;
+		for (int item_index = 0; item_index < base_count; item_index++)
+		{
+			lr1_item item = state->items[item_index];
+
+			int next_symbol = get_item_rhs_symbol(g, &item, item.dot_position);
+			if (next_symbol < g->num_terminals)
+			{
+				continue;
+			}
+
+			int non_terminal_id = next_symbol - g->num_terminals;
+			if (non_terminal_id < 0 || non_terminal_id >= g->num_non_terminals)
+			{
+				continue;
+			}
+
+			memset(lookahead_buffer, 0, (size_t)lookahead_count * sizeof(bool));
+			if (ctx->lr0_items)
+			{
+				lookahead_buffer[eof_lookahead_id] = true;
+			}
+			else if (!compute_first_of_suffix_with_lookahead(
+					g,
+					ctx,
+					&item,
+					item.dot_position,
+					eof_lookahead_id,
+					lookahead_buffer,
+					lookahead_count))
+			{
+				return false;
+			}
+
+			for (int production_index = 0; production_index < g->num_productions; production_index++)
+			{
+				if (g->productions[production_index].non_terminal_id != non_terminal_id)
+				{
+					continue;
+				}
+
+				for (int la = 0; la < lookahead_count; la++)
+				{
+					if (!lookahead_buffer[la])
+					{
+						continue;
+					}
+
+					const int before_count = state->num_items;
+					lr1_item new_item;
+					new_item.production_index = production_index;
+					new_item.dot_position = 0;
+					new_item.lookahead_id = la;
+
+					if (!add_lr1_item_unique(state, new_item))
+					{
+						return false;
+					}
+
+					if (state->num_items > before_count)
+					{
+						changed = true;
+					}
+				}
+			}
+		}
+	}
+
+	if (ctx->profile != NULL)
+	{
+		ctx->profile->closure_calls++;
+		ctx->profile->items_created += state->num_items - initial_count;
+	}
+	sort_state_items(state);
+	return true;
+}
+
+static bool copy_state_items(const lr1_state *source, lr1_state *destination)
+{
+	if (!ensure_state_capacity(destination, source->num_items))
+	{
+		return false;
+	}
+
+	if (source->num_items > 0)
+	{
+		memcpy(destination->items, source->items, (size_t)source->num_items * sizeof(lr1_item));
+	}
+	destination->num_items = source->num_items;
+	return true;
+}
+
+static double profile_clock(const automaton_profile *profile)
+{
+	// Skip the clock read entirely on unprofiled builds.
+	if (profile == NULL)
+	{
+		return 0.0;
+	}
+
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void record_region_use(automaton_profile *profile, const arena *region, size_t other_live_bytes)
+{
+	// Regions only grow until freed, so the peak falls just before one of them is released.
+	profile->bytes_allocated += region->bytes_used;
+	size_t live_bytes = region->bytes_reserved + other_live_bytes;
+	if (live_bytes > profile->peak_bytes)
+	{
+		profile->peak_bytes = live_bytes;
+	}
+}
+
 static bool ensure_state_capacity(lr1_state *state, int min_capacity)
 {
 	if (state->capacity >= min_capacity)
@@ -525,7 +787,18 @@ static bool ensure_state_capacity(lr1_state *state, int min_capacity)
 		new_capacity *= 2;
 	}
 
-	lr1_item *resized = (lr1_item *)realloc(state->items, (size_t)new_capacity * sizeof(lr1_item));
+	lr1_item *resized;
+	if (state->memory != NULL)
+	{
+		resized = (lr1_item *)arena_grow(state->memory,
+										 state->items,
+										 (size_t)state->capacity * sizeof(lr1_item),
+										 (size_t)new_capacity * sizeof(lr1_item));
+	}
+	else
+	{
+		resized = (lr1_item *)realloc(state->items, (size_t)new_capacity * sizeof(lr1_item));
+	}
 	if (resized == NULL)
 	{
 		return false;
@@ -554,13 +827,16 @@ static int find_terminal_id(const grammar *g, const char *name)
 	return -1;
 }
 
-static bool build_first_context(const grammar *g, first_context *ctx)
+static bool build_first_context(const grammar *g, first_context *ctx, automaton_profile *profile)
 {
 	if (g == NULL || ctx == NULL)
 	{
 		return false;
 	}
 
+	ctx->profile = profile;
+	double started = profile_clock(profile);
+
 	const int nt_count = g->num_non_terminals;
 	const int t_count = g->num_terminals;
 	if (nt_count <= 0 || t_count <= 0)
@@ -568,9 +844,11 @@ static bool build_first_context(const grammar *g, first_context *ctx)
 		return false;
 	}
 
-	ctx->first_table = (bool *)calloc((size_t)nt_count * (size_t)t_count, sizeof(bool));
-	ctx->nullable = (bool *)calloc((size_t)nt_count, sizeof(bool));
-	if (ctx->first_table == NULL || ctx->nullable == NULL)
+	init_arena(&ctx->memory, 0);
+	ctx->first_table = (bool *)arena_calloc(&ctx->memory, (size_t)nt_count * (size_t)t_count, sizeof(bool));
+	ctx->nullable = (bool *)arena_calloc(&ctx->memory, (size_t)nt_count, sizeof(bool));
+	ctx->lookahead_buffer = (bool *)arena_calloc(&ctx->memory, (size_t)t_count + 1, sizeof(bool));
+	if (ctx->first_table == NULL || ctx->nullable == NULL || ctx->lookahead_buffer == NULL)
 	{
 		free_first_context(ctx);
 		return false;
@@ -662,6 +940,10 @@ static bool build_first_context(const grammar *g, first_context *ctx)
 		}
 	}
 
+	if (profile != NULL)
+	{
+		profile->first_seconds += profile_clock(profile) - started;
+	}
 	return true;
 }
 
@@ -672,13 +954,134 @@ static void free_first_context(first_context *ctx)
 		return;
 	}
 
-	free(ctx->first_table);
-	free(ctx->nullable);
+	free_arena(&ctx->memory);
 	ctx->first_table = NULL;
 	ctx->nullable = NULL;
+	ctx->lookahead_buffer = NULL;
 	ctx->epsilon_id = -1;
 }
 
+static bool *build_follow_table(const grammar *g, const first_context *ctx)
+{
+	const int width = g->num_terminals + 1;
+	bool *follow = (bool *)calloc((size_t)g->num_non_terminals * (size_t)width, sizeof(bool));
+	if (follow == NULL)
+	{
+		return NULL;
+	}
+
+	// Every entry point can be followed by EOF.
+	for (int entry = 0; entry < g->num_start_symbols; entry++)
+	{
+		follow[g->start_symbol_ids[entry] * width + g->num_terminals] = true;
+	}
+
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+
+		for (int p = 0; p < g->num_productions; p++)
+		{
+			production prod = g->productions[p];
+			for (int i = 0; i < prod.production_length; i++)
+			{
+				int B = prod.production_symbol_ids[i] - g->num_terminals;
+				if (B < 0 || B >= g->num_non_terminals)
+				{
+					continue;
+				}
+
+				// FIRST of what follows B, then FOLLOW of the left side when all of it can vanish.
+				bool suffix_nullable = true;
+				for (int j = i + 1; j < prod.production_length && suffix_nullable; j++)
+				{
+					int encoded = prod.production_symbol_ids[j];
+					if (encoded < g->num_terminals)
+					{
+						if (encoded == ctx->epsilon_id)
+						{
+							continue;
+						}
+						if (!follow[B * width + encoded])
+						{
+							follow[B * width + encoded] = true;
+							changed = true;
+						}
+						suffix_nullable = false;
+						continue;
+					}
+
+					int C = encoded - g->num_terminals;
+					for (int t = 0; t < g->num_terminals; t++)
+					{
+						if (t != ctx->epsilon_id && ctx->first_table[C * g->num_terminals + t] && !follow[B * width + t])
+						{
+							follow[B * width + t] = true;
+							changed = true;
+						}
+					}
+					suffix_nullable = ctx->nullable[C];
+				}
+
+				if (!suffix_nullable)
+				{
+					continue;
+				}
+				for (int t = 0; t < width; t++)
+				{
+					if (follow[prod.non_terminal_id * width + t] && !follow[B * width + t])
+					{
+						follow[B * width + t] = true;
+						changed = true;
+					}
+				}
+			}
+		}
+	}
+
+	return follow;
+}
+
+static bool add_follow_lookaheads(const grammar *g, const bool *follow, const lr1_state *lr0_state, lr1_state *out_state)
+{
+	const int width = g->num_terminals + 1;
+
+	out_state->num_items = 0;
+	for (int i = 0; i < lr0_state->num_items; i++)
+	{
+		lr1_item item = lr0_state->items[i];
+		if (item.production_index < 0)
+		{
+			if (!ensure_state_capacity(out_state, out_state->num_items + 1))
+			{
+				return false;
+			}
+			out_state->items[out_state->num_items++] = item;
+			continue;
+		}
+
+		// LR(0) items are unique per core, so appending cannot create duplicates.
+		const bool *lookaheads = &follow[g->productions[item.production_index].non_terminal_id * width];
+		for (int la = 0; la < width; la++)
+		{
+			if (!lookaheads[la])
+			{
+				continue;
+			}
+			if (!ensure_state_capacity(out_state, out_state->num_items + 1))
+			{
+				return false;
+			}
+			item.lookahead_id = la;
+			out_state->items[out_state->num_items++] = item;
+		}
+	}
+
+	sort_state_items(out_state);
+	return true;
+}
+
 static int get_item_rhs_symbol(const grammar *g, const lr1_item *item, int offset)
 {
 	if (g == NULL || item == NULL)
@@ -690,7 +1093,7 @@ static int get_item_rhs_symbol(const grammar *g, const lr1_item *item, int offse
 	{
 		if (offset == 0)
 		{
-			return g->num_terminals;
+			return g->num_terminals + entry_start_symbol(g, item->production_index);
 		}
 		return -1;
 	}
@@ -709,6 +1112,17 @@ static int get_item_rhs_symbol(const grammar *g, const lr1_item *item, int offse
 	return p.production_symbol_ids[offset];
 }
 
+static int entry_start_symbol(const grammar *g, int production_index)
+{
+	// Augmented production -1 - k belongs to entry point k.
+	int entry = -1 - production_index;
+	if (entry < 0 || entry >= g->num_start_symbols)
+	{
+		return 0;
+	}
+	return g->start_symbol_ids[entry];
+}
+
 static int get_item_rhs_length(const grammar *g, const lr1_item *item)
 {
 	if (g == NULL || item == NULL)
@@ -807,7 +1221,12 @@ static bool compute_first_of_suffix_with_lookahead(
 	return true;
 }
 
-static bool add_transition_unique(lr1_automaton *automaton, int from_state, int symbol_id, int to_state)
+static bool add_transition_unique(
+	lr1_automaton *automaton,
+	int from_state,
+	int symbol_id,
+	int to_state,
+	automaton_profile *profile)
 {
 	if (automaton == NULL)
 	{
@@ -816,6 +1235,10 @@ static bool add_transition_unique(lr1_automaton *automaton, int from_state, int
 
 	for (int i = 0; i < automaton->num_transitions; i++)
 	{
+		if (profile != NULL)
+		{
+			profile->transition_probes++;
+		}
 		lr1_transition existing = automaton->transitions[i];
 		if (existing.from_state == from_state && existing.symbol_id == symbol_id && existing.to_state == to_state)
 		{
@@ -850,7 +1273,10 @@ static bool ensure_states_capacity(lr1_automaton *automaton, int min_capacity)
 		new_capacity *= 2;
 	}
 
-	lr1_state *resized = (lr1_state *)realloc(automaton->states, (size_t)new_capacity * sizeof(lr1_state));
+	lr1_state *resized = (lr1_state *)arena_grow(&automaton->memory,
+												 automaton->states,
+												 (size_t)automaton->states_capacity * sizeof(lr1_state),
+												 (size_t)new_capacity * sizeof(lr1_state));
 	if (resized == NULL)
 	{
 		return false;
@@ -879,8 +1305,10 @@ static bool ensure_transitions_capacity(lr1_automaton *automaton, int min_capaci
 		new_capacity *= 2;
 	}
 
-	lr1_transition *resized =
-		(lr1_transition *)realloc(automaton->transitions, (size_t)new_capacity * sizeof(lr1_transition));
+	lr1_transition *resized = (lr1_transition *)arena_grow(&automaton->memory,
+														   automaton->transitions,
+														   (size_t)automaton->transitions_capacity * sizeof(lr1_transition),
+														   (size_t)new_capacity * sizeof(lr1_transition));
 	if (resized == NULL)
 	{
 		return false;
@@ -956,7 +1384,7 @@ static bool states_equal(const lr1_state *left, const lr1_state *right)
 	return true;
 }
 
-static int find_state_index(const lr1_automaton *automaton, const lr1_state *state)
+static int find_state_index(const lr1_automaton *automaton, const lr1_state *state, automaton_profile *profile)
 {
 	if (automaton == NULL || state == NULL)
 	{
@@ -965,6 +1393,10 @@ static int find_state_index(const lr1_automaton *automaton, const lr1_state *sta
 
 	for (int i = 0; i < automaton->num_states; i++)
 	{
+		if (profile != NULL)
+		{
+			profile->state_probes++;
+		}
 		if (states_equal(&automaton->states[i], state))
 		{
 			return i;
@@ -987,12 +1419,12 @@ static bool append_state_copy(lr1_automaton *automaton, const lr1_state *state,
 	}
 
 	lr1_state *destination = &automaton->states[automaton->num_states];
-	free_lr1_state(destination);
 	init_lr1_state(destination);
+	destination->memory = &automaton->memory;
 
 	if (state->num_items > 0)
 	{
-		destination->items = (lr1_item *)malloc((size_t)state->num_items * sizeof(lr1_item));
+		destination->items = (lr1_item *)arena_alloc(&automaton->memory, (size_t)state->num_items * sizeof(lr1_item));
 		if (destination->items == NULL)
 		{
 			return false;
@@ -1027,15 +1459,19 @@ static bool collect_goto_symbols(const grammar *g, const lr1_state *state, bool
 	return true;
 }
 
-static bool build_kernel_signature(const lr1_state *state, kernel_signature *signature)
+static bool build_kernel_signature(const lr1_state *state, kernel_signature *signature, arena *scratch)
 {
 	if (state == NULL || signature == NULL)
 	{
 		return false;
 	}
 
-	signature->items = NULL;
+	signature->items = (core_item *)arena_alloc(scratch, (size_t)state->num_items * sizeof(core_item));
 	signature->count = 0;
+	if (signature->items == NULL)
+	{
+		return false;
+	}
 
 	for (int i = 0; i < state->num_items; i++)
 	{
@@ -1050,14 +1486,6 @@ static bool build_kernel_signature(const lr1_state *state, kernel_signature *sig
 		core.production_index = item.production_index;
 		core.dot_position = item.dot_position;
 
-		core_item *resized =
-			(core_item *)realloc(signature->items, (size_t)(signature->count + 1) * sizeof(core_item));
-		if (resized == NULL)
-		{
-			free_kernel_signature(signature);
-			return false;
-		}
-		signature->items = resized;
 		signature->items[signature->count++] = core;
 	}
 
@@ -1084,18 +1512,6 @@ static bool build_kernel_signature(const lr1_state *state, kernel_signature *sig
 	return true;
 }
 
-static void free_kernel_signature(kernel_signature *signature)
-{
-	if (signature == NULL)
-	{
-		return;
-	}
-
-	free(signature->items);
-	signature->items = NULL;
-	signature->count = 0;
-}
-
 static bool equal_kernel_signatures(const kernel_signature *left, const kernel_signature *right)
 {
 	if (left == NULL || right == NULL)
@@ -1121,19 +1537,24 @@ static bool equal_kernel_signatures(const kernel_signature *left, const kernel_s
 	return true;
 }
 
-static bool build_state_group_map(const lr1_automaton *lr1, int **out_state_group, int *out_group_count)
+static bool build_state_group_map(
+	const lr1_automaton *lr1,
+	arena *scratch,
+	automaton_profile *profile,
+	int **out_state_group,
+	int *out_group_count)
 {
-	if (lr1 == NULL || out_state_group == NULL || out_group_count == NULL)
+	if (lr1 == NULL || scratch == NULL || out_state_group == NULL || out_group_count == NULL)
 	{
 		return false;
 	}
 
 	int *state_group = (int *)malloc((size_t)lr1->num_states * sizeof(int));
-	kernel_signature *group_signatures = (kernel_signature *)calloc((size_t)lr1->num_states, sizeof(kernel_signature));
+	kernel_signature *group_signatures =
+		(kernel_signature *)arena_alloc(scratch, (size_t)lr1->num_states * sizeof(kernel_signature));
 	if (state_group == NULL || group_signatures == NULL)
 	{
 		free(state_group);
-		free(group_signatures);
 		return false;
 	}
 
@@ -1141,13 +1562,8 @@ static bool build_state_group_map(const lr1_automaton *lr1, int **out_state_grou
 	for (int s = 0; s < lr1->num_states; s++)
 	{
 		kernel_signature sig;
-		if (!build_kernel_signature(&lr1->states[s], &sig))
+		if (!build_kernel_signature(&lr1->states[s], &sig, scratch))
 		{
-			for (int i = 0; i < group_count; i++)
-			{
-				free_kernel_signature(&group_signatures[i]);
-			}
-			free(group_signatures);
 			free(state_group);
 			return false;
 		}
@@ -1155,6 +1571,10 @@ static bool build_state_group_map(const lr1_automaton *lr1, int **out_state_grou
 		int assigned_group = -1;
 		for (int g = 0; g < group_count; g++)
 		{
+			if (profile != NULL)
+			{
+				profile->state_probes++;
+			}
 			if (equal_kernel_signatures(&sig, &group_signatures[g]))
 			{
 				assigned_group = g;
@@ -1168,20 +1588,10 @@ static bool build_state_group_map(const lr1_automaton *lr1, int **out_state_grou
 			group_signatures[group_count] = sig;
 			group_count++;
 		}
-		else
-		{
-			free_kernel_signature(&sig);
-		}
 
 		state_group[s] = assigned_group;
 	}
 
-	for (int i = 0; i < group_count; i++)
-	{
-		free_kernel_signature(&group_signatures[i]);
-	}
-	free(group_signatures);
-
 	*out_state_group = state_group;
 	*out_group_count = group_count;
 	return true;
@@ -1194,8 +1604,7 @@ static bool merge_group_items(const lr1_automaton *lr1, const int *state_group,
 		return false;
 	}
 
-	free_lr1_state(out_state);
-	init_lr1_state(out_state);
+	out_state->num_items = 0;
 
 	for (int s = 0; s < lr1->num_states; s++)
 	{
@@ -2,6 +2,7 @@
 #define AUTOMATON_H
 
 #include <stdbool.h>
+#include "arena.h"
 #include "grammar.h"
 
 typedef struct lr1_item
@@ -16,6 +17,8 @@ typedef struct lr1_state
 	lr1_item *items;
 	int num_items;
 	int capacity;
+	// Region that owns items, or NULL when they are on the heap.
+	arena *memory;
 } lr1_state;
 
 typedef struct lr1_transition
@@ -35,10 +38,35 @@ typedef struct lr1_automaton
 	lr1_transition *transitions;
 	int num_transitions;
 	int transitions_capacity;
+	// Owns the states, their items and the transitions; freed in one go.
+	arena memory;
 } lr1_automaton;
 
 typedef lr1_automaton lalr1_automaton;
 
+typedef struct automaton_profile
+{
+	// Wall-clock seconds spent in each construction phase.
+	double first_seconds;
+	double closure_seconds;
+	double goto_seconds;
+	double dedup_seconds;
+	double merge_seconds;
+	int lr1_states;
+	int lalr_states;
+	// Work done: closures computed, items they and GOTO added, GOTO kernels computed.
+	long closure_calls;
+	long items_created;
+	long goto_calls;
+	// States (or LALR kernel groups) and transitions compared during the lookups that
+	// deduplicate them.
+	long state_probes;
+	long transition_probes;
+	// Region bytes handed out during the build, and the most reserved at one time.
+	size_t bytes_allocated;
+	size_t peak_bytes;
+} automaton_profile;
+
 /**
  * @brief Initializes an empty LR(1) state.
  * @param state State object to initialize.
@@ -93,6 +121,34 @@ bool lr1_goto(
  */
 lr1_automaton *build_lr1_automaton(const grammar *g);
 
+/**
+ * @brief Builds the canonical LR(1) automaton like build_lr1_automaton and profiles it.
+ * @param g Parsed grammar.
+ * @param profile Zero-initialized profile to accumulate into; may be NULL.
+ * @return Newly allocated automaton, or NULL on failure.
+ */
+lr1_automaton *build_lr1_automaton_profiled(const grammar *g, automaton_profile *profile);
+
+/**
+ * @brief Builds the SLR(1) automaton for the grammar.
+ *
+ * States are the LR(0) item sets. Every item of a production A -> ... carries
+ * each terminal of FOLLOW(A) as a lookahead, so the table builder reduces on
+ * FOLLOW(A) like in SLR(1).
+ *
+ * @param g Parsed grammar.
+ * @return Newly allocated automaton, or NULL on failure.
+ */
+lr1_automaton *build_slr1_automaton(const grammar *g);
+
+/**
+ * @brief Builds the SLR(1) automaton like build_slr1_automaton and profiles it.
+ * @param g Parsed grammar.
+ * @param profile Zero-initialized profile to accumulate into; may be NULL.
+ * @return Newly allocated automaton, or NULL on failure.
+ */
+lr1_automaton *build_slr1_automaton_profiled(const grammar *g, automaton_profile *profile);
+
 /**
  * @brief Builds an LALR(1) automaton by merging LR(1) states with equal kernels.
  * @param g Parsed grammar.
@@ -100,6 +156,19 @@ lr1_automaton *build_lr1_automaton(const grammar *g);
  */
 lalr1_automaton *build_lalr1_automaton(const grammar *g);
 
+/**
+ * @brief Builds an LALR(1) automaton like build_lalr1_automaton and times its phases.
+ *
+ * FIRST sets, closure, GOTO kernel computation, state deduplication and the LALR
+ * kernel merge are timed separately and added to the profile, which also receives
+ * the LR(1) and LALR(1) state counts, the work counters and the region memory used.
+ *
+ * @param g Parsed grammar.
+ * @param profile Zero-initialized profile to accumulate into; may be NULL.
+ * @return Newly allocated LALR(1) automaton, or NULL on failure.
+ */
+lalr1_automaton *build_lalr1_automaton_profiled(const grammar *g, automaton_profile *profile);
+
 /**
  * @brief Releases all memory owned by an LR(1) automaton object.
  * @param automaton Automaton to free.
@@ -0,0 +1,759 @@
+#include "glr.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct glr_link
+{
+    struct glr_node *to;
+    struct glr_link *next;
+    // Creation order; bounds which links a pending reduction may walk.
+    long seq;
+} glr_link;
+
+typedef struct glr_node
+{
+    int state;
+    glr_link *links;
+    // Hint that every node below has a single link; checked again before joining.
+    bool linear;
+} glr_node;
+
+typedef struct glr_reduction
+{
+    glr_node *node;
+    int production_index;
+    // Paths must go through this link when set, and may only use links created before limit.
+    const glr_link *required;
+    long limit;
+} glr_reduction;
+
+typedef struct glr_block
+{
+    struct glr_block *next;
+    size_t used;
+    size_t capacity;
+    max_align_t data[];
+} glr_block;
+
+static push_parser_status feed_linear(glr_parser *parser, int terminal_or_eof_id, const char *lexeme, bool *out_split);
+static push_parser_status feed_split(glr_parser *parser, int terminal_or_eof_id, const char *lexeme);
+static bool split_stack(glr_parser *parser);
+static void try_join(glr_parser *parser);
+static bool enqueue_reductions(glr_parser *parser, glr_node *node, int terminal_or_eof_id, const glr_link *required, long limit);
+static bool walk_paths(glr_parser *parser, glr_node *node, int remaining, const glr_reduction *reduction, bool found_required, int terminal_or_eof_id);
+static bool perform_reduction(glr_parser *parser, glr_node *below, int production_index, int terminal_or_eof_id);
+static int load_cell_actions(glr_parser *parser, int state_id, int terminal_or_eof_id);
+static glr_node *find_head(glr_node **heads, int num_heads, int state_id);
+static bool append_head(glr_node ***heads, int *num_heads, int *capacity, glr_node *node);
+static glr_node *create_node(glr_parser *parser, int state_id);
+static glr_link *add_link(glr_parser *parser, glr_node *from, glr_node *to);
+static bool has_link(const glr_node *from, const glr_node *to);
+static void *glr_alloc(glr_parser *parser, size_t size);
+static void release_blocks(glr_parser *parser);
+static bool push_state(glr_parser *parser, int state_id);
+static int reduction_pop_count(const glr_parser *parser, production p);
+static push_parser_status fail(glr_parser *parser, const char *internal_error);
+static void trace_reduce(const glr_parser *parser, int production_index);
+static void trace_lookahead(const glr_parser *parser, const char *lexeme);
+
+glr_parser *create_glr_parser(const parser_table *table)
+{
+    return create_glr_parser_for_entry(table, 0);
+}
+
+glr_parser *create_glr_parser_for_entry(const parser_table *table, int entry)
+{
+    int start_state = get_parser_entry_state(table, entry);
+    if (table == NULL || table->g == NULL || start_state < 0)
+    {
+        return NULL;
+    }
+
+    glr_parser *parser = (glr_parser *)calloc(1, sizeof(glr_parser));
+    if (parser == NULL)
+    {
+        return NULL;
+    }
+
+    parser->table = table;
+    parser->capacity = 64;
+    parser->states = (int *)malloc((size_t)parser->capacity * sizeof(int));
+    if (parser->states == NULL)
+    {
+        free(parser);
+        return NULL;
+    }
+    parser->states[parser->size++] = start_state;
+    parser->error_state = -1;
+
+    parser->epsilon_id = -1;
+    const grammar *g = table->g;
+    for (int i = 0; i < g->num_terminals; i++)
+    {
+        if (strcmp(g->terminals[i].symbol, "epsilon") == 0)
+        {
+            parser->epsilon_id = i;
+            break;
+        }
+    }
+
+    return parser;
+}
+
+void free_glr_parser(glr_parser *parser)
+{
+    if (parser == NULL)
+    {
+        return;
+    }
+
+    release_blocks(parser);
+    free(parser->states);
+    free(parser->heads);
+    free(parser->next_heads);
+    free(parser->reductions);
+    free(parser->cell_actions);
+    free(parser);
+}
+
+push_parser_status glr_parser_feed(glr_parser *parser, int terminal_or_eof_id, const char *lexeme)
+{
+    if (parser == NULL || parser->finished)
+    {
+        return PUSH_PARSER_ERROR;
+    }
+
+    if (!parser->split)
+    {
+        bool needs_split = false;
+        push_parser_status status = feed_linear(parser, terminal_or_eof_id, lexeme, &needs_split);
+        if (!needs_split)
+        {
+            return status;
+        }
+        if (!split_stack(parser))
+        {
+            return fail(parser, "Out of memory while splitting the parser stack.");
+        }
+    }
+
+    return feed_split(parser, terminal_or_eof_id, lexeme);
+}
+
+static push_parser_status feed_linear(glr_parser *parser, int terminal_or_eof_id, const char *lexeme, bool *out_split)
+{
+    const parser_table *table = parser->table;
+    const grammar *g = table->g;
+
+    while (true)
+    {
+        int state_id = parser->states[parser->size - 1];
+        if (has_parser_action_conflict(table, state_id, terminal_or_eof_id))
+        {
+            *out_split = true;
+            return PUSH_PARSER_NEED_MORE;
+        }
+
+        if (parser->trace != NULL)
+        {
+            fprintf(parser->trace, "\n============================\n");
+            fprintf(parser->trace, "Top state: %d\n", state_id);
+            trace_lookahead(parser, lexeme);
+        }
+
+        parser_action action = get_parser_action(table, state_id, terminal_or_eof_id);
+
+        if (action.type == PARSER_ACTION_SHIFT)
+        {
+            if (parser->trace != NULL)
+            {
+                fprintf(parser->trace, "Action: SHIFT to state %d\n", action.value);
+            }
+            if (!push_state(parser, action.value))
+            {
+                return fail(parser, "Parser stack overflow while shifting.");
+            }
+            return PUSH_PARSER_NEED_MORE;
+        }
+
+        if (action.type == PARSER_ACTION_REDUCE)
+        {
+            trace_reduce(parser, action.value);
+            if (action.value < 0 || action.value >= g->num_productions)
+            {
+                return fail(parser, "Invalid reduction production index.");
+            }
+
+            production p = g->productions[action.value];
+            int pop_count = reduction_pop_count(parser, p);
+            if (parser->size - pop_count <= 0)
+            {
+                return fail(parser, "Invalid parser stack pop for reduction.");
+            }
+            parser->size -= pop_count;
+
+            int goto_state = get_parser_goto(table, parser->states[parser->size - 1], p.non_terminal_id);
+            if (goto_state < 0)
+            {
+                return fail(parser, "Missing GOTO after reduction.");
+            }
+            if (!push_state(parser, goto_state))
+            {
+                return fail(parser, "Parser stack overflow after reduction.");
+            }
+            continue;
+        }
+
+        if (action.type == PARSER_ACTION_ACCEPT)
+        {
+            if (parser->trace != NULL)
+            {
+                fprintf(parser->trace, "Action: ACCEPT\n");
+            }
+            parser->finished = true;
+            return PUSH_PARSER_ACCEPT;
+        }
+
+        if (parser->trace != NULL)
+        {
+            fprintf(parser->trace, "Action: ERROR\n");
+        }
+        parser->error_state = state_id;
+        return fail(parser, NULL);
+    }
+}
+
+static push_parser_status feed_split(glr_parser *parser, int terminal_or_eof_id, const char *lexeme)
+{
+    const parser_table *table = parser->table;
+    const int eof_id = table->g->num_terminals;
+
+    parser->split_tokens++;
+    if (parser->trace != NULL)
+    {
+        fprintf(parser->trace, "\n============================\n");
+        fprintf(parser->trace, "Stack heads: %d\n", parser->num_heads);
+        trace_lookahead(parser, lexeme);
+    }
+
+    // 1) Reduce: every head, and every head a reduction creates, follows all its reductions.
+    parser->num_reductions = 0;
+    long limit = ++parser->link_counter;
+    for (int i = 0; i < parser->num_heads; i++)
+    {
+        if (!enqueue_reductions(parser, parser->heads[i], terminal_or_eof_id, NULL, limit))
+        {
+            return fail(parser, "Out of memory while reducing.");
+        }
+    }
+
+    for (int i = 0; i < parser->num_reductions; i++)
+    {
+        // Copied: processing may grow (and move) the queue.
+        glr_reduction reduction = parser->reductions[i];
+        int pop_count = reduction_pop_count(parser, table->g->productions[reduction.production_index]);
+        if (!walk_paths(parser, reduction.node, pop_count, &reduction, false, terminal_or_eof_id))
+        {
+            return fail(parser, parser->internal_error != NULL ? parser->internal_error : "Out of memory while reducing.");
+        }
+    }
+
+    if (parser->num_heads > parser->max_heads)
+    {
+        parser->max_heads = parser->num_heads;
+    }
+
+    if (terminal_or_eof_id == eof_id)
+    {
+        for (int i = 0; i < parser->num_heads; i++)
+        {
+            int count = load_cell_actions(parser, parser->heads[i]->state, eof_id);
+            for (int a = 0; a < count; a++)
+            {
+                if (parser->cell_actions[a].type == PARSER_ACTION_ACCEPT)
+                {
+                    if (parser->trace != NULL)
+                    {
+                        fprintf(parser->trace, "Action: ACCEPT\n");
+                    }
+                    parser->finished = true;
+                    return PUSH_PARSER_ACCEPT;
+                }
+            }
+        }
+    }
+
+    // 2) Shift: heads shifting into the same state share one new node.
+    int num_next = 0;
+    for (int i = 0; i < parser->num_heads; i++)
+    {
+        glr_node *head = parser->heads[i];
+        int count = load_cell_actions(parser, head->state, terminal_or_eof_id);
+        for (int a = 0; a < count; a++)
+        {
+            if (parser->cell_actions[a].type != PARSER_ACTION_SHIFT)
+            {
+                continue;
+            }
+
+            glr_node *target = find_head(parser->next_heads, num_next, parser->cell_actions[a].value);
+            if (target == NULL)
+            {
+                target = create_node(parser, parser->cell_actions[a].value);
+                if (target == NULL ||
+                    !append_head(&parser->next_heads, &num_next, &parser->next_heads_capacity, target))
+                {
+                    return fail(parser, "Out of memory while shifting.");
+                }
+                target->linear = head->linear;
+            }
+            else
+            {
+                target->linear = false;
+            }
+
+            if (add_link(parser, target, head) == NULL)
+            {
+                return fail(parser, "Out of memory while shifting.");
+            }
+        }
+    }
+
+    if (num_next == 0)
+    {
+        if (parser->trace != NULL)
+        {
+            fprintf(parser->trace, "Action: ERROR\n");
+        }
+        parser->error_state = parser->num_heads > 0 ? parser->heads[0]->state : -1;
+        return fail(parser, NULL);
+    }
+
+    if (parser->trace != NULL)
+    {
+        fprintf(parser->trace, "Action: SHIFT on %d stack(s)\n", num_next);
+    }
+
+    glr_node **heads = parser->heads;
+    int heads_capacity = parser->heads_capacity;
+    parser->heads = parser->next_heads;
+    parser->heads_capacity = parser->next_heads_capacity;
+    parser->num_heads = num_next;
+    parser->next_heads = heads;
+    parser->next_heads_capacity = heads_capacity;
+
+    try_join(parser);
+    return PUSH_PARSER_NEED_MORE;
+}
+
+static bool split_stack(glr_parser *parser)
+{
+    glr_node *below = NULL;
+
+    for (int i = 0; i < parser->size; i++)
+    {
+        glr_node *node = create_node(parser, parser->states[i]);
+        if (node == NULL || (below != NULL && add_link(parser, node, below) == NULL))
+        {
+            return false;
+        }
+        node->linear = true;
+        below = node;
+    }
+
+    parser->num_heads = 0;
+    if (!append_head(&parser->heads, &parser->num_heads, &parser->heads_capacity, below))
+    {
+        return false;
+    }
+
+    parser->split = true;
+    if (parser->trace != NULL)
+    {
+        fprintf(parser->trace, "Action: SPLIT on conflicting actions\n");
+    }
+    return true;
+}
+
+static void try_join(glr_parser *parser)
+{
+    if (parser->num_heads != 1 || !parser->heads[0]->linear)
+    {
+        return;
+    }
+
+    int depth = 0;
+    for (const glr_node *node = parser->heads[0]; node != NULL; node = node->links != NULL ? node->links->to : NULL)
+    {
+        if (node->links != NULL && node->links->next != NULL)
+        {
+            return;
+        }
+        depth++;
+    }
+
+    while (parser->capacity < depth)
+    {
+        int new_capacity = parser->capacity * 2;
+        int *resized = (int *)realloc(parser->states, (size_t)new_capacity * sizeof(int));
+        if (resized == NULL)
+        {
+            // Stay on the graph-structured stack; it is still correct.
+            return;
+        }
+        parser->states = resized;
+        parser->capacity = new_capacity;
+    }
+
+    parser->size = depth;
+    int index = depth - 1;
+    for (const glr_node *node = parser->heads[0]; node != NULL; node = node->links != NULL ? node->links->to : NULL)
+    {
+        parser->states[index--] = node->state;
+    }
+
+    parser->split = false;
+    parser->num_heads = 0;
+    release_blocks(parser);
+}
+
+static bool enqueue_reductions(glr_parser *parser, glr_node *node, int terminal_or_eof_id, const glr_link *required, long limit)
+{
+    const grammar *g = parser->table->g;
+    int count = load_cell_actions(parser, node->state, terminal_or_eof_id);
+
+    for (int a = 0; a < count; a++)
+    {
+        parser_action action = parser->cell_actions[a];
+        if (action.type != PARSER_ACTION_REDUCE || action.value < 0 || action.value >= g->num_productions)
+        {
+            continue;
+        }
+        // Empty reductions do not go through any link.
+        if (required != NULL && reduction_pop_count(parser, g->productions[action.value]) == 0)
+        {
+            continue;
+        }
+
+        if (parser->num_reductions >= parser->reductions_capacity)
+        {
+            int new_capacity = parser->reductions_capacity == 0 ? 64 : parser->reductions_capacity * 2;
+            glr_reduction *resized =
+                (glr_reduction *)realloc(parser->reductions, (size_t)new_capacity * sizeof(glr_reduction));
+            if (resized == NULL)
+            {
+                return false;
+            }
+            parser->reductions = resized;
+            parser->reductions_capacity = new_capacity;
+        }
+
+        glr_reduction *reduction = &parser->reductions[parser->num_reductions++];
+        reduction->node = node;
+        reduction->production_index = action.value;
+        reduction->required = required;
+        reduction->limit = limit;
+    }
+
+    return true;
+}
+
+static bool walk_paths(glr_parser *parser, glr_node *node, int remaining, const glr_reduction *reduction, bool found_required, int terminal_or_eof_id)
+{
+    if (remaining == 0)
+    {
+        if (reduction->required != NULL && !found_required)
+        {
+            return true;
+        }
+        return perform_reduction(parser, node, reduction->production_index, terminal_or_eof_id);
+    }
+
+    for (const glr_link *link = node->links; link != NULL; link = link->next)
+    {
+        // Each path is reduced once: by the plain entry if all its links are older than
+        // the entry, otherwise by the entry queued for its newest link.
+        if (link->seq >= reduction->limit && link != reduction->required)
+        {
+            continue;
+        }
+        if (!walk_paths(parser, link->to, remaining - 1, reduction, found_required || link == reduction->required, terminal_or_eof_id))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool perform_reduction(glr_parser *parser, glr_node *below, int production_index, int terminal_or_eof_id)
+{
+    const parser_table *table = parser->table;
+    production p = table->g->productions[production_index];
+
+    trace_reduce(parser, production_index);
+    int goto_state = get_parser_goto(table, below->state, p.non_terminal_id);
+    if (goto_state < 0)
+    {
+        parser->internal_error = "Missing GOTO after reduction.";
+        return false;
+    }
+
+    glr_node *head = find_head(parser->heads, parser->num_heads, goto_state);
+    if (head != NULL)
+    {
+        if (has_link(head, below))
+        {
+            // Another derivation of the same non-terminal over the same input: pack it.
+            parser->ambiguities++;
+            return true;
+        }
+
+        glr_link *link = add_link(parser, head, below);
+        if (link == NULL)
+        {
+            return false;
+        }
+        head->linear = false;
+
+        // Reductions already done from any head may now have new paths through this link.
+        for (int i = 0; i < parser->num_heads; i++)
+        {
+            if (!enqueue_reductions(parser, parser->heads[i], terminal_or_eof_id, link, link->seq))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    head = create_node(parser, goto_state);
+    if (head == NULL || add_link(parser, head, below) == NULL ||
+        !append_head(&parser->heads, &parser->num_heads, &parser->heads_capacity, head))
+    {
+        return false;
+    }
+    head->linear = below->linear;
+
+    return enqueue_reductions(parser, head, terminal_or_eof_id, NULL, ++parser->link_counter);
+}
+
+static int load_cell_actions(glr_parser *parser, int state_id, int terminal_or_eof_id)
+{
+    int count = get_parser_actions(
+        parser->table, state_id, terminal_or_eof_id, parser->cell_actions, parser->cell_actions_capacity);
+    if (count <= parser->cell_actions_capacity)
+    {
+        return count;
+    }
+
+    parser_action *resized = (parser_action *)realloc(parser->cell_actions, (size_t)count * sizeof(parser_action));
+    if (resized == NULL)
+    {
+        return parser->cell_actions_capacity;
+    }
+    parser->cell_actions = resized;
+    parser->cell_actions_capacity = count;
+
+    return get_parser_actions(parser->table, state_id, terminal_or_eof_id, parser->cell_actions, count);
+}
+
+static glr_node *find_head(glr_node **heads, int num_heads, int state_id)
+{
+    for (int i = 0; i < num_heads; i++)
+    {
+        if (heads[i]->state == state_id)
+        {
+            return heads[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool append_head(glr_node ***heads, int *num_heads, int *capacity, glr_node *node)
+{
+    if (*num_heads >= *capacity)
+    {
+        int new_capacity = *capacity == 0 ? 16 : *capacity * 2;
+        glr_node **resized = (glr_node **)realloc(*heads, (size_t)new_capacity * sizeof(glr_node *));
+        if (resized == NULL)
+        {
+            return false;
+        }
+        *heads = resized;
+        *capacity = new_capacity;
+    }
+
+    (*heads)[(*num_heads)++] = node;
+    return true;
+}
+
+static glr_node *create_node(glr_parser *parser, int state_id)
+{
+    glr_node *node = (glr_node *)glr_alloc(parser, sizeof(glr_node));
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    node->state = state_id;
+    node->links = NULL;
+    node->linear = true;
+    return node;
+}
+
+static glr_link *add_link(glr_parser *parser, glr_node *from, glr_node *to)
+{
+    glr_link *link = (glr_link *)glr_alloc(parser, sizeof(glr_link));
+    if (link == NULL)
+    {
+        return NULL;
+    }
+
+    link->to = to;
+    link->seq = ++parser->link_counter;
+    link->next = from->links;
+    from->links = link;
+    return link;
+}
+
+static bool has_link(const glr_node *from, const glr_node *to)
+{
+    for (const glr_link *link = from->links; link != NULL; link = link->next)
+    {
+        if (link->to == to)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void *glr_alloc(glr_parser *parser, size_t size)
+{
+    size = (size + sizeof(max_align_t) - 1) / sizeof(max_align_t) * sizeof(max_align_t);
+
+    glr_block *block = parser->blocks;
+    if (block == NULL || block->capacity - block->used < size)
+    {
+        size_t capacity = 64 * 1024;
+        if (capacity < size)
+        {
+            capacity = size;
+        }
+
+        block = (glr_block *)malloc(sizeof(glr_block) + capacity);
+        if (block == NULL)
+        {
+            return NULL;
+        }
+        block->next = parser->blocks;
+        block->used = 0;
+        block->capacity = capacity;
+        parser->blocks = block;
+    }
+
+    void *memory = (unsigned char *)block->data + block->used;
+    block->used += size;
+    return memory;
+}
+
+static void release_blocks(glr_parser *parser)
+{
+    while (parser->blocks != NULL)
+    {
+        glr_block *next = parser->blocks->next;
+        free(parser->blocks);
+        parser->blocks = next;
+    }
+}
+
+static bool push_state(glr_parser *parser, int state_id)
+{
+    if (parser->size >= parser->capacity)
+    {
+        int new_capacity = parser->capacity * 2;
+        int *resized = (int *)realloc(parser->states, (size_t)new_capacity * sizeof(int));
+        if (resized == NULL)
+        {
+            return false;
+        }
+        parser->states = resized;
+        parser->capacity = new_capacity;
+    }
+
+    parser->states[parser->size++] = state_id;
+    return true;
+}
+
+static int reduction_pop_count(const glr_parser *parser, production p)
+{
+    int count = 0;
+
+    for (int i = 0; i < p.production_length; i++)
+    {
+        if (p.production_symbol_ids[i] == parser->epsilon_id)
+        {
+            continue;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+static push_parser_status fail(glr_parser *parser, const char *internal_error)
+{
+    parser->finished = true;
+    if (internal_error != NULL)
+    {
+        parser->internal_error = internal_error;
+    }
+    return PUSH_PARSER_ERROR;
+}
+
+static void trace_reduce(const glr_parser *parser, int production_index)
+{
+    const grammar *g = parser->table->g;
+
+    if (parser->trace == NULL || production_index < 0 || production_index >= g->num_productions)
+    {
+        return;
+    }
+
+    production p = g->productions[production_index];
+    fprintf(parser->trace,
+            "Action: REDUCE by p%d: %s -> ",
+            production_index,
+            g->non_terminals[p.non_terminal_id].symbol);
+
+    for (int i = 0; i < p.production_length; i++)
+    {
+        int symbol_id = p.production_symbol_ids[i];
+        if (symbol_id < g->num_terminals)
+        {
+            fprintf(parser->trace, "%s ", g->terminals[symbol_id].symbol);
+        }
+        else
+        {
+            fprintf(parser->trace, "%s ", g->non_terminals[symbol_id - g->num_terminals].symbol);
+        }
+    }
+    fprintf(parser->trace, "\n");
+}
+
+static void trace_lookahead(const glr_parser *parser, const char *lexeme)
+{
+    if (lexeme == NULL || lexeme[0] == '\0')
+    {
+        fprintf(parser->trace, "Lookahead: $\n");
+    }
+    else
+    {
+        fprintf(parser->trace, "Lookahead: %s\n", lexeme);
+    }
+}
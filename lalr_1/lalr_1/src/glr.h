@@ -0,0 +1,91 @@
+#ifndef GLR_H
+#define GLR_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "parser.h"
+#include "push_parser.h"
+
+struct glr_node;
+struct glr_block;
+struct glr_reduction;
+
+typedef struct glr_parser
+{
+    const parser_table *table;
+    int epsilon_id;
+    // Plain LR stack, used while every ACTION cell met has a single action.
+    int *states;
+    int size;
+    int capacity;
+    // Graph-structured stack, used from the first conflicting cell until it is linear again.
+    bool split;
+    struct glr_node **heads;
+    int num_heads;
+    int heads_capacity;
+    struct glr_node **next_heads;
+    int next_heads_capacity;
+    struct glr_reduction *reductions;
+    int num_reductions;
+    int reductions_capacity;
+    struct glr_block *blocks;
+    long link_counter;
+    // Scratch copy of the actions of one ACTION cell.
+    parser_action *cell_actions;
+    int cell_actions_capacity;
+    // Accepted or failed for good; every further token is rejected.
+    bool finished;
+    int error_state;
+    // Reason of an internal (non-syntax) failure, or NULL.
+    const char *internal_error;
+    // Reductions that rejoined an existing stack link: local ambiguities packed into one link.
+    int ambiguities;
+    int max_heads;
+    // Tokens parsed on the graph-structured stack.
+    int split_tokens;
+    // Step-by-step trace destination, or NULL for no trace.
+    FILE *trace;
+} glr_parser;
+
+/**
+ * @brief Creates a GLR parser positioned at the start state of a parser table.
+ * @param table ACTION/GOTO table, conflicting actions included; it must outlive the parser.
+ * @return Newly allocated parser, or NULL on allocation/input error.
+ */
+glr_parser *create_glr_parser(const parser_table *table);
+
+/**
+ * @brief Creates a GLR parser positioned at the start state of one entry point.
+ * @param table ACTION/GOTO table, conflicting actions included; it must outlive the parser.
+ * @param entry Entry index from get_entry_index; 0 gives the same parser as create_glr_parser.
+ * @return Newly allocated parser, or NULL on allocation/input error or an invalid entry.
+ */
+glr_parser *create_glr_parser_for_entry(const parser_table *table, int entry);
+
+/**
+ * @brief Releases a GLR parser and its stacks.
+ * @param parser Parser to free.
+ * @return This function does not return a value.
+ */
+void free_glr_parser(glr_parser *parser);
+
+/**
+ * @brief Feeds one token to the GLR parser.
+ *
+ * While the ACTION cells met have a single action, the token is handled exactly
+ * like push_parser_feed on a plain LR stack. On a conflicting cell the stack
+ * splits into a graph-structured stack that follows every action; stacks that
+ * reach the same state share their node, and reductions that rebuild an existing
+ * link are packed into it. Once a single linear stack is left, parsing returns to
+ * the plain LR stack.
+ *
+ * @param parser GLR parser.
+ * @param terminal_or_eof_id Terminal id, g->num_terminals for EOF, or a negative id for an unmapped token.
+ * @param lexeme Token text shown in the trace; may be NULL.
+ * @return NEED_MORE when the token was consumed, ACCEPT once EOF is accepted,
+ *         ERROR when no stack can continue on this token.
+ */
+push_parser_status glr_parser_feed(glr_parser *parser, int terminal_or_eof_id, const char *lexeme);
+
+#endif // GLR_H
@@ -2,8 +2,58 @@
 
 #include <ctype.h>
 
-static symbol *get_symbols_from_line(const char *symbols_line, int *symbols_count, bool is_terminal);
-static production get_production_from_line(const char *production_line, grammar *g);
+typedef enum ebnf_token_kind
+{
+    EBNF_SYMBOL = 0,
+    EBNF_OPEN,
+    EBNF_CLOSE,
+    EBNF_STAR,
+    EBNF_PLUS,
+    EBNF_OPTIONAL
+} ebnf_token_kind;
+
+typedef struct ebnf_token
+{
+    ebnf_token_kind kind;
+    // Encoded id (terminals first, then non-terminals) and name of an EBNF_SYMBOL.
+    int symbol_id;
+    const char *text;
+} ebnf_token;
+
+typedef struct symbol_sequence
+{
+    int *ids;
+    int length;
+    int capacity;
+    // Right-hand side as written, used to name the helper non-terminals.
+    char *text;
+} symbol_sequence;
+
+typedef struct grammar_builder
+{
+    grammar *g;
+    arena *scratch;
+    int productions_capacity;
+    int non_terminals_capacity;
+    // Non-terminals from the first line; the ones after them are EBNF helpers.
+    int num_declared_non_terminals;
+} grammar_builder;
+
+static symbol *get_symbols_from_line(
+    const char *symbols_line, int *symbols_count, bool is_terminal, arena *memory, arena *scratch);
+static bool add_production_from_line(const char *production_line, grammar_builder *builder);
+static bool tokenize_ebnf_symbol(
+    const char *text, const grammar *g, char *core, ebnf_token *tokens, int *num_tokens);
+static bool parse_ebnf_sequence(
+    grammar_builder *builder, const ebnf_token *tokens, int num_tokens, int *position, symbol_sequence *out);
+static int add_ebnf_helper(grammar_builder *builder, ebnf_token_kind op, const symbol_sequence *operand);
+static int append_production(grammar_builder *builder, int non_terminal_id, const int *symbol_ids, int length);
+static bool append_sequence(symbol_sequence *sequence, const symbol_sequence *items, arena *scratch);
+static char *concat_text(arena *scratch, const char *left, const char *separator, const char *right);
+static bool is_directive_line(const char *line);
+static bool parse_directive_line(const char *directive_line, grammar *g, arena *scratch);
+static bool parse_precedence_directive(associativity assoc, grammar *g);
+static bool parse_start_directive(grammar *g);
 
 /**
  * @brief Trims leading and trailing whitespace from a mutable token.
@@ -71,9 +121,10 @@ static int next_power_of_two(int value)
  * @brief Creates an open-addressed hash table for fast symbol lookup.
  * @param symbols Symbol array to index.
  * @param symbols_count Number of symbols.
+ * @param memory Region that owns the table entries.
  * @return Initialized hash table; empty table on error.
  */
-static symbol_hash_table create_symbol_hash_table(symbol *symbols, int symbols_count)
+static symbol_hash_table create_symbol_hash_table(symbol *symbols, int symbols_count, arena *memory)
 {
     symbol_hash_table table;
     table.entries = NULL;
@@ -85,7 +136,7 @@ static symbol_hash_table create_symbol_hash_table(symbol *symbols, int symbols_c
     }
 
     int capacity = next_power_of_two(symbols_count * 2);
-    table.entries = (symbol_hash_entry *)calloc((size_t)capacity, sizeof(symbol_hash_entry));
+    table.entries = (symbol_hash_entry *)arena_calloc(memory, (size_t)capacity, sizeof(symbol_hash_entry));
     table.capacity = capacity;
 
     if (table.entries == NULL)
@@ -149,6 +200,10 @@ static int get_symbol_id_from_hash(const char *symbol_str, const symbol_hash_tab
 
 /**
  * @brief Parses a textual grammar into symbols, indices, and productions.
+ *
+ * Everything the grammar owns lives in its region; the line copies used while
+ * parsing live in a scratch region released before returning.
+ *
  * @param grammar_file_content Full grammar text.
  * @return Allocated grammar instance, or NULL on failure.
  */
@@ -159,18 +214,38 @@ grammar *create_grammar(const char *grammar_file_content)
         return NULL;
     }
 
+    arena scratch;
+    init_arena(&scratch, 0);
+
     // strtok modifies the input buffer, so parse from a mutable copy.
-    char *grammar_copy = strdup(grammar_file_content);
+    char *grammar_copy = arena_strdup(&scratch, grammar_file_content);
     if (grammar_copy == NULL)
     {
+        free_arena(&scratch);
+        return NULL;
+    }
+
+    // Size the line array from the newline count so grammars of any length fit.
+    int max_lines = 1;
+    for (const char *c = grammar_copy; *c != '\0'; c++)
+    {
+        if (*c == '\n')
+        {
+            max_lines++;
+        }
+    }
+
+    char **lines = (char **)arena_alloc(&scratch, (size_t)max_lines * sizeof(char *));
+    if (lines == NULL)
+    {
+        free_arena(&scratch);
         return NULL;
     }
 
     // Split the grammar file content into lines
-    char *lines[MAX_PRODUCTIONS + 2];
     int num_lines = 0;
     char *line = strtok(grammar_copy, "\n");
-    while (line != NULL && num_lines < MAX_PRODUCTIONS + 2)
+    while (line != NULL && num_lines < max_lines)
     {
         lines[num_lines++] = line;
         line = strtok(NULL, "\n");
@@ -180,47 +255,119 @@ grammar *create_grammar(const char *grammar_file_content)
     grammar *g = (grammar *)calloc(1, sizeof(grammar));
     if (g == NULL)
     {
-        free(grammar_copy);
+        free_arena(&scratch);
         return NULL;
     }
+    // Names, production ids and indexes take a few times the text, so one block usually holds them.
+    init_arena(&g->memory, 4 * strlen(grammar_file_content) + 4096);
 
     if (num_lines < 2)
     {
-        free(grammar_copy);
+        free_arena(&scratch);
         return g;
     }
 
     // Get non-terminals
-    g->non_terminals = get_symbols_from_line(lines[0], &g->num_non_terminals, false);
+    g->non_terminals = get_symbols_from_line(lines[0], &g->num_non_terminals, false, &g->memory, &scratch);
     // Get terminals
-    g->terminals = get_symbols_from_line(lines[1], &g->num_terminals, true);
+    g->terminals = get_symbols_from_line(lines[1], &g->num_terminals, true, &g->memory, &scratch);
 
     // Build hash tables for O(1) average symbol lookup.
-    g->non_terminal_index = create_symbol_hash_table(g->non_terminals, g->num_non_terminals);
-    g->terminal_index = create_symbol_hash_table(g->terminals, g->num_terminals);
-
-    // Get productions
-    g->productions = (production *)malloc(MAX_PRODUCTIONS * sizeof(production));
+    g->non_terminal_index = create_symbol_hash_table(g->non_terminals, g->num_non_terminals, &g->memory);
+    g->terminal_index = create_symbol_hash_table(g->terminals, g->num_terminals, &g->memory);
+
+    // Get productions; EBNF helpers append more non-terminals and productions as they go.
+    grammar_builder builder;
+    builder.g = g;
+    builder.scratch = &scratch;
+    builder.productions_capacity = num_lines - 2 > 0 ? num_lines - 2 : 1;
+    builder.non_terminals_capacity = g->num_non_terminals;
+    builder.num_declared_non_terminals = g->num_non_terminals;
+    g->productions = (production *)arena_alloc(&g->memory, (size_t)builder.productions_capacity * sizeof(production));
+    if (g->productions == NULL)
+    {
+        free_arena(&scratch);
+        free_grammar(g);
+        return NULL;
+    }
     g->num_productions = 0;
-    for (int i = 2; i < num_lines && g->num_productions < MAX_PRODUCTIONS; i++)
+    for (int i = 2; i < num_lines; i++)
+    {
+        // Directive lines (%sync, %left ...) annotate the grammar instead of adding productions.
+        if (is_directive_line(lines[i]))
+        {
+            if (!parse_directive_line(lines[i], g, &scratch))
+            {
+                free_arena(&scratch);
+                free_grammar(g);
+                return NULL;
+            }
+            continue;
+        }
+
+        if (!add_production_from_line(lines[i], &builder))
+        {
+            free_arena(&scratch);
+            free_grammar(g);
+            return NULL;
+        }
+    }
+
+    free_arena(&scratch);
+
+    // Index the helper non-terminals too, so every symbol can be found by name.
+    if (g->num_non_terminals > builder.num_declared_non_terminals)
     {
-        g->productions[g->num_productions] = get_production_from_line(lines[i], g);
-        g->num_productions++;
+        g->non_terminal_index = create_symbol_hash_table(g->non_terminals, g->num_non_terminals, &g->memory);
+        if (g->non_terminal_index.entries == NULL)
+        {
+            free_grammar(g);
+            return NULL;
+        }
     }
 
-    free(grammar_copy);
+    // Without %start, the first non-terminal is the only entry point.
+    if (g->num_start_symbols == 0 && g->num_non_terminals > 0)
+    {
+        g->start_symbol_ids = (int *)arena_calloc(&g->memory, 1, sizeof(int));
+        if (g->start_symbol_ids == NULL)
+        {
+            free_grammar(g);
+            return NULL;
+        }
+        g->num_start_symbols = 1;
+    }
 
     return g;
 }
 
+/**
+ * @brief Releases a grammar: its region holds every symbol, production and index.
+ * @param g Grammar to free; may be NULL.
+ * @return This function does not return a value.
+ */
+void free_grammar(grammar *g)
+{
+    if (g == NULL)
+    {
+        return;
+    }
+
+    free_arena(&g->memory);
+    free(g);
+}
+
 /**
  * @brief Parses a symbol declaration line into a symbol array.
  * @param symbols_line Source line (for example terminals/non-terminals line).
  * @param symbols_count Output number of parsed symbols.
  * @param is_terminal Terminal flag to assign to parsed symbols.
+ * @param memory Region that owns the symbols and their names.
+ * @param scratch Region for the line copies.
  * @return Allocated symbol array, or NULL on failure.
  */
-static symbol *get_symbols_from_line(const char *symbols_line, int *symbols_count, bool is_terminal)
+static symbol *get_symbols_from_line(
+    const char *symbols_line, int *symbols_count, bool is_terminal, arena *memory, arena *scratch)
 {
     if (symbols_line == NULL || symbols_count == NULL)
     {
@@ -228,7 +375,7 @@ static symbol *get_symbols_from_line(const char *symbols_line, int *symbols_coun
     }
 
     // Copy the line for counting tokens.
-    char *count_copy = strdup(symbols_line);
+    char *count_copy = arena_strdup(scratch, symbols_line);
     if (count_copy == NULL)
     {
         return NULL;
@@ -249,15 +396,13 @@ static symbol *get_symbols_from_line(const char *symbols_line, int *symbols_coun
         token = strtok(NULL, " ");
     }
 
-    free(count_copy);
-
     // Allocate memory for the symbols array
     *symbols_count = count - 1; // Subtract 1 for the "Non-terminals:" or "Terminals:" prefix
     if (*symbols_count < 0)
     {
         *symbols_count = 0;
     }
-    symbol *symbols = (symbol *)malloc(count * sizeof(symbol));
+    symbol *symbols = (symbol *)arena_alloc(memory, (size_t)count * sizeof(symbol));
     if (symbols == NULL)
     {
         *symbols_count = 0;
@@ -265,10 +410,9 @@ static symbol *get_symbols_from_line(const char *symbols_line, int *symbols_coun
     }
 
     // Copy the line again because strtok already modified the first copy.
-    char *fill_copy = strdup(symbols_line);
+    char *fill_copy = arena_strdup(scratch, symbols_line);
     if (fill_copy == NULL)
     {
-        free(symbols);
         *symbols_count = 0;
         return NULL;
     }
@@ -286,7 +430,7 @@ static symbol *get_symbols_from_line(const char *symbols_line, int *symbols_coun
             // Skip first non-empty token (header prefix) and keep the rest as symbols.
             if (non_empty_index > 0 && symbol_index < *symbols_count)
             {
-                symbols[symbol_index].symbol = strdup(trimmed);
+                symbols[symbol_index].symbol = arena_strdup(memory, trimmed);
                 symbols[symbol_index].symbol_length = (int)strlen(trimmed);
                 symbols[symbol_index].is_terminal = is_terminal;
                 symbol_index++;
@@ -297,86 +441,676 @@ static symbol *get_symbols_from_line(const char *symbols_line, int *symbols_coun
         token = strtok(NULL, " ");
     }
 
-    free(fill_copy);
-
     return symbols;
 }
 
 /**
- * @brief Parses one production line into encoded production ids.
+ * @brief Parses one production line and appends it, with any EBNF helpers it needs.
+ *
+ * The production takes the next slot; helpers created for its X*, X+, X? and
+ * groups follow it.
+ *
  * @param production_line Source production line.
- * @param g Grammar context for symbol resolution.
- * @return Parsed production structure.
+ * @param builder Grammar being built; its region owns the symbol ids.
+ * @return true on success, false on allocation failure or malformed EBNF.
  */
-static production get_production_from_line(const char *production_line, grammar *g)
+static bool add_production_from_line(const char *production_line, grammar_builder *builder)
 {
+    grammar *g = builder->g;
+
     // Copy the production line to avoid modifying the original string
-    char *production_line_duplicate = strdup(production_line);
+    char *production_line_duplicate = arena_strdup(builder->scratch, production_line);
+    if (production_line_duplicate == NULL)
+    {
+        return false;
+    }
 
     // Split the production line into parts
-    char *token = strtok((char *)production_line_duplicate, " ");
-    if (token == NULL)
+    char *token = strtok(production_line_duplicate, " ");
+    int non_terminal_id = -1;
+    if (token != NULL)
     {
-        production empty = {0};
-        empty.non_terminal_id = -1;
-        empty.production_symbol_ids = (int *)calloc(1, sizeof(int));
-        empty.production_length = 0;
-        free(production_line_duplicate);
-        return empty;
+        non_terminal_id = get_symbol_id_from_hash(trim_token(token), &g->non_terminal_index);
     }
 
-    char *lhs = trim_token(token);
-    int non_terminal_id = get_symbol_id_from_hash(lhs, &g->non_terminal_index);
+    int production_index = append_production(builder, non_terminal_id, NULL, 0);
+    if (production_index < 0)
+    {
+        return false;
+    }
 
-    // Production symbols are stored as encoded ids:
-    // terminals [0..T-1], non-terminals [T..T+N-1].
-    int *production_symbol_ids = (int *)malloc(MAX_PRODUCTIONS * sizeof(int));
-    int production_length = 0;
+    // Every character of a token can become an EBNF token, so the line length bounds them.
+    size_t line_length = strlen(production_line);
+    ebnf_token *tokens = (ebnf_token *)arena_alloc(builder->scratch, (line_length + 1) * sizeof(ebnf_token));
+    char *core = (char *)arena_alloc(builder->scratch, line_length + 1);
+    if (tokens == NULL || core == NULL)
+    {
+        return false;
+    }
+    int num_tokens = 0;
 
     // Get the production symbols
-    token = strtok(NULL, " ");
+    token = token != NULL ? strtok(NULL, " ") : NULL;
     while (token != NULL)
     {
         char *trimmed = trim_token(token);
-        if (trimmed == NULL || trimmed[0] == '\0')
+        if (trimmed[0] != '\0' && strcmp(trimmed, "->") != 0 && !tokenize_ebnf_symbol(trimmed, g, core, tokens, &num_tokens))
         {
-            token = strtok(NULL, " ");
-            continue;
+            return false;
         }
+        token = strtok(NULL, " ");
+    }
+
+    // Production symbols are stored as encoded ids:
+    // terminals [0..T-1], non-terminals [T..T+N-1].
+    symbol_sequence rhs = {0};
+    int position = 0;
+    if (!parse_ebnf_sequence(builder, tokens, num_tokens, &position, &rhs) || position != num_tokens)
+    {
+        return false;
+    }
 
-        if (strcmp(trimmed, "->") == 0)
+    production *p = &g->productions[production_index];
+    p->production_symbol_ids = (int *)arena_alloc(&g->memory, (size_t)(rhs.length + 1) * sizeof(int));
+    if (p->production_symbol_ids == NULL)
+    {
+        return false;
+    }
+    if (rhs.length > 0)
+    {
+        memcpy(p->production_symbol_ids, rhs.ids, (size_t)rhs.length * sizeof(int));
+    }
+    p->production_length = rhs.length;
+    return true;
+}
+
+/**
+ * @brief Splits one right-hand side token into a symbol and EBNF punctuation.
+ *
+ * A token that names a declared symbol is always that symbol, so terminals such
+ * as `(`, `*` or `++` keep working. Otherwise leading `(` open groups and
+ * trailing `)`, `*`, `+` and `?` close groups or repeat what precedes them, as
+ * in `Item*` or `(, Expr)*`. Unknown symbols are skipped, as before.
+ *
+ * @param text Trimmed token.
+ * @param g Grammar with its declared symbols indexed.
+ * @param core Buffer of at least strlen(text) + 1 bytes for the candidate symbol names.
+ * @param tokens Output token array.
+ * @param num_tokens Number of tokens in the array; updated.
+ * @return true on success, false when the token holds punctuation only EBNF can use but no symbol.
+ */
+static bool tokenize_ebnf_symbol(
+    const char *text, const grammar *g, char *core, ebnf_token *tokens, int *num_tokens)
+{
+    size_t begin = 0;
+    size_t end = strlen(text);
+    int symbol_id = -1;
+
+    while (begin < end)
+    {
+        size_t length = end - begin;
+        memcpy(core, text + begin, length);
+        core[length] = '\0';
+        symbol_id = get_symbol_id_from_hash(core, &g->terminal_index);
+        if (symbol_id == -1)
         {
-            token = strtok(NULL, " ");
-            continue;
+            symbol_id = get_symbol_id_from_hash(core, &g->non_terminal_index);
+            symbol_id = symbol_id != -1 ? g->num_terminals + symbol_id : -1;
         }
+        if (symbol_id != -1 || text[begin] != '(')
+        {
+            break;
+        }
+        tokens[(*num_tokens)++] = (ebnf_token){EBNF_OPEN, -1, "("};
+        begin++;
+    }
 
-        int symbol_id = get_symbol_id_from_hash(trimmed, &g->terminal_index);
-        if (symbol_id != -1)
+    // Peel the trailing punctuation right to left, then emit it left to right.
+    size_t suffix = end;
+    while (symbol_id == -1 && suffix > begin && strchr(")*+?", text[suffix - 1]) != NULL)
+    {
+        suffix--;
+        size_t length = suffix - begin;
+        if (length > 0)
         {
-            production_symbol_ids[production_length++] = symbol_id;
+            memcpy(core, text + begin, length);
+            core[length] = '\0';
+            symbol_id = get_symbol_id_from_hash(core, &g->terminal_index);
+            if (symbol_id == -1)
+            {
+                symbol_id = get_symbol_id_from_hash(core, &g->non_terminal_index);
+                symbol_id = symbol_id != -1 ? g->num_terminals + symbol_id : -1;
+            }
+        }
+    }
+
+    if (symbol_id != -1)
+    {
+        tokens[(*num_tokens)++] = (ebnf_token){EBNF_SYMBOL, symbol_id, text + begin};
+    }
+    else if (suffix > begin)
+    {
+        // An unknown symbol: skipped like before, together with its punctuation.
+        return true;
+    }
+
+    for (size_t i = suffix; i < end; i++)
+    {
+        ebnf_token_kind kind = text[i] == ')' ? EBNF_CLOSE
+                               : text[i] == '*' ? EBNF_STAR
+                               : text[i] == '+' ? EBNF_PLUS
+                                                : EBNF_OPTIONAL;
+        tokens[(*num_tokens)++] = (ebnf_token){kind, -1, NULL};
+    }
+    return true;
+}
+
+/**
+ * @brief Parses EBNF items up to a closing parenthesis or the end of the line.
+ *
+ * A group without an operator is inlined. An item followed by `*`, `+` or `?`
+ * is replaced by a helper non-terminal (see add_ebnf_helper).
+ *
+ * @param builder Grammar being built.
+ * @param tokens Tokens of the right-hand side.
+ * @param num_tokens Number of tokens.
+ * @param position Index of the next token; left on the closing parenthesis.
+ * @param out Output sequence of encoded ids, in the scratch region.
+ * @return true on success, false on allocation failure or malformed EBNF.
+ */
+static bool parse_ebnf_sequence(
+    grammar_builder *builder, const ebnf_token *tokens, int num_tokens, int *position, symbol_sequence *out)
+{
+    while (*position < num_tokens && tokens[*position].kind != EBNF_CLOSE)
+    {
+        const ebnf_token *token = &tokens[(*position)++];
+        symbol_sequence item = {0};
+
+        if (token->kind == EBNF_SYMBOL)
+        {
+            const grammar *g = builder->g;
+            int id = token->symbol_id;
+            const char *name = id < g->num_terminals ? g->terminals[id].symbol
+                                                     : g->non_terminals[id - g->num_terminals].symbol;
+            item.ids = (int *)arena_alloc(builder->scratch, sizeof(int));
+            item.text = arena_strdup(builder->scratch, name);
+            if (item.ids == NULL || item.text == NULL)
+            {
+                return false;
+            }
+            item.ids[0] = id;
+            item.length = 1;
+            item.capacity = 1;
+        }
+        else if (token->kind == EBNF_OPEN)
+        {
+            if (!parse_ebnf_sequence(builder, tokens, num_tokens, position, &item) || *position >= num_tokens)
+            {
+                // Unbalanced '(' or a nested error.
+                return false;
+            }
+            (*position)++;
+            item.text = concat_text(builder->scratch, "(", "", item.text != NULL ? item.text : "");
+            item.text = item.text != NULL ? concat_text(builder->scratch, item.text, "", ")") : NULL;
+            if (item.text == NULL)
+            {
+                return false;
+            }
         }
         else
         {
-            symbol_id = get_symbol_id_from_hash(trimmed, &g->non_terminal_index);
-            if (symbol_id != -1)
+            // '*', '+' or '?' with nothing to repeat.
+            return false;
+        }
+
+        while (*position < num_tokens && tokens[*position].kind >= EBNF_STAR)
+        {
+            ebnf_token_kind op = tokens[(*position)++].kind;
+            int helper_id = add_ebnf_helper(builder, op, &item);
+            if (helper_id < 0)
+            {
+                return false;
+            }
+
+            const char *op_text = op == EBNF_STAR ? "*" : (op == EBNF_PLUS ? "+" : "?");
+            item.text = concat_text(builder->scratch, item.text, "", op_text);
+            if (item.capacity < 1)
+            {
+                // An empty group such as `()*`.
+                item.ids = (int *)arena_alloc(builder->scratch, sizeof(int));
+                item.capacity = 1;
+            }
+            if (item.text == NULL || item.ids == NULL)
             {
-                // Non-terminals are encoded after terminals.
-                production_symbol_ids[production_length++] = g->num_terminals + symbol_id;
+                return false;
             }
+            item.ids[0] = helper_id;
+            item.length = 1;
         }
-        token = strtok(NULL, " ");
+
+        if (!append_sequence(out, &item, builder->scratch))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Returns the helper non-terminal for X*, X+ or X?, creating it on first use.
+ *
+ * Repetitions are left-recursive so the LR stack stays flat on long lists:
+ *   X*  gives  H ->     | H -> H X
+ *   X+  gives  H -> X   | H -> H X
+ *   X?  gives  H ->     | H -> X
+ * The helper is named after the text it replaces (for example `Item*`), and
+ * equal texts share one helper.
+ *
+ * @param builder Grammar being built.
+ * @param op EBNF_STAR, EBNF_PLUS or EBNF_OPTIONAL.
+ * @param operand Symbol or group being repeated; its text names the helper.
+ * @return Encoded id of the helper, or -1 on allocation failure.
+ */
+static int add_ebnf_helper(grammar_builder *builder, ebnf_token_kind op, const symbol_sequence *operand)
+{
+    grammar *g = builder->g;
+    const char *op_text = op == EBNF_STAR ? "*" : (op == EBNF_PLUS ? "+" : "?");
+    char *name = concat_text(builder->scratch, operand->text, "", op_text);
+    if (name == NULL)
+    {
+        return -1;
+    }
+
+    for (int i = builder->num_declared_non_terminals; i < g->num_non_terminals; i++)
+    {
+        if (strcmp(g->non_terminals[i].symbol, name) == 0)
+        {
+            return g->num_terminals + i;
+        }
+    }
+
+    if (g->num_non_terminals >= builder->non_terminals_capacity)
+    {
+        int new_capacity = builder->non_terminals_capacity * 2 + 4;
+        symbol *resized = (symbol *)arena_grow(&g->memory,
+                                               g->non_terminals,
+                                               (size_t)builder->non_terminals_capacity * sizeof(symbol),
+                                               (size_t)new_capacity * sizeof(symbol));
+        if (resized == NULL)
+        {
+            return -1;
+        }
+        g->non_terminals = resized;
+        builder->non_terminals_capacity = new_capacity;
+    }
+
+    int helper = g->num_non_terminals;
+    g->non_terminals[helper].symbol = arena_strdup(&g->memory, name);
+    if (g->non_terminals[helper].symbol == NULL)
+    {
+        return -1;
+    }
+    g->non_terminals[helper].symbol_length = (int)strlen(name);
+    g->non_terminals[helper].is_terminal = false;
+    g->num_non_terminals++;
+
+    const int helper_id = g->num_terminals + helper;
+    int *recursive = (int *)arena_alloc(builder->scratch, (size_t)(operand->length + 1) * sizeof(int));
+    if (recursive == NULL)
+    {
+        return -1;
+    }
+    recursive[0] = helper_id;
+    if (operand->length > 0)
+    {
+        memcpy(recursive + 1, operand->ids, (size_t)operand->length * sizeof(int));
+    }
+
+    bool ok = true;
+    if (op == EBNF_PLUS)
+    {
+        ok = append_production(builder, helper, operand->ids, operand->length) >= 0;
+    }
+    else
+    {
+        ok = append_production(builder, helper, NULL, 0) >= 0;
+    }
+
+    if (op == EBNF_OPTIONAL)
+    {
+        ok = ok && append_production(builder, helper, operand->ids, operand->length) >= 0;
+    }
+    else
+    {
+        ok = ok && append_production(builder, helper, recursive, operand->length + 1) >= 0;
+    }
+
+    return ok ? helper_id : -1;
+}
+
+/**
+ * @brief Appends one production, growing the production array when it is full.
+ * @param builder Grammar being built.
+ * @param non_terminal_id Left-hand side, or -1 for an unknown one.
+ * @param symbol_ids Encoded right-hand side; copied into the grammar region.
+ * @param length Number of symbols.
+ * @return Index of the new production, or -1 on allocation failure.
+ */
+static int append_production(grammar_builder *builder, int non_terminal_id, const int *symbol_ids, int length)
+{
+    grammar *g = builder->g;
+    if (g->num_productions >= builder->productions_capacity)
+    {
+        int new_capacity = builder->productions_capacity * 2;
+        production *resized = (production *)arena_grow(&g->memory,
+                                                       g->productions,
+                                                       (size_t)builder->productions_capacity * sizeof(production),
+                                                       (size_t)new_capacity * sizeof(production));
+        if (resized == NULL)
+        {
+            return -1;
+        }
+        g->productions = resized;
+        builder->productions_capacity = new_capacity;
     }
 
-    // Create a production object
     production p;
     p.non_terminal_id = non_terminal_id;
-    p.production_symbol_ids = production_symbol_ids;
-    p.production_length = production_length;
+    p.production_symbol_ids = (int *)arena_alloc(&g->memory, (size_t)(length + 1) * sizeof(int));
+    p.production_length = length;
+    if (p.production_symbol_ids == NULL)
+    {
+        return -1;
+    }
+    if (length > 0)
+    {
+        memcpy(p.production_symbol_ids, symbol_ids, (size_t)length * sizeof(int));
+    }
+
+    g->productions[g->num_productions] = p;
+    return g->num_productions++;
+}
+
+/**
+ * @brief Appends the ids and text of one item to a sequence.
+ * @param sequence Sequence to extend; its text gets a space before the item's.
+ * @param items Item to append.
+ * @param scratch Region owning both sequences.
+ * @return true on success, false on allocation failure.
+ */
+static bool append_sequence(symbol_sequence *sequence, const symbol_sequence *items, arena *scratch)
+{
+    if (sequence->length + items->length > sequence->capacity)
+    {
+        int new_capacity = (sequence->length + items->length) * 2;
+        int *resized = (int *)arena_grow(scratch,
+                                         sequence->ids,
+                                         (size_t)sequence->capacity * sizeof(int),
+                                         (size_t)new_capacity * sizeof(int));
+        if (resized == NULL)
+        {
+            return false;
+        }
+        sequence->ids = resized;
+        sequence->capacity = new_capacity;
+    }
+    if (items->length > 0)
+    {
+        memcpy(sequence->ids + sequence->length, items->ids, (size_t)items->length * sizeof(int));
+    }
+    sequence->length += items->length;
+
+    const char *item_text = items->text != NULL ? items->text : "";
+    sequence->text = sequence->text == NULL ? arena_strdup(scratch, item_text)
+                                            : concat_text(scratch, sequence->text, " ", item_text);
+    return sequence->text != NULL;
+}
+
+/**
+ * @brief Concatenates three strings into the scratch region.
+ * @param scratch Region owning the result.
+ * @param left First part.
+ * @param separator Middle part.
+ * @param right Last part.
+ * @return New string, or NULL on allocation failure.
+ */
+static char *concat_text(arena *scratch, const char *left, const char *separator, const char *right)
+{
+    size_t left_length = strlen(left);
+    size_t separator_length = strlen(separator);
+    size_t right_length = strlen(right);
+    char *text = (char *)arena_alloc(scratch, left_length + separator_length + right_length + 1);
+    if (text == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(text, left, left_length);
+    memcpy(text + left_length, separator, separator_length);
+    memcpy(text + left_length + separator_length, right, right_length + 1);
+    return text;
+}
+
+/**
+ * @brief Checks whether a grammar line is a %-prefixed directive.
+ * @param line Source line.
+ * @return true when the first non-whitespace character is '%'.
+ */
+static bool is_directive_line(const char *line)
+{
+    if (line == NULL)
+    {
+        return false;
+    }
+
+    while (*line != '\0' && isspace((unsigned char)*line))
+    {
+        line++;
+    }
+
+    return *line == '%';
+}
+
+/**
+ * @brief Parses one directive line and records its effect in the grammar.
+ * @param directive_line Source line starting with a %-prefixed directive name.
+ * @param g Grammar being built; symbol headers must already be parsed.
+ * @param scratch Region for the line copy.
+ * @return true on success or unknown directive, false on allocation failure.
+ */
+static bool parse_directive_line(const char *directive_line, grammar *g, arena *scratch)
+{
+    char *directive_copy = arena_strdup(scratch, directive_line);
+    if (directive_copy == NULL)
+    {
+        return false;
+    }
+
+    char *token = strtok(directive_copy, " ");
+    char *name = trim_token(token);
+    if (name != NULL && (strcmp(name, "%left") == 0 || strcmp(name, "%right") == 0 || strcmp(name, "%nonassoc") == 0))
+    {
+        associativity assoc = name[1] == 'l' ? ASSOC_LEFT : (name[1] == 'r' ? ASSOC_RIGHT : ASSOC_NONASSOC);
+        return parse_precedence_directive(assoc, g);
+    }
+    if (name != NULL && strcmp(name, "%start") == 0)
+    {
+        return parse_start_directive(g);
+    }
+    if (name == NULL || strcmp(name, "%sync") != 0)
+    {
+        // Unknown directives are ignored, like unknown symbols in productions.
+        return true;
+    }
+
+    token = strtok(NULL, " ");
+    while (token != NULL)
+    {
+        char *trimmed = trim_token(token);
+        int terminal_id = get_symbol_id_from_hash(trimmed, &g->terminal_index);
+        if (terminal_id != -1 && !is_sync_terminal(g, terminal_id))
+        {
+            int *resized = (int *)arena_grow(&g->memory,
+                                             g->sync_terminal_ids,
+                                             (size_t)g->num_sync_terminals * sizeof(int),
+                                             (size_t)(g->num_sync_terminals + 1) * sizeof(int));
+            if (resized == NULL)
+            {
+                return false;
+            }
+            g->sync_terminal_ids = resized;
+            g->sync_terminal_ids[g->num_sync_terminals++] = terminal_id;
+        }
+        token = strtok(NULL, " ");
+    }
+
+    return true;
+}
+
+/**
+ * @brief Assigns the next precedence level to the terminals left in the strtok stream.
+ * @param assoc Associativity of the directive.
+ * @param g Grammar being built; symbol headers must already be parsed.
+ * @return true on success, false on allocation failure.
+ */
+static bool parse_precedence_directive(associativity assoc, grammar *g)
+{
+    if (g->terminal_precedence == NULL && g->num_terminals > 0)
+    {
+        g->terminal_precedence = (int *)arena_calloc(&g->memory, (size_t)g->num_terminals, sizeof(int));
+        g->terminal_associativity =
+            (associativity *)arena_calloc(&g->memory, (size_t)g->num_terminals, sizeof(associativity));
+        if (g->terminal_precedence == NULL || g->terminal_associativity == NULL)
+        {
+            g->terminal_precedence = NULL;
+            g->terminal_associativity = NULL;
+            return false;
+        }
+    }
+
+    // Each directive line opens a new level that binds tighter than the previous ones.
+    int level = ++g->num_precedence_levels;
+    char *token = strtok(NULL, " ");
+    while (token != NULL)
+    {
+        char *trimmed = trim_token(token);
+        int terminal_id = get_symbol_id_from_hash(trimmed, &g->terminal_index);
+        if (terminal_id != -1)
+        {
+            g->terminal_precedence[terminal_id] = level;
+            g->terminal_associativity[terminal_id] = assoc;
+        }
+        token = strtok(NULL, " ");
+    }
+
+    return true;
+}
+
+/**
+ * @brief Appends the non-terminals left in the strtok stream to the entry points.
+ * @param g Grammar being built; symbol headers must already be parsed.
+ * @return true on success, false on allocation failure.
+ */
+static bool parse_start_directive(grammar *g)
+{
+    char *token = strtok(NULL, " ");
+    while (token != NULL)
+    {
+        char *trimmed = trim_token(token);
+        int non_terminal_id = get_symbol_id_from_hash(trimmed, &g->non_terminal_index);
+        if (non_terminal_id != -1 && get_entry_index(g, trimmed) < 0)
+        {
+            int *resized = (int *)arena_grow(&g->memory,
+                                             g->start_symbol_ids,
+                                             (size_t)g->num_start_symbols * sizeof(int),
+                                             (size_t)(g->num_start_symbols + 1) * sizeof(int));
+            if (resized == NULL)
+            {
+                return false;
+            }
+            g->start_symbol_ids = resized;
+            g->start_symbol_ids[g->num_start_symbols++] = non_terminal_id;
+        }
+        token = strtok(NULL, " ");
+    }
+
+    return true;
+}
 
-    // Free the copied line
-    free(production_line_duplicate);
+/**
+ * @brief Finds the entry point whose start symbol has the given name.
+ * @param g Parsed grammar.
+ * @param non_terminal_name Name of the start non-terminal.
+ * @return Entry index, or -1 when the non-terminal is not an entry point.
+ */
+int get_entry_index(const grammar *g, const char *non_terminal_name)
+{
+    if (g == NULL || non_terminal_name == NULL)
+    {
+        return -1;
+    }
+
+    int non_terminal_id = get_symbol_id_from_hash(non_terminal_name, &g->non_terminal_index);
+    for (int entry = 0; entry < g->num_start_symbols && non_terminal_id != -1; entry++)
+    {
+        if (g->start_symbol_ids[entry] == non_terminal_id)
+        {
+            return entry;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Finds the precedence of a production from its last terminal with a declared precedence.
+ * @param g Parsed grammar.
+ * @param production_index Production to inspect.
+ * @return Precedence level, or 0 when none applies.
+ */
+int get_production_precedence(const grammar *g, int production_index)
+{
+    if (g == NULL || g->terminal_precedence == NULL || production_index < 0 || production_index >= g->num_productions)
+    {
+        return 0;
+    }
+
+    production p = g->productions[production_index];
+    for (int i = p.production_length - 1; i >= 0; i--)
+    {
+        int symbol_id = p.production_symbol_ids[i];
+        if (symbol_id >= 0 && symbol_id < g->num_terminals && g->terminal_precedence[symbol_id] > 0)
+        {
+            return g->terminal_precedence[symbol_id];
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Checks whether a terminal was declared with %sync.
+ * @param g Parsed grammar.
+ * @param terminal_id Terminal id to test.
+ * @return true when terminal_id is a synchronising terminal.
+ */
+bool is_sync_terminal(const grammar *g, int terminal_id)
+{
+    if (g == NULL)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < g->num_sync_terminals; i++)
+    {
+        if (g->sync_terminal_ids[i] == terminal_id)
+        {
+            return true;
+        }
+    }
 
-    return p;
+    return false;
 }
 
 /**
@@ -6,7 +6,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 
-#define MAX_PRODUCTIONS 100
+#include "arena.h"
 
 typedef struct symbol
 {
@@ -35,6 +35,14 @@ typedef struct symbol_hash_table
     int capacity;
 } symbol_hash_table;
 
+typedef enum associativity
+{
+    ASSOC_NONE = 0,
+    ASSOC_LEFT,
+    ASSOC_RIGHT,
+    ASSOC_NONASSOC
+} associativity;
+
 typedef struct grammar
 {
     symbol* non_terminals;
@@ -45,15 +53,64 @@ typedef struct grammar
     int num_non_terminals;
     int num_terminals;
     int num_productions;
+    // Terminals declared with %sync; used as panic-mode recovery points.
+    int* sync_terminal_ids;
+    int num_sync_terminals;
+    // Per terminal, from %left/%right/%nonassoc: precedence level (0 when undeclared, later
+    // lines bind tighter) and associativity. NULL when the grammar declares no precedence.
+    int* terminal_precedence;
+    associativity* terminal_associativity;
+    int num_precedence_levels;
+    // Entry points: start non-terminal of each, from %start (the first non-terminal by default).
+    // Entry k starts in parser state k; entry 0 is the default.
+    int* start_symbol_ids;
+    int num_start_symbols;
+    // Owns every array and string above; released in one go by free_grammar.
+    arena memory;
 } grammar;
 
 /**
  * @brief Parses raw grammar text and builds an in-memory grammar structure.
+ *
+ * EBNF operators on right-hand sides (`X*`, `X+`, `X?` and groups) are expanded into
+ * left-recursive helper non-terminals, appended after the declared ones.
+ *
  * @param grammar_file_content Full grammar file content as a null-terminated string.
  * @return Pointer to a newly allocated grammar object, or NULL on error.
  */
 grammar* create_grammar(const char* grammar_file_content);
 
+/**
+ * @brief Releases a grammar and everything it owns.
+ * @param g Grammar to free; may be NULL.
+ * @return This function does not return a value.
+ */
+void free_grammar(grammar* g);
+
+/**
+ * @brief Checks whether a terminal was declared as a synchronising terminal.
+ * @param g Parsed grammar.
+ * @param terminal_id Terminal id in [0, num_terminals).
+ * @return true when terminal_id appears in a %sync declaration.
+ */
+bool is_sync_terminal(const grammar* g, int terminal_id);
+
+/**
+ * @brief Finds the entry point whose start symbol has the given name.
+ * @param g Parsed grammar.
+ * @param non_terminal_name Name of a non-terminal listed by %start.
+ * @return Entry index in [0, num_start_symbols), or -1 when the name is not an entry point.
+ */
+int get_entry_index(const grammar* g, const char* non_terminal_name);
+
+/**
+ * @brief Returns the precedence of a production: that of its last terminal with a declared precedence.
+ * @param g Parsed grammar.
+ * @param production_index Production index in [0, num_productions).
+ * @return Precedence level, or 0 when no terminal of the production has one.
+ */
+int get_production_precedence(const grammar* g, int production_index);
+
 /**
  * @brief Prints grammar symbols and productions to stdout.
  * @param g Grammar to print.
@@ -0,0 +1,860 @@
+#include "incremental.h"
+#include "scanner.h"
+#include "scanner_flex.h"
+#include "token_map.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct node_list
+{
+    incremental_node **items;
+    int count;
+    int capacity;
+} node_list;
+
+typedef struct parse_stack
+{
+    incremental_node **nodes;
+    int *states;
+    int size;
+    int capacity;
+} parse_stack;
+
+typedef struct collect_item
+{
+    incremental_node *node;
+    size_t start;
+} collect_item;
+
+typedef struct leaf_frame
+{
+    const incremental_node *node;
+    int next_child;
+    // Offset where the next child starts.
+    size_t position;
+} leaf_frame;
+
+typedef struct leaf_cursor
+{
+    leaf_frame *frames;
+    int size;
+    int capacity;
+    bool failed;
+    // Current leaf and its start offset; leaf is NULL past the last leaf.
+    const incremental_node *leaf;
+    size_t leaf_start;
+} leaf_cursor;
+
+static bool node_list_push(node_list *list, incremental_node *node);
+static bool collect_push(collect_item **items, int *count, int *capacity, incremental_node *node, size_t start);
+static bool parse_stack_push(parse_stack *stack, incremental_node *node, int state_id);
+static bool cursor_push_frame(leaf_cursor *cursor, const incremental_node *node, size_t start);
+static bool cursor_next(leaf_cursor *cursor, size_t min_end);
+static incremental_node *create_token_node(const parser_table *table, int lexer_token, const char *lexeme);
+static void free_node_shallow(incremental_node *node);
+static void free_tree(incremental_node *root);
+static bool ensure_capacity(incremental_parser *parser, size_t length);
+static bool relex(
+    incremental_parser *parser,
+    size_t relex_start,
+    leaf_cursor *cursor,
+    node_list *tokens,
+    node_list *created,
+    size_t *out_resync_old);
+static bool collect_reusable(
+    incremental_node *root,
+    size_t relex_start,
+    size_t resync_old,
+    node_list *left,
+    node_list *right,
+    node_list *garbage);
+static int first_terminal(const incremental_node *node);
+static int following_terminal(const node_list *stream);
+static bool push_children(node_list *stream, incremental_node *node);
+static int reduction_pop_count(const incremental_parser *parser, production p);
+static bool reduce(incremental_parser *parser, parse_stack *stack, node_list *created, int production_index, int lookahead_id);
+static bool run_parser(incremental_parser *parser, node_list *stream, node_list *created, node_list *garbage);
+static bool reparse(incremental_parser *parser);
+
+incremental_parser *create_incremental_parser(const parser_table *table)
+{
+    if (table == NULL || table->g == NULL)
+    {
+        return NULL;
+    }
+
+    incremental_parser *parser = (incremental_parser *)calloc(1, sizeof(incremental_parser));
+    if (parser == NULL)
+    {
+        return NULL;
+    }
+
+    parser->table = table;
+    parser->epsilon_id = -1;
+    const grammar *g = table->g;
+    for (int i = 0; i < g->num_terminals; i++)
+    {
+        if (strcmp(g->terminals[i].symbol, "epsilon") == 0)
+        {
+            parser->epsilon_id = i;
+            break;
+        }
+    }
+
+    if (!ensure_capacity(parser, 0))
+    {
+        free_incremental_parser(parser);
+        return NULL;
+    }
+
+    return parser;
+}
+
+void free_incremental_parser(incremental_parser *parser)
+{
+    if (parser == NULL)
+    {
+        return;
+    }
+
+    free_tree(parser->root);
+    free_tree(parser->eof_token);
+    free(parser->text);
+    free(parser->scan_buffer);
+    free(parser);
+}
+
+bool incremental_parser_set_text(incremental_parser *parser, const char *text, size_t length)
+{
+    if (parser == NULL || (text == NULL && length > 0))
+    {
+        return false;
+    }
+
+    free_tree(parser->root);
+    free_tree(parser->eof_token);
+    parser->root = NULL;
+    parser->eof_token = NULL;
+    parser->has_damage = false;
+
+    if (!ensure_capacity(parser, length))
+    {
+        parser->length = 0;
+        parser->accepted = false;
+        return false;
+    }
+
+    if (length > 0)
+    {
+        memcpy(parser->text, text, length);
+        memcpy(parser->scan_buffer, text, length);
+    }
+    parser->length = length;
+    parser->text[length] = parser->text[length + 1] = '\0';
+    parser->scan_buffer[length] = parser->scan_buffer[length + 1] = '\0';
+
+    return reparse(parser);
+}
+
+bool incremental_parser_edit(
+    incremental_parser *parser,
+    size_t offset,
+    size_t removed_length,
+    const char *inserted,
+    size_t inserted_length)
+{
+    if (parser == NULL || offset > parser->length || removed_length > parser->length - offset ||
+        (inserted == NULL && inserted_length > 0))
+    {
+        return false;
+    }
+
+    size_t new_length = parser->length - removed_length + inserted_length;
+    if (!ensure_capacity(parser, new_length))
+    {
+        return false;
+    }
+
+    // The tail moves together with its two NUL terminators.
+    size_t edit_end = offset + removed_length;
+    size_t tail_length = parser->length - edit_end + 2;
+    memmove(parser->text + offset + inserted_length, parser->text + edit_end, tail_length);
+    memmove(parser->scan_buffer + offset + inserted_length, parser->scan_buffer + edit_end, tail_length);
+    if (inserted_length > 0)
+    {
+        memcpy(parser->text + offset, inserted, inserted_length);
+        memcpy(parser->scan_buffer + offset, inserted, inserted_length);
+    }
+    parser->length = new_length;
+
+    if (parser->root != NULL)
+    {
+        if (!parser->has_damage)
+        {
+            parser->damage_start = offset;
+            parser->damage_old_end = offset;
+            parser->damage_new_end = offset;
+            parser->has_damage = true;
+        }
+
+        // Merge with the damage left by edits that were never accepted.
+        size_t damaged_end = parser->damage_new_end > edit_end ? parser->damage_new_end : edit_end;
+        if (offset < parser->damage_start)
+        {
+            parser->damage_start = offset;
+        }
+        parser->damage_old_end += damaged_end - parser->damage_new_end;
+        parser->damage_new_end = damaged_end - removed_length + inserted_length;
+    }
+
+    return reparse(parser);
+}
+
+static bool reparse(incremental_parser *parser)
+{
+    parser->accepted = false;
+    parser->error_offset = 0;
+    parser->tokens_lexed = 0;
+    parser->nodes_reused = 0;
+    parser->parser_steps = 0;
+
+    node_list tokens = {0};
+    node_list left = {0};
+    node_list right = {0};
+    node_list garbage = {0};
+    node_list stream = {0};
+    node_list created = {0};
+    leaf_cursor cursor = {0};
+    bool incremental = parser->root != NULL && parser->eof_token != NULL && parser->has_damage;
+    bool ok = true;
+
+    // The previous tree seen as one node, so that the EOF token is a leaf like any other.
+    incremental_node *top_children[2] = {parser->root, parser->eof_token};
+    incremental_node top = {0};
+    top.children = top_children;
+    top.num_children = 2;
+
+    size_t relex_start = 0;
+    size_t resync_old = SIZE_MAX;
+    if (incremental)
+    {
+        // No token of this scanner looks ahead past a newline, so relexing from the
+        // first token that reaches the damaged line cannot miss a changed token.
+        size_t line_start = parser->damage_start;
+        while (line_start > 0 && parser->text[line_start - 1] != '\n')
+        {
+            line_start--;
+        }
+
+        top.length = parser->root->length + parser->eof_token->length;
+        ok = cursor_push_frame(&cursor, &top, 0) && cursor_next(&cursor, line_start);
+        relex_start = cursor.leaf_start;
+    }
+
+    ok = ok && relex(parser, relex_start, incremental ? &cursor : NULL, &tokens, &created, &resync_old);
+
+    if (ok && incremental)
+    {
+        ok = collect_reusable(parser->root, relex_start, resync_old, &left, &right, &garbage);
+        // The old EOF token survives only when the token streams fell back in step before it.
+        ok = ok && node_list_push(resync_old != SIZE_MAX ? &right : &garbage, parser->eof_token);
+    }
+
+    // The stream is consumed from its end: push the input in reverse order.
+    for (int i = right.count - 1; ok && i >= 0; i--)
+    {
+        ok = node_list_push(&stream, right.items[i]);
+    }
+    for (int i = tokens.count - 1; ok && i >= 0; i--)
+    {
+        ok = node_list_push(&stream, tokens.items[i]);
+    }
+    for (int i = left.count - 1; ok && i >= 0; i--)
+    {
+        ok = node_list_push(&stream, left.items[i]);
+    }
+
+    if (ok)
+    {
+        ok = run_parser(parser, &stream, &created, &garbage);
+    }
+
+    if (ok)
+    {
+        // Nodes of the previous tree that were not reused.
+        for (int i = 0; i < garbage.count; i++)
+        {
+            free_node_shallow(garbage.items[i]);
+        }
+        parser->has_damage = false;
+        parser->accepted = true;
+    }
+    else
+    {
+        // The previous tree is left intact; only nodes built by this parse are dropped.
+        for (int i = 0; i < created.count; i++)
+        {
+            free_node_shallow(created.items[i]);
+        }
+    }
+
+    free(tokens.items);
+    free(left.items);
+    free(right.items);
+    free(garbage.items);
+    free(stream.items);
+    free(created.items);
+    free(cursor.frames);
+    return ok;
+}
+
+static bool relex(
+    incremental_parser *parser,
+    size_t relex_start,
+    leaf_cursor *cursor,
+    node_list *tokens,
+    node_list *created,
+    size_t *out_resync_old)
+{
+    yyscan_t scanner;
+    if (yylex_init(&scanner) != 0)
+    {
+        return false;
+    }
+
+    char *base = parser->scan_buffer + relex_start;
+    YY_BUFFER_STATE buffer = yy_scan_buffer(base, parser->length - relex_start + 2, scanner);
+    if (buffer == NULL)
+    {
+        yylex_destroy(scanner);
+        return false;
+    }
+
+    bool ok = true;
+    size_t position = relex_start;
+    while (true)
+    {
+        int lexer_token = yylex(scanner);
+        const char *lexeme = lexer_token == TOK_EOF ? "" : yyget_text(scanner);
+        size_t text_start = lexer_token == TOK_EOF ? parser->length : (size_t)(lexeme - parser->scan_buffer);
+        size_t text_length = lexer_token == TOK_EOF ? 0 : (size_t)yyget_leng(scanner);
+
+        if (text_start < position || text_start > parser->length)
+        {
+            text_start = position;
+        }
+        if (text_length > parser->length - text_start)
+        {
+            text_length = parser->length - text_start;
+        }
+
+        incremental_node *token = create_token_node(parser->table, lexer_token, lexeme);
+        if (token == NULL || !node_list_push(created, token))
+        {
+            free_node_shallow(token);
+            ok = false;
+            break;
+        }
+        if (!node_list_push(tokens, token))
+        {
+            ok = false;
+            break;
+        }
+        token->trivia_length = text_start - position;
+        token->length = token->trivia_length + text_length;
+        position = text_start + text_length;
+        parser->tokens_lexed++;
+
+        // The parse stops at an unmapped token anyway, such as the error an
+        // unterminated comment returns at EOF.
+        if (lexer_token == TOK_EOF || token->symbol_id < 0)
+        {
+            break;
+        }
+
+        if (cursor == NULL || position < parser->damage_new_end)
+        {
+            continue;
+        }
+
+        // Past the edit, both scans restart from the same bytes once their token ends meet.
+        size_t old_position = position - parser->damage_new_end + parser->damage_old_end;
+        while (cursor->leaf != NULL && cursor->leaf_start + cursor->leaf->length < old_position)
+        {
+            cursor_next(cursor, 0);
+        }
+        if (cursor->failed)
+        {
+            ok = false;
+            break;
+        }
+        if (cursor->leaf != NULL && cursor->leaf != parser->eof_token &&
+            cursor->leaf_start + cursor->leaf->length == old_position)
+        {
+            *out_resync_old = old_position;
+            break;
+        }
+    }
+
+    yy_delete_buffer(buffer, scanner);
+    yylex_destroy(scanner);
+
+    // flex leaves a terminator after the last token it returned.
+    parser->scan_buffer[position] = parser->text[position];
+    return ok;
+}
+
+static bool collect_reusable(
+    incremental_node *root,
+    size_t relex_start,
+    size_t resync_old,
+    node_list *left,
+    node_list *right,
+    node_list *garbage)
+{
+    // Pre-order walk with an explicit stack: left-recursive lists make very deep trees.
+    collect_item *pending = NULL;
+    int count = 0;
+    int capacity = 0;
+    bool ok = collect_push(&pending, &count, &capacity, root, 0);
+
+    while (ok && count > 0)
+    {
+        collect_item item = pending[--count];
+        size_t end = item.start + item.node->length;
+
+        if (end <= relex_start)
+        {
+            ok = node_list_push(left, item.node);
+            continue;
+        }
+        if (item.start >= resync_old)
+        {
+            ok = node_list_push(right, item.node);
+            continue;
+        }
+
+        ok = node_list_push(garbage, item.node);
+
+        // Children are pushed last-first so they pop in text order.
+        size_t child_start = end;
+        for (int i = item.node->num_children - 1; ok && i >= 0; i--)
+        {
+            child_start -= item.node->children[i]->length;
+            ok = collect_push(&pending, &count, &capacity, item.node->children[i], child_start);
+        }
+    }
+
+    free(pending);
+    return ok;
+}
+
+static bool collect_push(collect_item **items, int *count, int *capacity, incremental_node *node, size_t start)
+{
+    if (*count >= *capacity)
+    {
+        int new_capacity = *capacity == 0 ? 64 : *capacity * 2;
+        collect_item *resized = (collect_item *)realloc(*items, (size_t)new_capacity * sizeof(collect_item));
+        if (resized == NULL)
+        {
+            return false;
+        }
+        *items = resized;
+        *capacity = new_capacity;
+    }
+
+    (*items)[*count].node = node;
+    (*items)[*count].start = start;
+    (*count)++;
+    return true;
+}
+
+static bool run_parser(incremental_parser *parser, node_list *stream, node_list *created, node_list *garbage)
+{
+    const parser_table *table = parser->table;
+    parse_stack stack = {0};
+    size_t position = 0;
+    bool ok = parse_stack_push(&stack, NULL, 0);
+    bool accepted = false;
+
+    while (ok && stream->count > 0)
+    {
+        incremental_node *node = stream->items[stream->count - 1];
+        int state_id = stack.states[stack.size - 1];
+
+        // Empty subtrees carry no token to decide on; their reductions are simply redone.
+        if (!node->is_token && node->length == 0)
+        {
+            stream->count--;
+            ok = node_list_push(garbage, node) && push_children(stream, node);
+            continue;
+        }
+
+        int terminal_id = node->is_token ? node->symbol_id : first_terminal(node);
+        parser_action action = get_parser_action(table, state_id, terminal_id);
+
+        if (action.type == PARSER_ACTION_REDUCE)
+        {
+            ok = reduce(parser, &stack, created, action.value, terminal_id);
+            continue;
+        }
+
+        if (!node->is_token)
+        {
+            int goto_state = get_parser_goto(table, state_id, node->symbol_id);
+            if (action.type == PARSER_ACTION_SHIFT && node->state == state_id && goto_state >= 0 &&
+                node->lookahead_id == following_terminal(stream))
+            {
+                stream->count--;
+                ok = parse_stack_push(&stack, node, goto_state);
+                position += node->length;
+                parser->nodes_reused++;
+                parser->parser_steps++;
+                continue;
+            }
+
+            stream->count--;
+            ok = node_list_push(garbage, node) && push_children(stream, node);
+            continue;
+        }
+
+        if (action.type == PARSER_ACTION_SHIFT)
+        {
+            stream->count--;
+            ok = parse_stack_push(&stack, node, action.value);
+            position += node->length;
+            parser->parser_steps++;
+            continue;
+        }
+
+        if (action.type == PARSER_ACTION_ACCEPT && stack.size == 2)
+        {
+            parser->root = stack.nodes[1];
+            parser->eof_token = node;
+            accepted = true;
+            break;
+        }
+
+        parser->error_offset = position + node->trivia_length;
+        break;
+    }
+
+    free(stack.nodes);
+    free(stack.states);
+    return ok && accepted;
+}
+
+static bool reduce(incremental_parser *parser, parse_stack *stack, node_list *created, int production_index, int lookahead_id)
+{
+    const parser_table *table = parser->table;
+    const grammar *g = table->g;
+
+    if (production_index < 0 || production_index >= g->num_productions)
+    {
+        return false;
+    }
+
+    production p = g->productions[production_index];
+    int pop_count = reduction_pop_count(parser, p);
+    if (stack->size - pop_count <= 0)
+    {
+        return false;
+    }
+
+    incremental_node *node = (incremental_node *)calloc(1, sizeof(incremental_node));
+    if (node == NULL)
+    {
+        return false;
+    }
+    if (pop_count > 0)
+    {
+        node->children = (incremental_node **)malloc((size_t)pop_count * sizeof(incremental_node *));
+        if (node->children == NULL)
+        {
+            free(node);
+            return false;
+        }
+    }
+
+    stack->size -= pop_count;
+    for (int i = 0; i < pop_count; i++)
+    {
+        node->children[i] = stack->nodes[stack->size + i];
+        node->length += node->children[i]->length;
+    }
+    node->num_children = pop_count;
+    node->symbol_id = p.non_terminal_id;
+    node->production_index = production_index;
+    node->state = stack->states[stack->size - 1];
+    node->lookahead_id = lookahead_id;
+    node->lexer_token = -1;
+    parser->parser_steps++;
+
+    int goto_state = get_parser_goto(table, node->state, p.non_terminal_id);
+    if (!node_list_push(created, node))
+    {
+        free_node_shallow(node);
+        return false;
+    }
+
+    return goto_state >= 0 && parse_stack_push(stack, node, goto_state);
+}
+
+static int first_terminal(const incremental_node *node)
+{
+    while (node != NULL && !node->is_token)
+    {
+        const incremental_node *next = NULL;
+        for (int i = 0; i < node->num_children; i++)
+        {
+            if (node->children[i]->is_token || node->children[i]->length > 0)
+            {
+                next = node->children[i];
+                break;
+            }
+        }
+        node = next;
+    }
+
+    return node != NULL ? node->symbol_id : -1;
+}
+
+static int following_terminal(const node_list *stream)
+{
+    for (int i = stream->count - 2; i >= 0; i--)
+    {
+        const incremental_node *node = stream->items[i];
+        if (node->is_token || node->length > 0)
+        {
+            return first_terminal(node);
+        }
+    }
+
+    return -1;
+}
+
+static bool push_children(node_list *stream, incremental_node *node)
+{
+    for (int i = node->num_children - 1; i >= 0; i--)
+    {
+        if (!node_list_push(stream, node->children[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int reduction_pop_count(const incremental_parser *parser, production p)
+{
+    int count = 0;
+
+    for (int i = 0; i < p.production_length; i++)
+    {
+        if (p.production_symbol_ids[i] == parser->epsilon_id)
+        {
+            continue;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+static incremental_node *create_token_node(const parser_table *table, int lexer_token, const char *lexeme)
+{
+    incremental_node *node = (incremental_node *)calloc(1, sizeof(incremental_node));
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    node->symbol_id = map_lexer_token_to_terminal_id(table->g, lexer_token, lexeme);
+    node->is_token = true;
+    node->production_index = -1;
+    node->state = -1;
+    node->lookahead_id = -1;
+    node->lexer_token = lexer_token;
+    return node;
+}
+
+static void free_node_shallow(incremental_node *node)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+
+    free(node->children);
+    free(node);
+}
+
+static void free_tree(incremental_node *root)
+{
+    node_list pending = {0};
+
+    if (root == NULL || !node_list_push(&pending, root))
+    {
+        free_node_shallow(root);
+        return;
+    }
+
+    while (pending.count > 0)
+    {
+        incremental_node *node = pending.items[--pending.count];
+        for (int i = 0; i < node->num_children; i++)
+        {
+            // On allocation failure the remaining subtree is leaked rather than corrupted.
+            node_list_push(&pending, node->children[i]);
+        }
+        free_node_shallow(node);
+    }
+
+    free(pending.items);
+}
+
+static bool ensure_capacity(incremental_parser *parser, size_t length)
+{
+    // Room for the two NUL bytes yy_scan_buffer expects after the text.
+    size_t needed = length + 2;
+    if (parser->text != NULL && needed <= parser->capacity)
+    {
+        return true;
+    }
+
+    size_t new_capacity = parser->capacity > 0 ? parser->capacity : 256;
+    while (new_capacity < needed)
+    {
+        new_capacity *= 2;
+    }
+
+    char *text = (char *)realloc(parser->text, new_capacity);
+    if (text == NULL)
+    {
+        return false;
+    }
+    parser->text = text;
+
+    char *scan_buffer = (char *)realloc(parser->scan_buffer, new_capacity);
+    if (scan_buffer == NULL)
+    {
+        return false;
+    }
+    parser->scan_buffer = scan_buffer;
+
+    if (parser->capacity == 0)
+    {
+        parser->text[0] = parser->text[1] = '\0';
+        parser->scan_buffer[0] = parser->scan_buffer[1] = '\0';
+    }
+    parser->capacity = new_capacity;
+    return true;
+}
+
+static bool node_list_push(node_list *list, incremental_node *node)
+{
+    if (list->count >= list->capacity)
+    {
+        int new_capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+        incremental_node **resized =
+            (incremental_node **)realloc(list->items, (size_t)new_capacity * sizeof(incremental_node *));
+        if (resized == NULL)
+        {
+            return false;
+        }
+        list->items = resized;
+        list->capacity = new_capacity;
+    }
+
+    list->items[list->count++] = node;
+    return true;
+}
+
+static bool parse_stack_push(parse_stack *stack, incremental_node *node, int state_id)
+{
+    if (stack->size >= stack->capacity)
+    {
+        int new_capacity = stack->capacity == 0 ? 64 : stack->capacity * 2;
+        incremental_node **nodes =
+            (incremental_node **)realloc(stack->nodes, (size_t)new_capacity * sizeof(incremental_node *));
+        if (nodes == NULL)
+        {
+            return false;
+        }
+        stack->nodes = nodes;
+
+        int *states = (int *)realloc(stack->states, (size_t)new_capacity * sizeof(int));
+        if (states == NULL)
+        {
+            return false;
+        }
+        stack->states = states;
+        stack->capacity = new_capacity;
+    }
+
+    stack->nodes[stack->size] = node;
+    stack->states[stack->size] = state_id;
+    stack->size++;
+    return true;
+}
+
+static bool cursor_push_frame(leaf_cursor *cursor, const incremental_node *node, size_t start)
+{
+    if (cursor->size >= cursor->capacity)
+    {
+        int new_capacity = cursor->capacity == 0 ? 64 : cursor->capacity * 2;
+        leaf_frame *resized = (leaf_frame *)realloc(cursor->frames, (size_t)new_capacity * sizeof(leaf_frame));
+        if (resized == NULL)
+        {
+            cursor->failed = true;
+            return false;
+        }
+        cursor->frames = resized;
+        cursor->capacity = new_capacity;
+    }
+
+    cursor->frames[cursor->size].node = node;
+    cursor->frames[cursor->size].next_child = 0;
+    cursor->frames[cursor->size].position = start;
+    cursor->size++;
+    return true;
+}
+
+static bool cursor_next(leaf_cursor *cursor, size_t min_end)
+{
+    while (cursor->size > 0)
+    {
+        leaf_frame *frame = &cursor->frames[cursor->size - 1];
+        if (frame->next_child >= frame->node->num_children)
+        {
+            cursor->size--;
+            continue;
+        }
+
+        const incremental_node *child = frame->node->children[frame->next_child++];
+        size_t child_start = frame->position;
+        frame->position += child->length;
+
+        // Subtrees ending before min_end are skipped without being entered.
+        if (frame->position < min_end)
+        {
+            continue;
+        }
+        if (child->is_token)
+        {
+            cursor->leaf = child;
+            cursor->leaf_start = child_start;
+            return true;
+        }
+        if (!cursor_push_frame(cursor, child, child_start))
+        {
+            break;
+        }
+    }
+
+    cursor->leaf = NULL;
+    return false;
+}
@@ -0,0 +1,107 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "parser.h"
+
+typedef struct incremental_node
+{
+    // Terminal id (g->num_terminals for EOF, -1 if unmapped) for tokens, non-terminal id otherwise.
+    int symbol_id;
+    bool is_token;
+    // Production reduced to build the node; -1 for tokens.
+    int production_index;
+    // Parser state on top of the stack when the node was pushed (its left state); -1 for tokens.
+    int state;
+    // Terminal that followed the node when it was reduced; -1 for tokens.
+    int lookahead_id;
+    // Bytes covered by the node, including the whitespace and comments before its first token.
+    size_t length;
+    // Tokens only: whitespace and comments before the token text, and the lexer token id.
+    size_t trivia_length;
+    int lexer_token;
+    struct incremental_node **children;
+    int num_children;
+} incremental_node;
+
+typedef struct incremental_parser
+{
+    const parser_table *table;
+    int epsilon_id;
+    // Current input, followed by two NUL bytes.
+    char *text;
+    // Copy of text scanned in place by flex, which writes terminators into its buffer.
+    char *scan_buffer;
+    size_t length;
+    size_t capacity;
+    // Tree of the last accepted input: start symbol subtree and EOF token; NULL before the first accept.
+    incremental_node *root;
+    incremental_node *eof_token;
+    // Text changed since the tree was built: [damage_start, damage_old_end) in the tree
+    // became [damage_start, damage_new_end) in the current text.
+    bool has_damage;
+    size_t damage_start;
+    size_t damage_old_end;
+    size_t damage_new_end;
+    // Result and cost of the last parse.
+    bool accepted;
+    size_t error_offset;
+    int tokens_lexed;
+    int nodes_reused;
+    int parser_steps;
+} incremental_parser;
+
+/**
+ * @brief Creates an incremental parser with an empty input.
+ * @param table Deterministic ACTION/GOTO table; it is only read and must outlive the parser.
+ * @return Newly allocated parser, or NULL on allocation/input error.
+ */
+incremental_parser *create_incremental_parser(const parser_table *table);
+
+/**
+ * @brief Releases an incremental parser, its text and its parse tree.
+ * @param parser Parser to free.
+ * @return This function does not return a value.
+ */
+void free_incremental_parser(incremental_parser *parser);
+
+/**
+ * @brief Replaces the whole input and parses it from scratch.
+ * @param parser Incremental parser.
+ * @param text New input bytes.
+ * @param length Number of bytes in text.
+ * @return true when the input is accepted.
+ */
+bool incremental_parser_set_text(incremental_parser *parser, const char *text, size_t length);
+
+/**
+ * @brief Applies one text edit and reparses incrementally.
+ *
+ * Only the tokens around the edit are relexed, until the token stream falls back
+ * in step with the previous one. Subtrees of the previous tree are shifted whole
+ * when their left state and the terminal that follows them are unchanged. Reuse
+ * is per subtree, not per sequence: every node of a left-recursive list
+ * (L -> L item) from the edit to the end of the list contains the edited prefix
+ * and is rebuilt, at one shift of the reused item and one reduction per element.
+ * The work is therefore O(edit + distance from the edit to the end of the
+ * enclosing list), not O(edit); an edit at the end of a list is cheap, one at its
+ * start costs about two steps per following element. When the edited input is rejected, the last accepted tree is kept and the damage of
+ * further edits accumulates on top of it.
+ *
+ * @param parser Incremental parser.
+ * @param offset Byte offset of the edit in the current text.
+ * @param removed_length Number of bytes removed at offset.
+ * @param inserted Bytes inserted at offset; may be NULL when inserted_length is 0.
+ * @param inserted_length Number of bytes inserted.
+ * @return true when the edited input is accepted.
+ */
+bool incremental_parser_edit(
+    incremental_parser *parser,
+    size_t offset,
+    size_t removed_length,
+    const char *inserted,
+    size_t inserted_length);
+
+#endif // INCREMENTAL_H
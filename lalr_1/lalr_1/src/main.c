@@ -1,29 +1,71 @@
 #include "grammar.h"
 #include "automaton.h"
 #include "parser.h"
+#include "push_parser.h"
+#include "incremental.h"
+#include "glr.h"
+#include "table_opt.h"
+#include "token_map.h"
+#include "token_pipeline.h"
 #include "scanner.h"
+#include "scanner_flex.h"
 
 #include <errno.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 
 static bool has_suffix(const char *text, const char *suffix);
 
-extern int yylex(void);
-extern char *yytext;
-extern FILE *yyin;
-
-typedef struct token_stream
+typedef struct parse_context
+{
+    const grammar *g;
+    const parser_table *table;
+    yyscan_t scanner;
+    // Scanner thread that lexes ahead of the parser, or NULL to call yylex directly.
+    token_pipeline *pipeline;
+    // Prefix for diagnostics; NULL when a single input is parsed.
+    const char *source_name;
+    bool trace;
+    int error_count;
+    // Grammar entry point (%start) the input is parsed as; 0 is the default.
+    int entry;
+} parse_context;
+
+typedef enum construction_mode
 {
-    int lexer_token;
-    int terminal_id;
-    const char *lexeme;
-} token_stream;
+    CONSTRUCTION_SLR1 = 0,
+    CONSTRUCTION_LALR1,
+    CONSTRUCTION_LR1,
+    CONSTRUCTION_MODE_COUNT
+} construction_mode;
+
+static const char *const construction_mode_names[CONSTRUCTION_MODE_COUNT] = {"SLR(1)", "LALR(1)", "LR(1)"};
 
-typedef struct parser_stack
+typedef struct batch_job
 {
-    int *states;
-    int size;
-    int capacity;
-} parser_stack;
+    const grammar *g;
+    const parser_table *table;
+    int entry;
+    char **source_paths;
+    bool *accepted;
+    int num_sources;
+    // Lex every source on a scanner thread of its own (--pipeline).
+    bool pipelined;
+    atomic_int next_source;
+} batch_job;
+
+typedef struct generation_stats
+{
+    // Wall-clock seconds outside the automaton and table builders.
+    double grammar_seconds;
+    double optimization_seconds;
+    double total_seconds;
+    automaton_profile automaton;
+    parser_table_profile table;
+} generation_stats;
 
 /**
  * @brief Reads complete stdin content into a dynamically allocated buffer.
@@ -81,512 +123,1010 @@ static char *read_file_all(const char *path)
 }
 
 /**
- * @brief Looks up a terminal id by symbol text.
- * @param g Parsed grammar.
- * @param symbol_name Name of terminal symbol.
- * @return Terminal id or -1 when not found.
+ * @brief Reads one token from the context scanner and maps it to parser terminal id.
+ *
+ * With a pipeline the token was already lexed and mapped by the scanner thread.
+ *
+ * @param ctx Parse context owning the scanner.
+ * @param out_token Output token descriptor.
+ * @return true on success, false when token cannot be mapped.
  */
-static int find_terminal_id(const grammar *g, const char *symbol_name)
+static bool next_token(const parse_context *ctx, token_stream *out_token)
 {
-    if (g == NULL || symbol_name == NULL)
+    if (ctx == NULL || out_token == NULL)
     {
-        return -1;
+        return false;
     }
-
-    for (int i = 0; i < g->num_terminals; i++)
+    if (ctx->pipeline != NULL)
     {
-        if (strcmp(g->terminals[i].symbol, symbol_name) == 0)
-        {
-            return i;
-        }
+        return token_pipeline_next(ctx->pipeline, out_token);
     }
 
-    return -1;
+    int lexer_token = yylex(ctx->scanner);
+    const char *text = yyget_text(ctx->scanner);
+    const char *lexeme = text != NULL ? text : "";
+    int terminal_id = map_lexer_token_to_terminal_id(ctx->g, lexer_token, lexeme);
+
+    out_token->lexer_token = lexer_token;
+    out_token->terminal_id = terminal_id;
+    out_token->lexeme = lexeme;
+    out_token->line = yyget_lineno(ctx->scanner);
+
+    return terminal_id >= 0;
 }
 
 /**
- * @brief Maps lexer token ids to grammar terminal ids.
- * @param g Parsed grammar.
- * @param lexer_token Token returned by yylex().
- * @param lexeme Lexeme text from yytext.
- * @return Terminal id, g->num_terminals for EOF, or -1 if unmapped.
+ * @brief Prints one diagnostic line to stderr, prefixed by the source name in batch mode.
+ * @param ctx Parse context.
+ * @param format printf-style format of the message.
+ * @return This function does not return a value.
  */
-static int map_lexer_token_to_terminal_id(const grammar *g, int lexer_token, const char *lexeme)
+static void report_parse_error(const parse_context *ctx, const char *format, ...)
 {
-    if (g == NULL)
+    char message[512];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    // One fprintf per line keeps lines from concurrent workers intact.
+    if (ctx->source_name != NULL)
     {
-        return -1;
+        fprintf(stderr, "%s: %s\n", ctx->source_name, message);
     }
-
-    if (lexer_token == TOK_EOF)
+    else
     {
-        return g->num_terminals;
+        fprintf(stderr, "%s\n", message);
     }
+}
+
+/**
+ * @brief Reports a lexer token that has no grammar terminal.
+ * @param ctx Parse context.
+ * @param token Token descriptor returned by next_token.
+ * @return This function does not return a value.
+ */
+static void report_unmapped_token(const parse_context *ctx, const token_stream *token)
+{
+    report_parse_error(ctx,
+                       "Lexer token could not be mapped to grammar terminal: '%s' (token=%d) at line %d",
+                       token->lexeme,
+                       token->lexer_token,
+                       token->line);
+}
 
-    if (lexer_token == TOK_ERROR)
+/**
+ * @brief Prints the number of reported errors when recovery kept the parse going.
+ * @param ctx Parse context holding the error count.
+ * @return This function does not return a value.
+ */
+static void report_error_summary(const parse_context *ctx)
+{
+    if (ctx->error_count > 0 && ctx->g->num_sync_terminals > 0)
     {
-        return -1;
+        report_parse_error(ctx, "%d error(s) reported.", ctx->error_count);
     }
+}
 
-    // If grammar terminals are literal lexemes, yytext may directly match.
-    int terminal_id = find_terminal_id(g, lexeme);
-    if (terminal_id >= 0)
-    {
-        return terminal_id;
-    }
-
-    switch (lexer_token)
-    {
-    case TOK_IDENTIFIER:
-        terminal_id = find_terminal_id(g, "IDENTIFIER");
-        if (terminal_id < 0) terminal_id = find_terminal_id(g, "ID");
-        if (terminal_id < 0) terminal_id = find_terminal_id(g, "id");
-        return terminal_id;
-    case TOK_INT_LITERAL:
-        terminal_id = find_terminal_id(g, "INT_LITERAL");
-        if (terminal_id < 0) terminal_id = find_terminal_id(g, "INT");
-        if (terminal_id < 0) terminal_id = find_terminal_id(g, "num");
-        return terminal_id;
-    case TOK_FLOAT_LITERAL:
-        terminal_id = find_terminal_id(g, "FLOAT_LITERAL");
-        if (terminal_id < 0) terminal_id = find_terminal_id(g, "FLOAT");
-        if (terminal_id < 0) terminal_id = find_terminal_id(g, "num");
-        return terminal_id;
-    case TOK_STRING_LITERAL:
-        terminal_id = find_terminal_id(g, "STRING_LITERAL");
-        if (terminal_id < 0) terminal_id = find_terminal_id(g, "STRING");
-        if (terminal_id < 0) terminal_id = find_terminal_id(g, "str");
-        return terminal_id;
-    case TOK_CHAR_LITERAL:
-        terminal_id = find_terminal_id(g, "CHAR_LITERAL");
-        if (terminal_id < 0) terminal_id = find_terminal_id(g, "CHAR");
-        if (terminal_id < 0) terminal_id = find_terminal_id(g, "char_lit");
-        return terminal_id;
-    default:
-        break;
+/**
+ * @brief Parses the context scanner token stream with the GLR driver.
+ *
+ * Used when the table has conflicts: every conflicting action is followed on a
+ * graph-structured stack. There is no error recovery; the first token no stack
+ * can shift ends the parse.
+ *
+ * @param ctx Parse context with grammar, table and an initialized scanner.
+ * @return true if input is accepted, false otherwise.
+ */
+static bool parse_token_stream_glr(parse_context *ctx)
+{
+    glr_parser *parser = create_glr_parser_for_entry(ctx->table, ctx->entry);
+    if (parser == NULL)
+    {
+        return false;
     }
+    parser->trace = ctx->trace ? stdout : NULL;
 
-    // Fallback for lexers that return punctuation as character codes.
-    if (lexer_token > 0 && lexer_token <= 127)
+    push_parser_status status = PUSH_PARSER_NEED_MORE;
+    while (status == PUSH_PARSER_NEED_MORE)
     {
-        char one_char_symbol[2] = {(char)lexer_token, '\0'};
-        terminal_id = find_terminal_id(g, one_char_symbol);
-        if (terminal_id >= 0)
+        token_stream token;
+        if (!next_token(ctx, &token))
         {
-            return terminal_id;
+            report_unmapped_token(ctx, &token);
+            ctx->error_count++;
+            break;
+        }
+
+        status = glr_parser_feed(parser, token.terminal_id, token.lexeme);
+        if (status == PUSH_PARSER_ERROR && parser->internal_error == NULL)
+        {
+            ctx->error_count++;
+            report_parse_error(ctx,
+                               "Syntax error at token '%s' (lexer=%d, terminal=%d) in state %d at line %d",
+                               token.lexeme,
+                               token.lexer_token,
+                               token.terminal_id,
+                               parser->error_state,
+                               token.line);
         }
     }
 
-    return -1;
+    if (parser->internal_error != NULL)
+    {
+        report_parse_error(ctx, "%s", parser->internal_error);
+    }
+    if (ctx->trace)
+    {
+        printf("GLR: %d token(s) on split stacks, at most %d stack heads, %d ambiguities packed.\n",
+               parser->split_tokens,
+               parser->max_heads,
+               parser->ambiguities);
+    }
+
+    bool accepted = status == PUSH_PARSER_ACCEPT && ctx->error_count == 0;
+    free_glr_parser(parser);
+    return accepted;
 }
 
 /**
- * @brief Initializes parser stack with state 0.
- * @param stack Target stack.
- * @return true on success, false on allocation failure.
+ * @brief Runs an LALR shift-reduce parse against the context scanner token stream.
+ *
+ * Tokens are pulled from the scanner and fed to a push_parser. When the grammar
+ * declares %sync terminals, the push parser recovers from syntax errors in panic
+ * mode, so every error is reported in one pass. Tables with conflicts are
+ * parsed by the GLR driver instead.
+ *
+ * @param ctx Parse context with grammar, table and an initialized scanner.
+ * @return true if input is accepted without errors, false otherwise.
  */
-static bool init_parser_stack(parser_stack *stack)
+static bool parse_token_stream(parse_context *ctx)
 {
-    if (stack == NULL)
+    if (ctx == NULL || ctx->g == NULL || ctx->table == NULL)
     {
         return false;
     }
+    if (ctx->table->has_conflicts)
+    {
+        return parse_token_stream_glr(ctx);
+    }
 
-    stack->capacity = 64;
-    stack->size = 0;
-    stack->states = (int *)malloc((size_t)stack->capacity * sizeof(int));
-    if (stack->states == NULL)
+    push_parser *parser = create_push_parser_for_entry(ctx->table, ctx->entry);
+    if (parser == NULL)
     {
-        stack->capacity = 0;
         return false;
     }
+    parser->trace = ctx->trace ? stdout : NULL;
 
-    stack->states[stack->size++] = 0;
-    return true;
-}
+    push_parser_status status = PUSH_PARSER_NEED_MORE;
+    int syntax_errors = 0;
+    while (status != PUSH_PARSER_ACCEPT && !parser->finished)
+    {
+        token_stream token;
+        if (!next_token(ctx, &token))
+        {
+            report_unmapped_token(ctx, &token);
+            ctx->error_count++;
+            // A token that matched no text (an unterminated comment) was returned at end of input,
+            // so there is nothing left to recover on.
+            if (!parser->recovery_enabled || token.lexeme[0] == '\0')
+            {
+                break;
+            }
+        }
 
-/**
- * @brief Releases parser stack memory.
- * @param stack Stack to free.
- * @return This function does not return a value.
- */
-static void free_parser_stack(parser_stack *stack)
-{
-    if (stack == NULL)
+        status = push_parser_feed(parser, token.terminal_id, token.lexeme);
+        if (parser->error_count > syntax_errors)
+        {
+            syntax_errors = parser->error_count;
+            report_parse_error(ctx,
+                               "Syntax error at token '%s' (lexer=%d, terminal=%d) in state %d at line %d",
+                               token.lexeme,
+                               token.lexer_token,
+                               token.terminal_id,
+                               parser->error_state,
+                               token.line);
+        }
+    }
+
+    if (parser->internal_error != NULL)
     {
-        return;
+        report_parse_error(ctx, "%s", parser->internal_error);
     }
 
-    free(stack->states);
-    stack->states = NULL;
-    stack->size = 0;
-    stack->capacity = 0;
+    ctx->error_count += parser->error_count;
+    bool accepted = status == PUSH_PARSER_ACCEPT && ctx->error_count == 0;
+    free_push_parser(parser);
+
+    report_error_summary(ctx);
+    return accepted;
 }
 
 /**
- * @brief Pushes one state to parser stack.
- * @param stack Parser stack.
- * @param state_id State to push.
- * @return true on success, false on allocation failure.
+ * @brief Parses one source file with a private scanner instance.
+ * @param g Parsed grammar shared read-only between callers.
+ * @param table ACTION/GOTO table shared read-only between callers.
+ * @param entry Grammar entry point the file is parsed as.
+ * @param source_path Source file to parse.
+ * @param trace Print every parser step to stdout.
+ * @param pipelined Lex the file on a scanner thread through a token_pipeline.
+ * @param source_name Diagnostic prefix, or NULL for none.
+ * @return true when the file was opened and accepted.
  */
-static bool push_state(parser_stack *stack, int state_id)
+static bool parse_source_file(
+    const grammar *g,
+    const parser_table *table,
+    int entry,
+    const char *source_path,
+    bool trace,
+    bool pipelined,
+    const char *source_name)
 {
-    if (stack == NULL)
+    FILE *source = fopen(source_path, "r");
+    if (source == NULL)
     {
+        fprintf(stderr, "Failed to open source file '%s': %s\n", source_path, strerror(errno));
         return false;
     }
 
-    if (stack->size >= stack->capacity)
+    parse_context ctx = {0};
+    ctx.g = g;
+    ctx.table = table;
+    ctx.source_name = source_name;
+    ctx.trace = trace;
+    ctx.entry = entry;
+    if (yylex_init(&ctx.scanner) != 0)
     {
-        int new_capacity = stack->capacity * 2;
-        int *resized = (int *)realloc(stack->states, (size_t)new_capacity * sizeof(int));
-        if (resized == NULL)
-        {
-            return false;
-        }
-        stack->states = resized;
-        stack->capacity = new_capacity;
+        fprintf(stderr, "Failed to create scanner for '%s'.\n", source_path);
+        fclose(source);
+        return false;
     }
+    yyset_in(source, ctx.scanner);
 
-    stack->states[stack->size++] = state_id;
-    return true;
+    bool accepted = false;
+    if (pipelined)
+    {
+        ctx.pipeline = start_token_pipeline(g, ctx.scanner);
+    }
+    if (pipelined && ctx.pipeline == NULL)
+    {
+        fprintf(stderr, "Failed to start scanner thread for '%s'.\n", source_path);
+    }
+    else
+    {
+        accepted = parse_token_stream(&ctx);
+        stop_token_pipeline(ctx.pipeline);
+    }
+
+    yylex_destroy(ctx.scanner);
+    fclose(source);
+    return accepted;
 }
 
 /**
- * @brief Pops N states from parser stack.
- * @param stack Parser stack.
- * @param count Number of states to pop.
- * @return false if count is invalid, true otherwise.
+ * @brief Worker thread: parses batch sources until the shared queue is empty.
+ * @param arg Pointer to the shared batch_job.
+ * @return Always NULL.
  */
-static bool pop_states(parser_stack *stack, int count)
+static void *batch_worker(void *arg)
 {
-    if (stack == NULL || count < 0 || stack->size - count <= 0)
+    batch_job *job = (batch_job *)arg;
+
+    while (true)
     {
-        return false;
+        int index = atomic_fetch_add(&job->next_source, 1);
+        if (index >= job->num_sources)
+        {
+            break;
+        }
+
+        job->accepted[index] =
+            parse_source_file(job->g,
+                              job->table,
+                              job->entry,
+                              job->source_paths[index],
+                              false,
+                              job->pipelined,
+                              job->source_paths[index]);
     }
 
-    stack->size -= count;
-    return true;
+    return NULL;
 }
 
 /**
- * @brief Returns current top parser state.
- * @param stack Parser stack.
- * @return Top state id or -1 if stack is invalid/empty.
+ * @brief Parses many sources concurrently, all sharing one grammar and table.
+ * @param g Parsed grammar.
+ * @param table ACTION/GOTO table; only read by the workers.
+ * @param entry Grammar entry point every source is parsed as.
+ * @param source_paths Source files to parse.
+ * @param num_sources Number of source files.
+ * @param num_jobs Number of worker threads.
+ * @param pipelined Give every source a scanner thread of its own.
+ * @return Number of rejected (or unreadable) sources, or -1 on setup failure.
  */
-static int top_state(const parser_stack *stack)
+static int parse_sources_in_parallel(
+    const grammar *g,
+    const parser_table *table,
+    int entry,
+    char **source_paths,
+    int num_sources,
+    int num_jobs,
+    bool pipelined)
 {
-    if (stack == NULL || stack->size <= 0)
+    batch_job job;
+    job.g = g;
+    job.table = table;
+    job.entry = entry;
+    job.source_paths = source_paths;
+    job.num_sources = num_sources;
+    job.pipelined = pipelined;
+    job.accepted = (bool *)calloc((size_t)num_sources, sizeof(bool));
+    atomic_init(&job.next_source, 0);
+    if (job.accepted == NULL)
     {
         return -1;
     }
 
-    return stack->states[stack->size - 1];
-}
+    if (num_jobs > num_sources)
+    {
+        num_jobs = num_sources;
+    }
 
-/**
- * @brief Computes how many stack states to pop for a reduction.
- * @param g Parsed grammar.
- * @param p Production to reduce by.
- * @return Number of states to pop.
- */
-static int reduction_pop_count(const grammar *g, production p)
-{
-    int epsilon_id = find_terminal_id(g, "epsilon");
-    int count = 0;
+    pthread_t *workers = (pthread_t *)malloc((size_t)num_jobs * sizeof(pthread_t));
+    if (workers == NULL)
+    {
+        free(job.accepted);
+        return -1;
+    }
 
-    for (int i = 0; i < p.production_length; i++)
+    int started = 0;
+    for (; started < num_jobs; started++)
     {
-        int symbol_id = p.production_symbol_ids[i];
-        if (symbol_id == epsilon_id)
+        if (pthread_create(&workers[started], NULL, batch_worker, &job) != 0)
         {
-            continue;
+            break;
+        }
+    }
+
+    // With no thread at all, still make progress on the calling thread.
+    if (started == 0)
+    {
+        batch_worker(&job);
+    }
+
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+
+    int rejected = 0;
+    for (int i = 0; i < num_sources; i++)
+    {
+        printf("%s: %s\n", source_paths[i], job.accepted[i] ? "accepted" : "rejected");
+        if (!job.accepted[i])
+        {
+            rejected++;
         }
-        count++;
     }
 
-    return count;
+    free(workers);
+    free(job.accepted);
+    return rejected;
 }
 
 /**
- * @brief Reads one token from yylex and maps it to parser terminal id.
- * @param g Parsed grammar.
- * @param out_token Output token descriptor.
- * @return true on success, false when token cannot be mapped.
+ * @brief Splits an --edit value of the form OFFSET:REMOVED:TEXT.
+ * @param spec Option value after "--edit=".
+ * @param out_offset Output byte offset of the edit.
+ * @param out_removed Output number of bytes removed.
+ * @param out_inserted Output pointer to the inserted text (rest of spec).
+ * @return true when spec is well formed.
  */
-static bool next_token(const grammar *g, token_stream *out_token)
+static bool parse_edit_spec(const char *spec, size_t *out_offset, size_t *out_removed, const char **out_inserted)
 {
-    if (g == NULL || out_token == NULL)
+    char *end = NULL;
+
+    errno = 0;
+    unsigned long long offset = strtoull(spec, &end, 10);
+    if (errno != 0 || end == spec || *end != ':')
     {
         return false;
     }
 
-    int lexer_token = yylex();
-    const char *lexeme = yytext != NULL ? yytext : "";
-    int terminal_id = map_lexer_token_to_terminal_id(g, lexer_token, lexeme);
-
-    out_token->lexer_token = lexer_token;
-    out_token->terminal_id = terminal_id;
-    out_token->lexeme = lexeme;
+    const char *removed_text = end + 1;
+    unsigned long long removed = strtoull(removed_text, &end, 10);
+    if (errno != 0 || end == removed_text || *end != ':')
+    {
+        return false;
+    }
 
-    return terminal_id >= 0;
+    *out_offset = (size_t)offset;
+    *out_removed = (size_t)removed;
+    *out_inserted = end + 1;
+    return true;
 }
 
-void print_stack(parser_stack *stack)
+/**
+ * @brief Prints the outcome and cost of the last incremental (re)parse.
+ * @param parser Incremental parser.
+ * @param label Line prefix naming the parse.
+ * @return This function does not return a value.
+ */
+static void report_incremental_parse(const incremental_parser *parser, const char *label)
 {
-    printf("Stack: ");
-    for (int i = 0; i < stack->size; i++)
+    if (parser->accepted)
+    {
+        printf("%s: accepted", label);
+    }
+    else
     {
-        printf("%d ", stack->states[i]);
+        int line = 1;
+        for (size_t i = 0; i < parser->error_offset && i < parser->length; i++)
+        {
+            if (parser->text[i] == '\n')
+            {
+                line++;
+            }
+        }
+        printf("%s: rejected at line %d", label, line);
     }
-    printf("\n");
+
+    printf(" (%d tokens lexed, %d subtrees reused, %d parser steps)\n",
+           parser->tokens_lexed,
+           parser->nodes_reused,
+           parser->parser_steps);
 }
 
 /**
- * @brief Runs an LALR shift-reduce parse against yylex token stream.
- * @param g Parsed grammar.
+ * @brief Parses a source with the incremental parser, then applies and reparses each edit.
  * @param table ACTION/GOTO table.
- * @return true if input is accepted, false otherwise.
+ * @param source_path Source file to parse.
+ * @param edit_specs --edit values, applied in order.
+ * @param num_edits Number of edits.
+ * @return true when the input is accepted after the last edit.
  */
-static bool parse_token_stream(const grammar *g, const parser_table *table)
+static bool run_edit_session(const parser_table *table, const char *source_path, char **edit_specs, int num_edits)
 {
-    if (g == NULL || table == NULL)
+    char *source_text = read_file_all(source_path);
+    if (source_text == NULL)
     {
+        fprintf(stderr, "Failed to read source file '%s': %s\n", source_path, strerror(errno));
         return false;
     }
 
-    parser_stack stack;
-    if (!init_parser_stack(&stack))
+    incremental_parser *parser = create_incremental_parser(table);
+    if (parser == NULL)
     {
+        fprintf(stderr, "Failed to create incremental parser.\n");
+        free(source_text);
         return false;
     }
 
-    token_stream lookahead;
-    if (!next_token(g, &lookahead))
-    {
-        fprintf(stderr, "Lexer token could not be mapped to grammar terminal: '%s' (token=%d)\n",
-                yytext != NULL ? yytext : "",
-                lookahead.lexer_token);
-        free_parser_stack(&stack);
-        return false;
-    }
+    incremental_parser_set_text(parser, source_text, strlen(source_text));
+    free(source_text);
+    report_incremental_parse(parser, "Initial parse");
 
-    while (true)
+    for (int i = 0; i < num_edits; i++)
     {
-        printf("\n============================\n");
-        printf("Top state: %d\n", top_state(&stack));
-        if (lookahead.lexeme == NULL || strlen(lookahead.lexeme) == 0)
-        {
-            printf("Lookahead: $\n");
-        }
-        else
+        size_t offset = 0;
+        size_t removed = 0;
+        const char *inserted = NULL;
+        if (!parse_edit_spec(edit_specs[i], &offset, &removed, &inserted) ||
+            offset > parser->length || removed > parser->length - offset)
         {
-            printf("Lookahead: %s\n", lookahead.lexeme);
+            fprintf(stderr, "Invalid edit '%s'.\n", edit_specs[i]);
+            parser->accepted = false;
+            break;
         }
-        int state_id = top_state(&stack);
-        parser_action action = get_parser_action(table, state_id, lookahead.terminal_id);
 
-        if (action.type == PARSER_ACTION_SHIFT)
-        {
-            printf("Action: SHIFT to state %d\n", action.value);
-            if (!push_state(&stack, action.value))
-            {
-                fprintf(stderr, "Parser stack overflow while shifting.\n");
-                free_parser_stack(&stack);
-                return false;
-            }
+        incremental_parser_edit(parser, offset, removed, inserted, strlen(inserted));
 
-            if (!next_token(g, &lookahead))
-            {
-                fprintf(stderr, "Lexer token could not be mapped to grammar terminal: '%s' (token=%d)\n",
-                        yytext != NULL ? yytext : "",
-                        lookahead.lexer_token);
-                free_parser_stack(&stack);
-                return false;
-            }
+        char label[64];
+        snprintf(label, sizeof(label), "Edit %d", i + 1);
+        report_incremental_parse(parser, label);
+    }
 
-            continue;
-        }
+    bool accepted = parser->accepted;
+    free_incremental_parser(parser);
+    return accepted;
+}
 
-        if (action.type == PARSER_ACTION_REDUCE)
-        {
-            production p = g->productions[action.value];
+/**
+ * @brief Prints command line usage.
+ * @param program Program name from argv[0].
+ * @return This function does not return a value.
+ */
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s <grammar_file> [source_file...] [table_output.(csv|json)] [--jobs=N] "
+            "[--edit=OFFSET:REMOVED:TEXT...] [--eliminate-units] [--minimize-states] "
+            "[--mode=slr|lalr|lr1] [--compare-modes] [--pipeline] [--entry=NON_TERMINAL] "
+            "[--stats=json]\n",
+            program);
+}
 
-            printf("Action: REDUCE by p%d: %s -> ",
-                action.value,
-                g->non_terminals[p.non_terminal_id].symbol);
+/**
+ * @brief Reads a --mode= value.
+ * @param value Text after --mode=.
+ * @param out_mode Output construction mode.
+ * @return true when value is slr, lalr or lr1.
+ */
+static bool parse_construction_mode(const char *value, construction_mode *out_mode)
+{
+    static const char *const values[CONSTRUCTION_MODE_COUNT] = {"slr", "lalr", "lr1"};
 
-            for (int i = 0; i < p.production_length; i++)
-            {
-                int sym_id = p.production_symbol_ids[i];
-
-                if (sym_id < g->num_terminals)
-                {
-                    printf("%s ", g->terminals[sym_id].symbol);
-                }
-                else
-                {
-                    int nt_index = sym_id - g->num_terminals;
-                    printf("%s ", g->non_terminals[nt_index].symbol);
-                }
-            }
-            printf("\n");
-            if (action.value < 0 || action.value >= g->num_productions)
-            {
-                fprintf(stderr, "Invalid reduction production index: %d\n", action.value);
-                free_parser_stack(&stack);
-                return false;
-            }
+    for (int mode = 0; mode < CONSTRUCTION_MODE_COUNT; mode++)
+    {
+        if (strcmp(value, values[mode]) == 0)
+        {
+            *out_mode = (construction_mode)mode;
+            return true;
+        }
+    }
 
-            int pop_count = reduction_pop_count(g, p);
-            if (!pop_states(&stack, pop_count))
-            {
-                fprintf(stderr, "Invalid parser stack pop for production %d\n", action.value);
-                free_parser_stack(&stack);
-                return false;
-            }
+    return false;
+}
 
-            int goto_from = top_state(&stack);
-            int goto_state = get_parser_goto(table, goto_from, p.non_terminal_id);
-            if (goto_state < 0)
-            {
-                fprintf(stderr,
-                        "Missing GOTO[%d, %s] after reduction p%d\n",
-                        goto_from,
-                        g->non_terminals[p.non_terminal_id].symbol,
-                        action.value);
-                free_parser_stack(&stack);
-                return false;
-            }
+/**
+ * @brief Builds the automaton of one construction; the table builder accepts all of them.
+ * @param g Parsed grammar.
+ * @param mode SLR(1), LALR(1) or canonical LR(1).
+ * @param profile Profile to accumulate into, or NULL.
+ * @return Newly allocated automaton, or NULL on failure.
+ */
+static lr1_automaton *build_automaton_for_mode(const grammar *g, construction_mode mode, automaton_profile *profile)
+{
+    switch (mode)
+    {
+    case CONSTRUCTION_SLR1:
+        return build_slr1_automaton_profiled(g, profile);
+    case CONSTRUCTION_LR1:
+        return build_lr1_automaton_profiled(g, profile);
+    default:
+        return build_lalr1_automaton_profiled(g, profile);
+    }
+}
 
-            if (!push_state(&stack, goto_state))
-            {
-                fprintf(stderr, "Parser stack overflow after reduction.\n");
-                free_parser_stack(&stack);
-                return false;
-            }
+/**
+ * @brief Returns wall-clock seconds, used to time table construction.
+ * @return Seconds since the epoch.
+ */
+static double wall_seconds(void)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
 
-            continue;
-        }
+/**
+ * @brief Builds the table of every construction and prints their sizes side by side.
+ *
+ * Table bytes count the dense ACTION and GOTO arrays; build seconds cover the
+ * automaton and the table.
+ *
+ * @param g Parsed grammar.
+ * @return true on success, false when a construction fails.
+ */
+static bool print_construction_comparison(const grammar *g)
+{
+    printf("%-10s %8s %12s %10s %14s\n", "Mode", "States", "Table bytes", "Conflicts", "Build seconds");
 
-        if (action.type == PARSER_ACTION_ACCEPT)
+    for (int mode = 0; mode < CONSTRUCTION_MODE_COUNT; mode++)
+    {
+        double started = wall_seconds();
+        lr1_automaton *automaton = build_automaton_for_mode(g, (construction_mode)mode, NULL);
+        parser_table *table = automaton != NULL ? build_lalr1_parser_table(g, automaton) : NULL;
+        double seconds = wall_seconds() - started;
+        if (table == NULL)
         {
-             printf("Action: ACCEPT\n");
-            free_parser_stack(&stack);
-            return true;
+            free_lr1_automaton(automaton);
+            return false;
         }
 
-        printf("Action: ERROR\n");
-        fprintf(stderr,
-                "Syntax error at token '%s' (lexer=%d, terminal=%d) in state %d\n",
-                lookahead.lexeme,
-                lookahead.lexer_token,
-                lookahead.terminal_id,
-                state_id);
-        free_parser_stack(&stack);
-        return false;
+        size_t table_bytes =
+            (size_t)table->num_states * ((size_t)table->num_terminals_with_eof * sizeof(parser_action) +
+                                         (size_t)table->num_non_terminals * sizeof(int));
+        printf("%-10s %8d %12zu %10d %14.6f\n",
+               construction_mode_names[mode],
+               table->num_states,
+               table_bytes,
+               table->num_conflicts,
+               seconds);
+
+        free_parser_table(table);
+        free_lr1_automaton(automaton);
     }
+
+    return true;
 }
 
 /**
- * @brief Program entry point. Builds LALR table and parses yylex token stream.
+ * @brief Writes the --stats=json report of one table generation.
+ *
+ * Peak bytes add the grammar region to the larger of the automaton builder's
+ * peak and the finished automaton plus the table, which coexist afterwards.
+ *
+ * @param out Destination stream.
+ * @param g Parsed grammar.
+ * @param mode Construction used.
+ * @param stats Collected timings and counters.
+ * @param automaton Finished automaton.
+ * @param table Finished (and optimized) table.
+ * @return This function does not return a value.
+ */
+static void print_generation_stats_json(
+    FILE *out,
+    const grammar *g,
+    construction_mode mode,
+    const generation_stats *stats,
+    const lr1_automaton *automaton,
+    const parser_table *table)
+{
+    static const char *const mode_values[CONSTRUCTION_MODE_COUNT] = {"slr", "lalr", "lr1"};
+    const automaton_profile *a = &stats->automaton;
+    const parser_table_profile *t = &stats->table;
+
+    size_t table_bytes = parser_table_bytes(table);
+    size_t built_bytes = automaton->memory.bytes_reserved + (table_bytes > t->table_bytes ? table_bytes : t->table_bytes);
+    size_t peak_bytes = g->memory.bytes_reserved + (a->peak_bytes > built_bytes ? a->peak_bytes : built_bytes);
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"mode\": \"%s\",\n", mode_values[mode]);
+    fprintf(out, "  \"seconds\": {\n");
+    fprintf(out, "    \"grammar\": %.6f,\n", stats->grammar_seconds);
+    fprintf(out, "    \"first_sets\": %.6f,\n", a->first_seconds);
+    fprintf(out, "    \"closure\": %.6f,\n", a->closure_seconds);
+    fprintf(out, "    \"goto\": %.6f,\n", a->goto_seconds);
+    fprintf(out, "    \"state_dedup\": %.6f,\n", a->dedup_seconds);
+    fprintf(out, "    \"lalr_merge\": %.6f,\n", a->merge_seconds);
+    fprintf(out, "    \"table_fill\": %.6f,\n", t->fill_seconds);
+    fprintf(out, "    \"table_shift_goto\": %.6f,\n", t->shift_goto_seconds);
+    fprintf(out, "    \"table_reduce\": %.6f,\n", t->reduce_seconds);
+    fprintf(out, "    \"table_default_reductions\": %.6f,\n", t->default_reduction_seconds);
+    fprintf(out, "    \"table_optimization\": %.6f,\n", stats->optimization_seconds);
+    fprintf(out, "    \"total\": %.6f\n", stats->total_seconds);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"counters\": {\n");
+    fprintf(out, "    \"closure_calls\": %ld,\n", a->closure_calls);
+    fprintf(out, "    \"items_created\": %ld,\n", a->items_created);
+    fprintf(out, "    \"goto_calls\": %ld,\n", a->goto_calls);
+    fprintf(out, "    \"state_probes\": %ld,\n", a->state_probes);
+    fprintf(out, "    \"transition_probes\": %ld,\n", a->transition_probes);
+    fprintf(out, "    \"table_cell_writes\": %ld,\n", t->cell_writes);
+    if (mode == CONSTRUCTION_LALR1)
+    {
+        fprintf(out, "    \"lr1_states\": %d,\n", a->lr1_states);
+    }
+    fprintf(out, "    \"automaton_states\": %d,\n", automaton->num_states);
+    fprintf(out, "    \"table_states\": %d,\n", table->num_states);
+    fprintf(out, "    \"conflicts\": %d\n", table->num_conflicts);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"bytes\": {\n");
+    fprintf(out, "    \"grammar\": %zu,\n", g->memory.bytes_used);
+    fprintf(out, "    \"automaton_allocated\": %zu,\n", a->bytes_allocated);
+    fprintf(out, "    \"automaton_peak\": %zu,\n", a->peak_bytes);
+    fprintf(out, "    \"automaton_retained\": %zu,\n", automaton->memory.bytes_reserved);
+    fprintf(out, "    \"table\": %zu,\n", table_bytes);
+    fprintf(out, "    \"peak\": %zu\n", peak_bytes);
+    fprintf(out, "  }\n");
+    fprintf(out, "}\n");
+}
+
+/**
+ * @brief Returns the number of online processors, used as default worker count.
+ * @return Processor count, at least 1.
+ */
+static int default_job_count(void)
+{
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (int)online : 1;
+}
+
+/**
+ * @brief Program entry point. Builds LALR table and parses the token stream of each source.
+ *
+ * --mode= selects the SLR(1) or canonical LR(1) construction instead of LALR(1).
+ *
+ * One source (or stdin) is parsed with a full trace; --pipeline lexes it on a
+ * separate scanner thread. Several sources, or an
+ * explicit --jobs=N, select batch mode: sources are parsed concurrently on a
+ * thread pool sharing the read-only grammar and table, without tracing, and
+ * --pipeline gives every source a scanner thread of its own. With --edit, the single
+ * source is parsed incrementally and reparsed after each edit.
+ *
  * @param argc CLI argument count.
  * @param argv CLI argument vector.
  * @return 0 on accepted input, non-zero on error/reject.
  */
 int main(int argc, char **argv)
 {
-    const char *source_path = NULL;
     const char *table_output_path = "parse_table.csv";
+    int num_jobs = 0;
+    bool eliminate_units = false;
+    bool minimize_states = false;
+    bool compare_modes = false;
+    bool pipelined = false;
+    const char *entry_name = NULL;
+    bool print_stats = false;
+    construction_mode mode = CONSTRUCTION_LALR1;
 
     if (argc < 2)
     {
-        fprintf(stderr, "Usage: %s <grammar_file> [source_file] [table_output.(csv|json)]\n", argv[0]);
+        print_usage(argv[0]);
         return 1;
     }
 
-    if (argc >= 3)
+    // Every exit after this point goes through cleanup, which releases whatever was created.
+    int exit_code = 1;
+    grammar *g = NULL;
+    FILE *source = NULL;
+    lalr1_automaton *automaton = NULL;
+    parser_table *table = NULL;
+    char **source_paths = (char **)calloc((size_t)argc, sizeof(char *));
+    char **edit_specs = (char **)calloc((size_t)argc, sizeof(char *));
+    int num_sources = 0;
+    int num_edits = 0;
+    if (source_paths == NULL || edit_specs == NULL)
+    {
+        fprintf(stderr, "Out of memory.\n");
+        goto cleanup;
+    }
+
+    for (int i = 2; i < argc; i++)
     {
-        if (has_suffix(argv[2], ".csv") || has_suffix(argv[2], ".json"))
+        if (strncmp(argv[i], "--jobs=", 7) == 0)
         {
-            table_output_path = argv[2];
+            num_jobs = atoi(argv[i] + 7);
+            if (num_jobs <= 0)
+            {
+                print_usage(argv[0]);
+                goto cleanup;
+            }
+            continue;
         }
-        else
+
+        if (strncmp(argv[i], "--edit=", 7) == 0)
+        {
+            edit_specs[num_edits++] = argv[i] + 7;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--eliminate-units") == 0)
+        {
+            eliminate_units = true;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--minimize-states") == 0)
+        {
+            minimize_states = true;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--mode=", 7) == 0)
         {
-            source_path = argv[2];
+            if (!parse_construction_mode(argv[i] + 7, &mode))
+            {
+                print_usage(argv[0]);
+                goto cleanup;
+            }
+            continue;
         }
+
+        if (strcmp(argv[i], "--compare-modes") == 0)
+        {
+            compare_modes = true;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--pipeline") == 0)
+        {
+            pipelined = true;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--entry=", 8) == 0)
+        {
+            entry_name = argv[i] + 8;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--stats=", 8) == 0)
+        {
+            if (strcmp(argv[i] + 8, "json") != 0)
+            {
+                print_usage(argv[0]);
+                goto cleanup;
+            }
+            print_stats = true;
+            continue;
+        }
+
+        if (has_suffix(argv[i], ".csv") || has_suffix(argv[i], ".json"))
+        {
+            table_output_path = argv[i];
+            continue;
+        }
+
+        source_paths[num_sources++] = argv[i];
     }
 
-    if (argc >= 4)
+    const bool batch_mode = num_sources > 1 || num_jobs > 0;
+    if (batch_mode && num_jobs == 0)
     {
-        table_output_path = argv[3];
+        num_jobs = default_job_count();
     }
-
-    if (argc > 4)
+    if (num_edits > 0 && (batch_mode || num_sources != 1))
     {
-        fprintf(stderr, "Usage: %s <grammar_file> [source_file] [table_output.(csv|json)]\n", argv[0]);
-        return 1;
+        fprintf(stderr, "--edit needs exactly one source file.\n");
+        goto cleanup;
+    }
+    if (num_edits > 0 && entry_name != NULL)
+    {
+        // The incremental parser always starts in the default entry state.
+        fprintf(stderr, "--entry cannot be combined with --edit.\n");
+        goto cleanup;
     }
 
     char *grammar_file_content = read_file_all(argv[1]);
     if (grammar_file_content == NULL)
     {
         fprintf(stderr, "Failed to read grammar file '%s': %s\n", argv[1], strerror(errno));
-        return 1;
+        goto cleanup;
     }
 
-    grammar *g = create_grammar(grammar_file_content);
+    generation_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    double generation_started = wall_seconds();
+    g = create_grammar(grammar_file_content);
+    stats.grammar_seconds = wall_seconds() - generation_started;
     free(grammar_file_content);
     if (g == NULL)
     {
         fprintf(stderr, "Failed to create grammar from '%s'.\n", argv[1]);
-        return 1;
+        goto cleanup;
+    }
+
+    int entry = 0;
+    if (entry_name != NULL)
+    {
+        entry = get_entry_index(g, entry_name);
+        if (entry < 0)
+        {
+            fprintf(stderr, "Unknown entry point '%s'; declare it with %%start.\n", entry_name);
+            goto cleanup;
+        }
     }
 
-    if (source_path != NULL)
+    if (!batch_mode && num_sources == 1)
     {
-        yyin = fopen(source_path, "r");
-        if (yyin == NULL)
+        source = fopen(source_paths[0], "r");
+        if (source == NULL)
         {
-            fprintf(stderr, "Failed to open source file '%s': %s\n", source_path, strerror(errno));
-            return 1;
+            fprintf(stderr, "Failed to open source file '%s': %s\n", source_paths[0], strerror(errno));
+            goto cleanup;
         }
     }
 
-    lalr1_automaton *automaton = build_lalr1_automaton(g);
+    if (compare_modes && !print_construction_comparison(g))
+    {
+        fprintf(stderr, "Failed to compare table constructions.\n");
+        goto cleanup;
+    }
+
+    // The construction itself (after --compare-modes) is what --stats reports.
+    generation_started = wall_seconds() - stats.grammar_seconds;
+    automaton = build_automaton_for_mode(g, mode, print_stats ? &stats.automaton : NULL);
     if (automaton == NULL)
     {
-        fprintf(stderr, "Failed to build LALR(1) automaton.\n");
-        return 1;
+        fprintf(stderr, "Failed to build %s automaton.\n", construction_mode_names[mode]);
+        goto cleanup;
     }
 
-    parser_table *table = build_lalr1_parser_table(g, automaton);
+    table = build_lalr1_parser_table_profiled(g, automaton, print_stats ? &stats.table : NULL);
     if (table == NULL)
     {
         fprintf(stderr, "Failed to build parsing table.\n");
-        free_lalr1_automaton(automaton);
-        return 1;
+        goto cleanup;
     }
 
     if (table->has_conflicts)
     {
-        fprintf(stderr, "Warning: parser table has %d conflicts.\n", table->num_conflicts);
+        fprintf(stderr, "Warning: parser table has %d conflicts; inputs are parsed with GLR.\n", table->num_conflicts);
+    }
+
+    double optimization_started = wall_seconds();
+    if (eliminate_units)
+    {
+        int bypassed = 0;
+        int added_states = 0;
+        if (!eliminate_unit_reductions(table, &bypassed, &added_states))
+        {
+            fprintf(stderr, "Failed to eliminate unit reductions.\n");
+            goto cleanup;
+        }
+        printf("Unit reductions bypassed on %d GOTO entries (%d states added).\n", bypassed, added_states);
+    }
+
+    if (minimize_states)
+    {
+        int removed_states = 0;
+        if (!minimize_parser_states(table, &removed_states))
+        {
+            fprintf(stderr, "Failed to minimize parser states.\n");
+            goto cleanup;
+        }
+        printf("State minimization removed %d states (%d left).\n", removed_states, table->num_states);
+    }
+    stats.optimization_seconds = wall_seconds() - optimization_started;
+    stats.total_seconds = wall_seconds() - generation_started;
+
+    if (print_stats)
+    {
+        print_generation_stats_json(stderr, g, mode, &stats, automaton, table);
     }
 
     if (!save_parser_table(table, table_output_path))
     {
         fprintf(stderr, "Failed to save parsing table to '%s'. Use .csv or .json extension.\n", table_output_path);
-        free_parser_table(table);
-        free_lalr1_automaton(automaton);
-        if (source_path != NULL && yyin != NULL)
+        goto cleanup;
+    }
+    printf("Parsing table written to %s\n", table_output_path);
+
+    if (num_edits > 0)
+    {
+        exit_code = run_edit_session(table, source_paths[0], edit_specs, num_edits) ? 0 : 2;
+        goto cleanup;
+    }
+
+    if (batch_mode)
+    {
+        int rejected = parse_sources_in_parallel(g, table, entry, source_paths, num_sources, num_jobs, pipelined);
+        if (rejected < 0)
         {
-            fclose(yyin);
+            fprintf(stderr, "Failed to start batch parsing.\n");
         }
-        return 1;
+        else
+        {
+            printf("%d of %d inputs accepted.\n", num_sources - rejected, num_sources);
+        }
+
+        exit_code = rejected == 0 ? 0 : (rejected < 0 ? 1 : 2);
+        goto cleanup;
+    }
+
+    parse_context ctx = {0};
+    ctx.g = g;
+    ctx.table = table;
+    ctx.trace = true;
+    ctx.entry = entry;
+    bool accepted = false;
+    if (yylex_init(&ctx.scanner) != 0)
+    {
+        fprintf(stderr, "Failed to create scanner.\n");
+    }
+    else
+    {
+        // A NULL input makes the scanner read stdin.
+        yyset_in(source, ctx.scanner);
+        if (pipelined)
+        {
+            ctx.pipeline = start_token_pipeline(g, ctx.scanner);
+        }
+        if (pipelined && ctx.pipeline == NULL)
+        {
+            fprintf(stderr, "Failed to start scanner thread.\n");
+        }
+        else
+        {
+            accepted = parse_token_stream(&ctx);
+            stop_token_pipeline(ctx.pipeline);
+        }
+        yylex_destroy(ctx.scanner);
     }
-    printf("Parsing table written to %s\n", table_output_path);
 
-    bool accepted = parse_token_stream(g, table);
     if (accepted)
     {
         printf("Input accepted.\n");
@@ -595,16 +1135,19 @@ int main(int argc, char **argv)
     {
         printf("Input rejected.\n");
     }
+    exit_code = accepted ? 0 : 2;
 
+cleanup:
     free_parser_table(table);
     free_lalr1_automaton(automaton);
-
-    if (source_path != NULL && yyin != NULL)
+    if (source != NULL)
     {
-        fclose(yyin);
+        fclose(source);
     }
-
-    return accepted ? 0 : 2;
+    free_grammar(g);
+    free(source_paths);
+    free(edit_specs);
+    return exit_code;
 }
 
 static bool has_suffix(const char *text, const char *suffix)
@@ -3,6 +3,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+typedef struct table_writer
+{
+    FILE *file;
+    char *buffer;
+    size_t used;
+    size_t capacity;
+    bool failed;
+} table_writer;
 
 static int action_index(const parser_table *table, int state_id, int terminal_or_eof_id);
 static int goto_index(const parser_table *table, int state_id, int non_terminal_id);
@@ -11,8 +21,23 @@ static parser_action make_shift_action(int target_state);
 static parser_action make_reduce_action(int production_index);
 static parser_action make_accept_action(void);
 static bool parser_actions_equal(parser_action left, parser_action right);
-static bool set_action_entry(parser_table *table, int state_id, int terminal_or_eof_id, parser_action action);
+static bool set_action_entry(
+    parser_table *table,
+    int state_id,
+    int terminal_or_eof_id,
+    parser_action action,
+    bool *nonassoc_cells);
+static double profile_clock(const parser_table_profile *profile);
+static bool resolve_by_precedence(
+    const grammar *g,
+    int terminal_or_eof_id,
+    parser_action previous,
+    parser_action action,
+    parser_action *out_resolved);
 static bool set_goto_entry(parser_table *table, int state_id, int non_terminal_id, int target_state);
+static bool keep_conflict_action(parser_table *table, int idx, parser_action action);
+static bool find_default_reductions(parser_table *table, const bool *nonassoc_cells);
+static int compare_conflicts(const void *left, const void *right);
 static bool symbol_is_terminal(const grammar *g, int encoded_symbol_id);
 static const char *symbol_name(const grammar *g, int encoded_symbol_id);
 static const char *lookahead_name(const parser_table *table, int terminal_or_eof_id);
@@ -20,8 +45,23 @@ static void print_action_cell(const parser_table *table, parser_action action);
 static const char *action_type_name(parser_action_type type);
 static bool has_suffix(const char *text, const char *suffix);
 static void write_json_escaped(FILE *file, const char *text);
+static bool open_table_writer(table_writer *writer, const char *output_path);
+static bool close_table_writer(table_writer *writer);
+static void writer_flush(table_writer *writer);
+static void writer_put(table_writer *writer, const char *data, size_t length);
+static void writer_puts(table_writer *writer, const char *text);
+static void writer_put_int(table_writer *writer, int value);
+static void writer_put_json_string(table_writer *writer, const char *text);
 
 parser_table *build_lalr1_parser_table(const grammar *g, const lalr1_automaton *automaton)
+{
+    return build_lalr1_parser_table_profiled(g, automaton, NULL);
+}
+
+parser_table *build_lalr1_parser_table_profiled(
+    const grammar *g,
+    const lalr1_automaton *automaton,
+    parser_table_profile *profile)
 {
     if (g == NULL || automaton == NULL)
     {
@@ -48,11 +88,33 @@ parser_table *build_lalr1_parser_table(const grammar *g, const lalr1_automaton *
     table->action_table = (parser_action *)malloc(
         (size_t)table->num_states * (size_t)table->num_terminals_with_eof * sizeof(parser_action));
     table->goto_table = (int *)malloc((size_t)table->num_states * (size_t)table->num_non_terminals * sizeof(int));
-    if (table->action_table == NULL || table->goto_table == NULL)
+    // The automaton starts entry point k in state k.
+    table->num_entries = g->num_start_symbols > 0 ? g->num_start_symbols : 1;
+    table->entry_states = (int *)malloc((size_t)table->num_entries * sizeof(int));
+    if (table->action_table == NULL || table->goto_table == NULL || table->entry_states == NULL)
     {
         free_parser_table(table);
         return NULL;
     }
+    for (int entry = 0; entry < table->num_entries; entry++)
+    {
+        table->entry_states[entry] = entry;
+    }
+
+    double started = profile_clock(profile);
+
+    // Cells emptied by %nonassoc, so that a later action on them does not refill them.
+    bool *nonassoc_cells = NULL;
+    if (g->terminal_precedence != NULL)
+    {
+        nonassoc_cells =
+            (bool *)calloc((size_t)table->num_states * (size_t)table->num_terminals_with_eof, sizeof(bool));
+        if (nonassoc_cells == NULL)
+        {
+            free_parser_table(table);
+            return NULL;
+        }
+    }
 
     for (int s = 0; s < table->num_states; s++)
     {
@@ -67,6 +129,14 @@ parser_table *build_lalr1_parser_table(const grammar *g, const lalr1_automaton *
         }
     }
 
+    double phase_done = profile_clock(profile);
+    if (profile != NULL)
+    {
+        profile->fill_seconds += phase_done - started;
+        profile->cell_writes += automaton->num_transitions;
+    }
+    started = phase_done;
+
     // 1) Fill SHIFT and GOTO from automaton transitions.
     for (int i = 0; i < automaton->num_transitions; i++)
     {
@@ -77,8 +147,10 @@ parser_table *build_lalr1_parser_table(const grammar *g, const lalr1_automaton *
                     table,
                     transition.from_state,
                     transition.symbol_id,
-                    make_shift_action(transition.to_state)))
+                    make_shift_action(transition.to_state),
+                    nonassoc_cells))
             {
+                free(nonassoc_cells);
                 free_parser_table(table);
                 return NULL;
             }
@@ -88,12 +160,21 @@ parser_table *build_lalr1_parser_table(const grammar *g, const lalr1_automaton *
         int non_terminal_id = transition.symbol_id - g->num_terminals;
         if (!set_goto_entry(table, transition.from_state, non_terminal_id, transition.to_state))
         {
+            free(nonassoc_cells);
             free_parser_table(table);
             return NULL;
         }
     }
 
+    phase_done = profile_clock(profile);
+    if (profile != NULL)
+    {
+        profile->shift_goto_seconds += phase_done - started;
+    }
+    started = phase_done;
+
     // 2) Fill REDUCE and ACCEPT from completed items and lookahead symbols.
+    int reduce_writes = 0;
     for (int state_id = 0; state_id < automaton->num_states; state_id++)
     {
         const lr1_state *state = &automaton->states[state_id];
@@ -105,8 +186,15 @@ parser_table *build_lalr1_parser_table(const grammar *g, const lalr1_automaton *
             {
                 if (item.dot_position == 1 && item.lookahead_id == automaton->eof_lookahead_id)
                 {
-                    if (!set_action_entry(table, state_id, automaton->eof_lookahead_id, make_accept_action()))
+                    reduce_writes++;
+                    if (!set_action_entry(
+                            table,
+                            state_id,
+                            automaton->eof_lookahead_id,
+                            make_accept_action(),
+                            nonassoc_cells))
                     {
+                        free(nonassoc_cells);
                         free_parser_table(table);
                         return NULL;
                     }
@@ -130,17 +218,77 @@ parser_table *build_lalr1_parser_table(const grammar *g, const lalr1_automaton *
                 continue;
             }
 
-            if (!set_action_entry(table, state_id, item.lookahead_id, make_reduce_action(item.production_index)))
+            reduce_writes++;
+            if (!set_action_entry(
+                    table,
+                    state_id,
+                    item.lookahead_id,
+                    make_reduce_action(item.production_index),
+                    nonassoc_cells))
             {
+                free(nonassoc_cells);
                 free_parser_table(table);
                 return NULL;
             }
         }
     }
 
+    phase_done = profile_clock(profile);
+    if (profile != NULL)
+    {
+        profile->reduce_seconds += phase_done - started;
+        profile->cell_writes += reduce_writes;
+    }
+    started = phase_done;
+
+    if (!find_default_reductions(table, nonassoc_cells))
+    {
+        free(nonassoc_cells);
+        free_parser_table(table);
+        return NULL;
+    }
+    free(nonassoc_cells);
+
+    // Group the conflicting actions by cell for get_parser_actions.
+    if (table->num_conflict_actions > 1)
+    {
+        qsort(table->conflict_actions,
+              (size_t)table->num_conflict_actions,
+              sizeof(parser_conflict),
+              compare_conflicts);
+    }
+
+    if (profile != NULL)
+    {
+        profile->default_reduction_seconds += profile_clock(profile) - started;
+        profile->table_bytes = parser_table_bytes(table);
+    }
     return table;
 }
 
+size_t parser_table_bytes(const parser_table *table)
+{
+    if (table == NULL)
+    {
+        return 0;
+    }
+
+    const size_t num_states = (size_t)table->num_states;
+    const size_t num_cells = num_states * (size_t)table->num_terminals_with_eof;
+    size_t bytes = num_cells * sizeof(parser_action) + num_states * (size_t)table->num_non_terminals * sizeof(int);
+    bytes += (size_t)table->conflict_actions_capacity * sizeof(parser_conflict);
+    if (table->conflicted_cells != NULL)
+    {
+        bytes += num_cells * sizeof(bool);
+    }
+    if (table->default_reductions != NULL)
+    {
+        bytes += num_states * sizeof(int);
+    }
+    bytes += (size_t)table->num_entries * sizeof(int);
+    return bytes;
+}
+
 void free_parser_table(parser_table *table)
 {
     if (table == NULL)
@@ -150,6 +298,10 @@ void free_parser_table(parser_table *table)
 
     free(table->action_table);
     free(table->goto_table);
+    free(table->conflict_actions);
+    free(table->conflicted_cells);
+    free(table->default_reductions);
+    free(table->entry_states);
     free(table);
 }
 
@@ -169,6 +321,90 @@ parser_action get_parser_action(const parser_table *table, int state_id, int ter
     return table->action_table[idx];
 }
 
+bool has_parser_action_conflict(const parser_table *table, int state_id, int terminal_or_eof_id)
+{
+    if (table == NULL || table->conflicted_cells == NULL)
+    {
+        return false;
+    }
+
+    int idx = action_index(table, state_id, terminal_or_eof_id);
+    return idx >= 0 && table->conflicted_cells[idx];
+}
+
+int get_parser_actions(
+    const parser_table *table,
+    int state_id,
+    int terminal_or_eof_id,
+    parser_action *out_actions,
+    int max_actions)
+{
+    int idx = action_index(table, state_id, terminal_or_eof_id);
+    if (idx < 0 || table->action_table[idx].type == PARSER_ACTION_ERROR)
+    {
+        return 0;
+    }
+
+    int count = 0;
+    if (max_actions > 0)
+    {
+        out_actions[0] = table->action_table[idx];
+    }
+    count++;
+
+    if (table->conflicted_cells == NULL || !table->conflicted_cells[idx])
+    {
+        return count;
+    }
+
+    // Binary search for the first conflicting action of the cell.
+    int low = 0;
+    int high = table->num_conflict_actions;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (table->conflict_actions[middle].cell < idx)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    for (int i = low; i < table->num_conflict_actions && table->conflict_actions[i].cell == idx; i++)
+    {
+        if (count < max_actions)
+        {
+            out_actions[count] = table->conflict_actions[i].action;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+int get_parser_default_reduction(const parser_table *table, int state_id)
+{
+    if (table == NULL || table->default_reductions == NULL || state_id < 0 || state_id >= table->num_states)
+    {
+        return -1;
+    }
+
+    return table->default_reductions[state_id];
+}
+
+int get_parser_entry_state(const parser_table *table, int entry)
+{
+    if (table == NULL || table->entry_states == NULL || entry < 0 || entry >= table->num_entries)
+    {
+        return -1;
+    }
+
+    return table->entry_states[entry];
+}
+
 int get_parser_goto(const parser_table *table, int state_id, int non_terminal_id)
 {
     if (table == NULL)
@@ -277,6 +513,19 @@ static int goto_index(const parser_table *table, int state_id, int non_terminal_
     return state_id * table->num_non_terminals + non_terminal_id;
 }
 
+static double profile_clock(const parser_table_profile *profile)
+{
+    // Skip the clock read entirely on unprofiled builds.
+    if (profile == NULL)
+    {
+        return 0.0;
+    }
+
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
 static parser_action make_error_action(void)
 {
     parser_action action;
@@ -314,7 +563,12 @@ static bool parser_actions_equal(parser_action left, parser_action right)
     return left.type == right.type && left.value == right.value;
 }
 
-static bool set_action_entry(parser_table *table, int state_id, int terminal_or_eof_id, parser_action action)
+static bool set_action_entry(
+    parser_table *table,
+    int state_id,
+    int terminal_or_eof_id,
+    parser_action action,
+    bool *nonassoc_cells)
 {
     int idx = action_index(table, state_id, terminal_or_eof_id);
     if (idx < 0)
@@ -322,6 +576,13 @@ static bool set_action_entry(parser_table *table, int state_id, int terminal_or_
         return false;
     }
 
+    // %nonassoc made this lookahead a syntax error here; a further reduction on it stays an error
+    // rather than becoming a conflict that the table has no alternatives to show for.
+    if (nonassoc_cells != NULL && nonassoc_cells[idx])
+    {
+        return true;
+    }
+
     parser_action previous = table->action_table[idx];
     if (previous.type == PARSER_ACTION_ERROR)
     {
@@ -334,12 +595,174 @@ static bool set_action_entry(parser_table *table, int state_id, int terminal_or_
         return true;
     }
 
-    // Keep the first action inserted and just report conflict.
+    // Shift/reduce conflicts between symbols with declared precedence are resolved silently.
+    parser_action resolved;
+    if (resolve_by_precedence(table->g, terminal_or_eof_id, previous, action, &resolved))
+    {
+        table->action_table[idx] = resolved;
+        if (resolved.type == PARSER_ACTION_ERROR && nonassoc_cells != NULL)
+        {
+            nonassoc_cells[idx] = true;
+        }
+        return true;
+    }
+
+    // Keep the first action inserted in the table and report the conflict;
+    // the other actions are kept aside for GLR parsing.
     table->has_conflicts = true;
     table->num_conflicts++;
+    return keep_conflict_action(table, idx, action);
+}
+
+static bool resolve_by_precedence(
+    const grammar *g,
+    int terminal_or_eof_id,
+    parser_action previous,
+    parser_action action,
+    parser_action *out_resolved)
+{
+    parser_action shift;
+    parser_action reduce;
+    if (previous.type == PARSER_ACTION_SHIFT && action.type == PARSER_ACTION_REDUCE)
+    {
+        shift = previous;
+        reduce = action;
+    }
+    else if (previous.type == PARSER_ACTION_REDUCE && action.type == PARSER_ACTION_SHIFT)
+    {
+        shift = action;
+        reduce = previous;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (g->terminal_precedence == NULL || terminal_or_eof_id < 0 || terminal_or_eof_id >= g->num_terminals)
+    {
+        return false;
+    }
+
+    int token_precedence = g->terminal_precedence[terminal_or_eof_id];
+    int rule_precedence = get_production_precedence(g, reduce.value);
+    if (token_precedence == 0 || rule_precedence == 0)
+    {
+        return false;
+    }
+
+    if (rule_precedence != token_precedence)
+    {
+        *out_resolved = rule_precedence > token_precedence ? reduce : shift;
+        return true;
+    }
+
+    switch (g->terminal_associativity[terminal_or_eof_id])
+    {
+    case ASSOC_LEFT:
+        *out_resolved = reduce;
+        return true;
+    case ASSOC_RIGHT:
+        *out_resolved = shift;
+        return true;
+    case ASSOC_NONASSOC:
+        *out_resolved = make_error_action();
+        return true;
+    case ASSOC_NONE:
+    default:
+        return false;
+    }
+}
+
+static bool keep_conflict_action(parser_table *table, int idx, parser_action action)
+{
+    for (int i = 0; i < table->num_conflict_actions; i++)
+    {
+        if (table->conflict_actions[i].cell == idx && parser_actions_equal(table->conflict_actions[i].action, action))
+        {
+            return true;
+        }
+    }
+
+    if (table->conflicted_cells == NULL)
+    {
+        table->conflicted_cells =
+            (bool *)calloc((size_t)table->num_states * (size_t)table->num_terminals_with_eof, sizeof(bool));
+        if (table->conflicted_cells == NULL)
+        {
+            return false;
+        }
+    }
+
+    if (table->num_conflict_actions >= table->conflict_actions_capacity)
+    {
+        int new_capacity = table->conflict_actions_capacity == 0 ? 16 : table->conflict_actions_capacity * 2;
+        parser_conflict *resized =
+            (parser_conflict *)realloc(table->conflict_actions, (size_t)new_capacity * sizeof(parser_conflict));
+        if (resized == NULL)
+        {
+            return false;
+        }
+        table->conflict_actions = resized;
+        table->conflict_actions_capacity = new_capacity;
+    }
+
+    table->conflict_actions[table->num_conflict_actions].cell = idx;
+    table->conflict_actions[table->num_conflict_actions].action = action;
+    table->num_conflict_actions++;
+    table->conflicted_cells[idx] = true;
+    return true;
+}
+
+static bool find_default_reductions(parser_table *table, const bool *nonassoc_cells)
+{
+    table->default_reductions = (int *)malloc((size_t)table->num_states * sizeof(int));
+    if (table->default_reductions == NULL)
+    {
+        return false;
+    }
+
+    table->num_default_reductions = 0;
+    for (int state_id = 0; state_id < table->num_states; state_id++)
+    {
+        int production_index = -1;
+        for (int a = 0; a < table->num_terminals_with_eof; a++)
+        {
+            int idx = action_index(table, state_id, a);
+            parser_action action = table->action_table[idx];
+
+            // Errors left by %nonassoc must be detected in this state, before any reduction.
+            bool conflicted = table->conflicted_cells != NULL && table->conflicted_cells[idx];
+            bool nonassoc = nonassoc_cells != NULL && nonassoc_cells[idx];
+            if (conflicted || nonassoc || action.type == PARSER_ACTION_SHIFT || action.type == PARSER_ACTION_ACCEPT ||
+                (action.type == PARSER_ACTION_REDUCE && production_index >= 0 && action.value != production_index))
+            {
+                production_index = -1;
+                break;
+            }
+            if (action.type == PARSER_ACTION_REDUCE)
+            {
+                production_index = action.value;
+            }
+        }
+
+        table->default_reductions[state_id] = production_index;
+        if (production_index >= 0)
+        {
+            table->num_default_reductions++;
+        }
+    }
+
     return true;
 }
 
+static int compare_conflicts(const void *left, const void *right)
+{
+    const parser_conflict *a = (const parser_conflict *)left;
+    const parser_conflict *b = (const parser_conflict *)right;
+
+    return (a->cell > b->cell) - (a->cell < b->cell);
+}
+
 static bool set_goto_entry(parser_table *table, int state_id, int non_terminal_id, int target_state)
 {
     int idx = goto_index(table, state_id, non_terminal_id);
@@ -430,55 +853,55 @@ bool save_parser_table_csv(const parser_table *table, const char *output_path)
         return false;
     }
 
-    FILE *file = fopen(output_path, "w");
-    if (file == NULL)
+    table_writer writer;
+    if (!open_table_writer(&writer, output_path))
     {
         return false;
     }
 
-    // Long-form CSV keeps both ACTION and GOTO in one uniform schema.
-    fprintf(file, "section,state,symbol,entry_type,value\n");
+    // Long-form CSV keeps both ACTION and GOTO in one uniform schema; error cells are left out.
+    writer_puts(&writer, "section,state,symbol,entry_type,value\n");
 
     for (int state_id = 0; state_id < table->num_states; state_id++)
     {
         for (int terminal = 0; terminal < table->num_terminals_with_eof; terminal++)
         {
-            parser_action action = get_parser_action(table, state_id, terminal);
+            parser_action action = table->action_table[action_index(table, state_id, terminal)];
             if (action.type == PARSER_ACTION_ERROR)
             {
                 continue;
             }
 
-            fprintf(file,
-                    "ACTION,%d,\"%s\",%s,%d\n",
-                    state_id,
-                    lookahead_name(table, terminal),
-                    action_type_name(action.type),
-                    action.value);
+            writer_puts(&writer, "ACTION,");
+            writer_put_int(&writer, state_id);
+            writer_puts(&writer, ",\"");
+            writer_puts(&writer, lookahead_name(table, terminal));
+            writer_puts(&writer, "\",");
+            writer_puts(&writer, action_type_name(action.type));
+            writer_puts(&writer, ",");
+            writer_put_int(&writer, action.value);
+            writer_puts(&writer, "\n");
         }
 
         for (int non_terminal = 0; non_terminal < table->num_non_terminals; non_terminal++)
         {
-            int target = get_parser_goto(table, state_id, non_terminal);
+            int target = table->goto_table[goto_index(table, state_id, non_terminal)];
             if (target < 0)
             {
                 continue;
             }
 
-            fprintf(file,
-                    "GOTO,%d,\"%s\",GOTO,%d\n",
-                    state_id,
-                    table->g->non_terminals[non_terminal].symbol,
-                    target);
+            writer_puts(&writer, "GOTO,");
+            writer_put_int(&writer, state_id);
+            writer_puts(&writer, ",\"");
+            writer_puts(&writer, table->g->non_terminals[non_terminal].symbol);
+            writer_puts(&writer, "\",GOTO,");
+            writer_put_int(&writer, target);
+            writer_puts(&writer, "\n");
         }
     }
 
-    if (fclose(file) != 0)
-    {
-        return false;
-    }
-
-    return true;
+    return close_table_writer(&writer);
 }
 
 bool save_parser_table_json(const parser_table *table, const char *output_path)
@@ -531,6 +954,19 @@ bool save_parser_table_json(const parser_table *table, const char *output_path)
     }
     fprintf(file, "],\n");
 
+    // Single-entry tables keep the original layout; otherwise list each entry's start state.
+    if (table->num_entries > 1)
+    {
+        fprintf(file, "  \"entries\": [");
+        for (int entry = 0; entry < table->num_entries; entry++)
+        {
+            fprintf(file, "%s{\"symbol\": \"", entry > 0 ? ", " : "");
+            write_json_escaped(file, table->g->non_terminals[table->g->start_symbol_ids[entry]].symbol);
+            fprintf(file, "\", \"state\": %d}", table->entry_states[entry]);
+        }
+        fprintf(file, "],\n");
+    }
+
     fprintf(file, "  \"action\": [\n");
     for (int state_id = 0; state_id < table->num_states; state_id++)
     {
@@ -588,6 +1024,128 @@ bool save_parser_table_json(const parser_table *table, const char *output_path)
     return true;
 }
 
+bool save_parser_table_sparse_json(const parser_table *table, const char *output_path)
+{
+    if (table == NULL || table->g == NULL || output_path == NULL)
+    {
+        return false;
+    }
+
+    table_writer writer;
+    if (!open_table_writer(&writer, output_path))
+    {
+        return false;
+    }
+
+    writer_puts(&writer, "{\n  \"format\": \"sparse\",\n  \"numStates\": ");
+    writer_put_int(&writer, table->num_states);
+    writer_puts(&writer, ",\n  \"numTerminalsWithEof\": ");
+    writer_put_int(&writer, table->num_terminals_with_eof);
+    writer_puts(&writer, ",\n  \"numNonTerminals\": ");
+    writer_put_int(&writer, table->num_non_terminals);
+    writer_puts(&writer, ",\n  \"hasConflicts\": ");
+    writer_puts(&writer, table->has_conflicts ? "true" : "false");
+    writer_puts(&writer, ",\n  \"numConflicts\": ");
+    writer_put_int(&writer, table->num_conflicts);
+
+    writer_puts(&writer, ",\n  \"terminals\": [");
+    for (int terminal = 0; terminal < table->g->num_terminals; terminal++)
+    {
+        writer_put_json_string(&writer, table->g->terminals[terminal].symbol);
+        writer_puts(&writer, ", ");
+    }
+    writer_puts(&writer, "\"$\"],\n  \"nonTerminals\": [");
+    for (int non_terminal = 0; non_terminal < table->g->num_non_terminals; non_terminal++)
+    {
+        if (non_terminal > 0)
+        {
+            writer_puts(&writer, ", ");
+        }
+        writer_put_json_string(&writer, table->g->non_terminals[non_terminal].symbol);
+    }
+    writer_puts(&writer, "],\n");
+
+    if (table->num_entries > 1)
+    {
+        writer_puts(&writer, "  \"entries\": [");
+        for (int entry = 0; entry < table->num_entries; entry++)
+        {
+            writer_puts(&writer, entry > 0 ? ", {\"symbol\": " : "{\"symbol\": ");
+            writer_put_json_string(&writer, table->g->non_terminals[table->g->start_symbol_ids[entry]].symbol);
+            writer_puts(&writer, ", \"state\": ");
+            writer_put_int(&writer, table->entry_states[entry]);
+            writer_puts(&writer, "}");
+        }
+        writer_puts(&writer, "],\n");
+    }
+
+    // Per state, the production reduced on every lookahead, or -1.
+    writer_puts(&writer, "  \"defaultReductions\": [");
+    for (int state_id = 0; state_id < table->num_states; state_id++)
+    {
+        writer_puts(&writer, state_id > 0 ? ", " : "");
+        writer_put_int(&writer, get_parser_default_reduction(table, state_id));
+    }
+    writer_puts(&writer, "],\n");
+
+    // One array per state with [terminal index, type, value] for each non-error cell
+    // that the state's default reduction does not already cover.
+    writer_puts(&writer, "  \"action\": [\n");
+    for (int state_id = 0; state_id < table->num_states; state_id++)
+    {
+        int default_reduction = get_parser_default_reduction(table, state_id);
+        bool first = true;
+        writer_puts(&writer, "    [");
+        for (int terminal = 0; terminal < table->num_terminals_with_eof; terminal++)
+        {
+            parser_action action = table->action_table[action_index(table, state_id, terminal)];
+            if (action.type == PARSER_ACTION_ERROR ||
+                (action.type == PARSER_ACTION_REDUCE && action.value == default_reduction))
+            {
+                continue;
+            }
+
+            writer_puts(&writer, first ? "[" : ", [");
+            writer_put_int(&writer, terminal);
+            writer_puts(&writer, ",\"");
+            writer_puts(&writer, action_type_name(action.type));
+            writer_puts(&writer, "\",");
+            writer_put_int(&writer, action.value);
+            writer_puts(&writer, "]");
+            first = false;
+        }
+        writer_puts(&writer, state_id < table->num_states - 1 ? "],\n" : "]\n");
+    }
+    writer_puts(&writer, "  ],\n");
+
+    // One array per state with [non-terminal index, target state] for each GOTO entry.
+    writer_puts(&writer, "  \"goto\": [\n");
+    for (int state_id = 0; state_id < table->num_states; state_id++)
+    {
+        bool first = true;
+        writer_puts(&writer, "    [");
+        for (int non_terminal = 0; non_terminal < table->num_non_terminals; non_terminal++)
+        {
+            int target = table->goto_table[goto_index(table, state_id, non_terminal)];
+            if (target < 0)
+            {
+                continue;
+            }
+
+            writer_puts(&writer, first ? "[" : ", [");
+            writer_put_int(&writer, non_terminal);
+            writer_puts(&writer, ",");
+            writer_put_int(&writer, target);
+            writer_puts(&writer, "]");
+            first = false;
+        }
+        writer_puts(&writer, state_id < table->num_states - 1 ? "],\n" : "]\n");
+    }
+    writer_puts(&writer, "  ]\n}\n");
+
+    return close_table_writer(&writer);
+}
+
 bool save_parser_table(const parser_table *table, const char *output_path)
 {
     if (output_path == NULL)
@@ -595,6 +1153,10 @@ bool save_parser_table(const parser_table *table, const char *output_path)
         return false;
     }
 
+    if (has_suffix(output_path, ".sparse.json"))
+    {
+        return save_parser_table_sparse_json(table, output_path);
+    }
     if (has_suffix(output_path, ".json"))
     {
         return save_parser_table_json(table, output_path);
@@ -674,4 +1236,123 @@ static void write_json_escaped(FILE *file, const char *text)
 
         fputc((int)ch, file);
     }
-}
\ No newline at end of file
+}
+static bool open_table_writer(table_writer *writer, const char *output_path)
+{
+    writer->used = 0;
+    writer->capacity = 1 << 20;
+    writer->failed = false;
+    writer->buffer = (char *)malloc(writer->capacity);
+    if (writer->buffer == NULL)
+    {
+        return false;
+    }
+
+    writer->file = fopen(output_path, "w");
+    if (writer->file == NULL)
+    {
+        free(writer->buffer);
+        return false;
+    }
+
+    return true;
+}
+
+static bool close_table_writer(table_writer *writer)
+{
+    writer_flush(writer);
+    bool ok = !writer->failed;
+    if (fclose(writer->file) != 0)
+    {
+        ok = false;
+    }
+
+    free(writer->buffer);
+    writer->buffer = NULL;
+    writer->file = NULL;
+    return ok;
+}
+
+static void writer_flush(table_writer *writer)
+{
+    if (writer->used > 0 && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used)
+    {
+        writer->failed = true;
+    }
+    writer->used = 0;
+}
+
+static void writer_put(table_writer *writer, const char *data, size_t length)
+{
+    if (writer->capacity - writer->used < length)
+    {
+        writer_flush(writer);
+        if (length > writer->capacity)
+        {
+            if (fwrite(data, 1, length, writer->file) != length)
+            {
+                writer->failed = true;
+            }
+            return;
+        }
+    }
+
+    memcpy(writer->buffer + writer->used, data, length);
+    writer->used += length;
+}
+
+static void writer_puts(table_writer *writer, const char *text)
+{
+    writer_put(writer, text, strlen(text));
+}
+
+static void writer_put_int(table_writer *writer, int value)
+{
+    // Digits are produced backwards into a small buffer; unsigned math keeps INT_MIN exact.
+    char digits[12];
+    int length = 0;
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+    do
+    {
+        digits[sizeof(digits) - 1 - (size_t)length++] = (char)('0' + magnitude % 10u);
+        magnitude /= 10u;
+    } while (magnitude > 0);
+
+    if (value < 0)
+    {
+        digits[sizeof(digits) - 1 - (size_t)length++] = '-';
+    }
+
+    writer_put(writer, &digits[sizeof(digits) - (size_t)length], (size_t)length);
+}
+
+static void writer_put_json_string(table_writer *writer, const char *text)
+{
+    writer_put(writer, "\"", 1);
+    for (const char *cursor = text; *cursor != '\0'; cursor++)
+    {
+        switch (*cursor)
+        {
+        case '\\':
+            writer_put(writer, "\\\\", 2);
+            break;
+        case '"':
+            writer_put(writer, "\\\"", 2);
+            break;
+        case '\n':
+            writer_put(writer, "\\n", 2);
+            break;
+        case '\r':
+            writer_put(writer, "\\r", 2);
+            break;
+        case '\t':
+            writer_put(writer, "\\t", 2);
+            break;
+        default:
+            writer_put(writer, cursor, 1);
+            break;
+        }
+    }
+    writer_put(writer, "\"", 1);
+}
@@ -19,6 +19,12 @@ typedef struct parser_action
     int value;
 } parser_action;
 
+typedef struct parser_conflict
+{
+    int cell;
+    parser_action action;
+} parser_conflict;
+
 typedef struct parser_table
 {
     const grammar *g;
@@ -29,16 +35,69 @@ typedef struct parser_table
     int *goto_table;
     bool has_conflicts;
     int num_conflicts;
+    // Actions that lost a conflict to the ACTION entry, sorted by cell; kept for GLR parsing.
+    parser_conflict *conflict_actions;
+    int num_conflict_actions;
+    int conflict_actions_capacity;
+    // Per ACTION cell, true when conflict_actions holds more actions for it; NULL without conflicts.
+    bool *conflicted_cells;
+    // Per state, the production reduced on every valid lookahead when that is the state's only
+    // action (a consistent state), or -1. The driver reduces there without reading a token.
+    int *default_reductions;
+    int num_default_reductions;
+    // Start state of each grammar entry point (%start), in declaration order.
+    int *entry_states;
+    int num_entries;
 } parser_table;
 
+typedef struct parser_table_profile
+{
+    // Wall-clock seconds spent in each table construction phase.
+    double fill_seconds;
+    double shift_goto_seconds;
+    double reduce_seconds;
+    double default_reduction_seconds;
+    // SHIFT, GOTO, REDUCE and ACCEPT cells written, conflicting writes included.
+    long cell_writes;
+    // Heap bytes held by the finished table.
+    size_t table_bytes;
+} parser_table_profile;
+
 /**
  * @brief Builds ACTION and GOTO tables from a ready LALR(1) automaton.
+ *
+ * Reductions come from the lookaheads of completed items, so the SLR(1) and
+ * canonical LR(1) automata build their tables the same way.
+ *
  * @param g Parsed grammar used by the automaton.
- * @param automaton LALR(1) automaton with merged kernels and lookaheads.
+ * @param automaton LALR(1) automaton with merged kernels and lookaheads, or an SLR(1)/LR(1) one.
  * @return Allocated parser table, or NULL on allocation/input error.
  */
 parser_table *build_lalr1_parser_table(const grammar *g, const lalr1_automaton *automaton);
 
+/**
+ * @brief Builds the parser table like build_lalr1_parser_table and profiles it.
+ *
+ * Error filling, SHIFT/GOTO filling, REDUCE/ACCEPT filling and the default
+ * reduction pass are timed separately and added to the profile.
+ *
+ * @param g Parsed grammar used by the automaton.
+ * @param automaton LALR(1), SLR(1) or LR(1) automaton.
+ * @param profile Zero-initialized profile to accumulate into; may be NULL.
+ * @return Allocated parser table, or NULL on allocation/input error.
+ */
+parser_table *build_lalr1_parser_table_profiled(
+    const grammar *g,
+    const lalr1_automaton *automaton,
+    parser_table_profile *profile);
+
+/**
+ * @brief Counts the heap bytes held by a parser table.
+ * @param table Parser table.
+ * @return Bytes of the ACTION, GOTO, conflict, default reduction and entry arrays.
+ */
+size_t parser_table_bytes(const parser_table *table);
+
 /**
  * @brief Frees all memory owned by a parser table.
  * @param table Parser table to release.
@@ -55,6 +114,47 @@ void free_parser_table(parser_table *table);
  */
 parser_action get_parser_action(const parser_table *table, int state_id, int terminal_or_eof_id);
 
+/**
+ * @brief Tells whether an ACTION cell has more than one action.
+ * @param table Parser table.
+ * @param state_id State index.
+ * @param terminal_or_eof_id Terminal id or EOF id.
+ * @return true when the cell kept conflicting actions.
+ */
+bool has_parser_action_conflict(const parser_table *table, int state_id, int terminal_or_eof_id);
+
+/**
+ * @brief Reads every action of one ACTION cell, conflicting ones included.
+ * @param table Parser table.
+ * @param state_id State index.
+ * @param terminal_or_eof_id Terminal id or EOF id.
+ * @param out_actions Output array; the ACTION entry comes first.
+ * @param max_actions Capacity of out_actions.
+ * @return Number of actions in the cell (0 for an error cell); may exceed max_actions.
+ */
+int get_parser_actions(
+    const parser_table *table,
+    int state_id,
+    int terminal_or_eof_id,
+    parser_action *out_actions,
+    int max_actions);
+
+/**
+ * @brief Reads the default reduction of a state.
+ * @param table Parser table.
+ * @param state_id State index.
+ * @return Production index reduced regardless of the lookahead, or -1 when the state needs one.
+ */
+int get_parser_default_reduction(const parser_table *table, int state_id);
+
+/**
+ * @brief Reads the start state of one entry point.
+ * @param table Parser table.
+ * @param entry Entry index from get_entry_index; 0 is the default entry.
+ * @return State the parser starts in, or -1 for an invalid entry.
+ */
+int get_parser_entry_state(const parser_table *table, int entry);
+
 /**
  * @brief Reads one GOTO entry.
  * @param table Parser table.
@@ -72,7 +172,7 @@ int get_parser_goto(const parser_table *table, int state_id, int non_terminal_id
 void print_parser_table(const parser_table *table);
 
 /**
- * @brief Saves parser table in CSV format.
+ * @brief Saves parser table in CSV format, one row per non-error ACTION cell and GOTO entry.
  * @param table Parser table to serialize.
  * @param output_path Destination CSV path.
  * @return true on success, false on I/O or invalid input error.
@@ -87,10 +187,30 @@ bool save_parser_table_csv(const parser_table *table, const char *output_path);
  */
 bool save_parser_table_json(const parser_table *table, const char *output_path);
 
+/**
+ * @brief Saves parser table in sparse JSON format.
+ *
+ * Same header as save_parser_table_json, but each state lists only its non-error
+ * ACTION cells as [terminal index, type, value] and its GOTO entries as
+ * [non-terminal index, target state]. States with a default reduction
+ * (get_parser_default_reduction) record it in "defaultReductions" and leave out
+ * the reduce cells it covers; the state then reduces on every lookahead, as the
+ * push parser does. Output goes through a large buffer.
+ *
+ * @param table Parser table to serialize.
+ * @param output_path Destination JSON path.
+ * @return true on success, false on I/O or invalid input error.
+ */
+bool save_parser_table_sparse_json(const parser_table *table, const char *output_path);
+
 /**
  * @brief Saves parser table as CSV or JSON based on file extension.
+ *
+ * Paths ending in .sparse.json get the sparse JSON format; other .json paths get
+ * the dense one.
+ *
  * @param table Parser table to serialize.
- * @param output_path Destination path (.csv or .json).
+ * @param output_path Destination path (.csv, .json or .sparse.json).
  * @return true on success, false on unsupported extension or I/O error.
  */
 bool save_parser_table(const parser_table *table, const char *output_path);
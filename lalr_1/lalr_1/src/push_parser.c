@@ -0,0 +1,481 @@
+#include "push_parser.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool push_state(push_parser *parser, int state_id);
+static int top_state(const push_parser *parser);
+static int reduction_pop_count(const push_parser *parser, production p);
+static bool resync_stack(push_parser *parser, int terminal_or_eof_id);
+static push_parser_status fail(push_parser *parser, const char *internal_error);
+static push_parser_status start_recovery(push_parser *parser, int terminal_or_eof_id, const char *lexeme);
+static push_parser_status run_actions(push_parser *parser, int terminal_or_eof_id, const char *lexeme);
+static push_parser_status run_default_reductions(push_parser *parser);
+static push_parser_status reduce_by(push_parser *parser, int production_index);
+static void trace_step(const push_parser *parser, const char *lexeme);
+static void trace_reduce(const push_parser *parser, int production_index);
+static const char *lookahead_name(const grammar *g, int terminal_or_eof_id);
+
+push_parser *create_push_parser(const parser_table *table)
+{
+    return create_push_parser_for_entry(table, 0);
+}
+
+push_parser *create_push_parser_for_entry(const parser_table *table, int entry)
+{
+    int start_state = get_parser_entry_state(table, entry);
+    if (table == NULL || table->g == NULL || start_state < 0)
+    {
+        return NULL;
+    }
+
+    push_parser *parser = (push_parser *)calloc(1, sizeof(push_parser));
+    if (parser == NULL)
+    {
+        return NULL;
+    }
+
+    parser->table = table;
+    parser->start_state = start_state;
+    parser->capacity = 64;
+    parser->states = (int *)malloc((size_t)parser->capacity * sizeof(int));
+    if (parser->states == NULL)
+    {
+        free(parser);
+        return NULL;
+    }
+
+    parser->epsilon_id = -1;
+    const grammar *g = table->g;
+    for (int i = 0; i < g->num_terminals; i++)
+    {
+        if (strcmp(g->terminals[i].symbol, "epsilon") == 0)
+        {
+            parser->epsilon_id = i;
+            break;
+        }
+    }
+    parser->recovery_enabled = g->num_sync_terminals > 0;
+
+    reset_push_parser(parser);
+    return parser;
+}
+
+void free_push_parser(push_parser *parser)
+{
+    if (parser == NULL)
+    {
+        return;
+    }
+
+    free(parser->states);
+    free(parser);
+}
+
+void reset_push_parser(push_parser *parser)
+{
+    if (parser == NULL)
+    {
+        return;
+    }
+
+    parser->size = 0;
+    parser->states[parser->size++] = parser->start_state;
+    parser->skipping = false;
+    parser->resume_on_next = false;
+    parser->recovering = false;
+    parser->finished = false;
+    parser->error_count = 0;
+    parser->error_state = -1;
+    parser->internal_error = NULL;
+}
+
+push_parser_status push_parser_feed(push_parser *parser, int terminal_or_eof_id, const char *lexeme)
+{
+    if (parser == NULL)
+    {
+        return PUSH_PARSER_ERROR;
+    }
+    if (parser->finished)
+    {
+        return PUSH_PARSER_ERROR;
+    }
+
+    const grammar *g = parser->table->g;
+    const int eof_id = g->num_terminals;
+
+    if (parser->skipping)
+    {
+        bool at_eof = terminal_or_eof_id == eof_id;
+        bool resume_on_next = parser->resume_on_next;
+        parser->resume_on_next = false;
+        if (!at_eof && !resume_on_next && !is_sync_terminal(g, terminal_or_eof_id))
+        {
+            return PUSH_PARSER_NEED_MORE;
+        }
+
+        if (!resync_stack(parser, terminal_or_eof_id))
+        {
+            if (at_eof)
+            {
+                return fail(parser, NULL);
+            }
+            // A terminator such as ';' closes the broken construct: drop it and resume on what follows.
+            parser->resume_on_next = is_sync_terminal(g, terminal_or_eof_id);
+            return PUSH_PARSER_NEED_MORE;
+        }
+
+        parser->skipping = false;
+        if (parser->trace != NULL)
+        {
+            fprintf(parser->trace,
+                    "Recovery: resume in state %d on %s\n",
+                    top_state(parser),
+                    lookahead_name(g, terminal_or_eof_id));
+        }
+    }
+
+    return run_actions(parser, terminal_or_eof_id, lexeme);
+}
+
+push_parser_status push_parser_feed_batch(
+    push_parser *parser,
+    const int *terminal_ids,
+    int count,
+    int *out_consumed)
+{
+    push_parser_status status = PUSH_PARSER_NEED_MORE;
+    int consumed = 0;
+
+    if (parser == NULL || (terminal_ids == NULL && count > 0))
+    {
+        status = PUSH_PARSER_ERROR;
+        count = 0;
+    }
+
+    while (consumed < count)
+    {
+        status = push_parser_feed(parser, terminal_ids[consumed], NULL);
+        consumed++;
+        if (status != PUSH_PARSER_NEED_MORE)
+        {
+            break;
+        }
+    }
+
+    if (out_consumed != NULL)
+    {
+        *out_consumed = consumed;
+    }
+
+    return status;
+}
+
+static push_parser_status run_actions(push_parser *parser, int terminal_or_eof_id, const char *lexeme)
+{
+    const parser_table *table = parser->table;
+
+    while (true)
+    {
+        push_parser_status status = run_default_reductions(parser);
+        if (status != PUSH_PARSER_NEED_MORE)
+        {
+            return status;
+        }
+
+        trace_step(parser, lexeme);
+
+        int state_id = top_state(parser);
+        parser_action action = get_parser_action(table, state_id, terminal_or_eof_id);
+
+        if (action.type == PARSER_ACTION_SHIFT)
+        {
+            if (parser->trace != NULL)
+            {
+                fprintf(parser->trace, "Action: SHIFT to state %d\n", action.value);
+            }
+            if (!push_state(parser, action.value))
+            {
+                return fail(parser, "Parser stack overflow while shifting.");
+            }
+
+            parser->recovering = false;
+            // Reduce in consistent states now, so the next token is only needed by a state that reads it.
+            return run_default_reductions(parser);
+        }
+
+        if (action.type == PARSER_ACTION_REDUCE)
+        {
+            trace_reduce(parser, action.value);
+            status = reduce_by(parser, action.value);
+            if (status != PUSH_PARSER_NEED_MORE)
+            {
+                return status;
+            }
+
+            continue;
+        }
+
+        if (action.type == PARSER_ACTION_ACCEPT)
+        {
+            if (parser->trace != NULL)
+            {
+                fprintf(parser->trace, "Action: ACCEPT\n");
+            }
+            parser->finished = true;
+            return parser->error_count == 0 ? PUSH_PARSER_ACCEPT : PUSH_PARSER_ERROR;
+        }
+
+        if (parser->trace != NULL)
+        {
+            fprintf(parser->trace, "Action: ERROR\n");
+        }
+        parser->error_state = state_id;
+        return start_recovery(parser, terminal_or_eof_id, lexeme);
+    }
+}
+
+static push_parser_status run_default_reductions(push_parser *parser)
+{
+    while (true)
+    {
+        int production_index = get_parser_default_reduction(parser->table, top_state(parser));
+        if (production_index < 0)
+        {
+            return PUSH_PARSER_NEED_MORE;
+        }
+
+        if (parser->trace != NULL)
+        {
+            fprintf(parser->trace, "\n============================\n");
+            fprintf(parser->trace, "Top state: %d\n", top_state(parser));
+            fprintf(parser->trace, "Lookahead: (default reduction)\n");
+        }
+        trace_reduce(parser, production_index);
+
+        push_parser_status status = reduce_by(parser, production_index);
+        if (status != PUSH_PARSER_NEED_MORE)
+        {
+            return status;
+        }
+    }
+}
+
+static push_parser_status reduce_by(push_parser *parser, int production_index)
+{
+    const parser_table *table = parser->table;
+    const grammar *g = table->g;
+
+    if (production_index < 0 || production_index >= g->num_productions)
+    {
+        return fail(parser, "Invalid reduction production index.");
+    }
+
+    production p = g->productions[production_index];
+    int pop_count = reduction_pop_count(parser, p);
+    if (pop_count < 0 || parser->size - pop_count <= 0)
+    {
+        return fail(parser, "Invalid parser stack pop for reduction.");
+    }
+    parser->size -= pop_count;
+
+    int goto_state = get_parser_goto(table, top_state(parser), p.non_terminal_id);
+    if (goto_state < 0)
+    {
+        return fail(parser, "Missing GOTO after reduction.");
+    }
+    if (!push_state(parser, goto_state))
+    {
+        return fail(parser, "Parser stack overflow after reduction.");
+    }
+
+    return PUSH_PARSER_NEED_MORE;
+}
+
+static push_parser_status start_recovery(push_parser *parser, int terminal_or_eof_id, const char *lexeme)
+{
+    const grammar *g = parser->table->g;
+    const int eof_id = g->num_terminals;
+
+    if (!parser->recovery_enabled)
+    {
+        // Unmapped tokens are reported by the token source, so only count real syntax errors.
+        if (terminal_or_eof_id >= 0)
+        {
+            parser->error_count++;
+        }
+        return fail(parser, NULL);
+    }
+
+    if (parser->recovering)
+    {
+        // The previous recovery made no progress: this is a cascade, drop the token silently.
+        if (terminal_or_eof_id == eof_id)
+        {
+            return fail(parser, NULL);
+        }
+        parser->skipping = true;
+        return PUSH_PARSER_NEED_MORE;
+    }
+
+    if (terminal_or_eof_id >= 0)
+    {
+        parser->error_count++;
+    }
+    parser->recovering = true;
+    parser->skipping = true;
+
+    // The offending token may itself be the synchronising point.
+    if (terminal_or_eof_id == eof_id || is_sync_terminal(g, terminal_or_eof_id))
+    {
+        push_parser_feed(parser, terminal_or_eof_id, lexeme);
+    }
+
+    return PUSH_PARSER_ERROR;
+}
+
+static bool resync_stack(push_parser *parser, int terminal_or_eof_id)
+{
+    const parser_table *table = parser->table;
+
+    for (int depth = parser->size - 1; depth >= 0; depth--)
+    {
+        int state_id = parser->states[depth];
+        if (get_parser_action(table, state_id, terminal_or_eof_id).type != PARSER_ACTION_ERROR)
+        {
+            parser->size = depth + 1;
+            return true;
+        }
+
+        // Assume a whole non-terminal was recognised when its GOTO state can continue on the terminal.
+        for (int non_terminal = 0; non_terminal < table->num_non_terminals; non_terminal++)
+        {
+            int goto_state = get_parser_goto(table, state_id, non_terminal);
+            if (goto_state < 0 ||
+                get_parser_action(table, goto_state, terminal_or_eof_id).type == PARSER_ACTION_ERROR)
+            {
+                continue;
+            }
+
+            parser->size = depth + 1;
+            return push_state(parser, goto_state);
+        }
+    }
+
+    return false;
+}
+
+static push_parser_status fail(push_parser *parser, const char *internal_error)
+{
+    parser->finished = true;
+    parser->skipping = false;
+    parser->resume_on_next = false;
+    if (internal_error != NULL)
+    {
+        parser->internal_error = internal_error;
+    }
+    return PUSH_PARSER_ERROR;
+}
+
+static bool push_state(push_parser *parser, int state_id)
+{
+    if (parser->size >= parser->capacity)
+    {
+        int new_capacity = parser->capacity * 2;
+        int *resized = (int *)realloc(parser->states, (size_t)new_capacity * sizeof(int));
+        if (resized == NULL)
+        {
+            return false;
+        }
+        parser->states = resized;
+        parser->capacity = new_capacity;
+    }
+
+    parser->states[parser->size++] = state_id;
+    return true;
+}
+
+static int top_state(const push_parser *parser)
+{
+    if (parser->size <= 0)
+    {
+        return -1;
+    }
+
+    return parser->states[parser->size - 1];
+}
+
+static int reduction_pop_count(const push_parser *parser, production p)
+{
+    int count = 0;
+
+    for (int i = 0; i < p.production_length; i++)
+    {
+        if (p.production_symbol_ids[i] == parser->epsilon_id)
+        {
+            continue;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+static void trace_step(const push_parser *parser, const char *lexeme)
+{
+    if (parser->trace == NULL)
+    {
+        return;
+    }
+
+    fprintf(parser->trace, "\n============================\n");
+    fprintf(parser->trace, "Top state: %d\n", top_state(parser));
+    if (lexeme == NULL || lexeme[0] == '\0')
+    {
+        fprintf(parser->trace, "Lookahead: $\n");
+    }
+    else
+    {
+        fprintf(parser->trace, "Lookahead: %s\n", lexeme);
+    }
+}
+
+static void trace_reduce(const push_parser *parser, int production_index)
+{
+    const grammar *g = parser->table->g;
+
+    if (parser->trace == NULL || production_index < 0 || production_index >= g->num_productions)
+    {
+        return;
+    }
+
+    production p = g->productions[production_index];
+    fprintf(parser->trace,
+            "Action: REDUCE by p%d: %s -> ",
+            production_index,
+            g->non_terminals[p.non_terminal_id].symbol);
+
+    for (int i = 0; i < p.production_length; i++)
+    {
+        int symbol_id = p.production_symbol_ids[i];
+        if (symbol_id < g->num_terminals)
+        {
+            fprintf(parser->trace, "%s ", g->terminals[symbol_id].symbol);
+        }
+        else
+        {
+            fprintf(parser->trace, "%s ", g->non_terminals[symbol_id - g->num_terminals].symbol);
+        }
+    }
+    fprintf(parser->trace, "\n");
+}
+
+static const char *lookahead_name(const grammar *g, int terminal_or_eof_id)
+{
+    if (terminal_or_eof_id >= 0 && terminal_or_eof_id < g->num_terminals)
+    {
+        return g->terminals[terminal_or_eof_id].symbol;
+    }
+
+    return "$";
+}
@@ -0,0 +1,107 @@
+#ifndef PUSH_PARSER_H
+#define PUSH_PARSER_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "parser.h"
+
+typedef enum push_parser_status
+{
+    PUSH_PARSER_NEED_MORE = 0,
+    PUSH_PARSER_ACCEPT,
+    PUSH_PARSER_ERROR
+} push_parser_status;
+
+typedef struct push_parser
+{
+    const parser_table *table;
+    // Bottom of the stack: the start state of the entry point being parsed.
+    int start_state;
+    int *states;
+    int size;
+    int capacity;
+    int epsilon_id;
+    // Panic-mode recovery is enabled when the grammar declares %sync terminals.
+    bool recovery_enabled;
+    // Input is being discarded until a synchronising terminal or EOF arrives.
+    bool skipping;
+    // A synchronising terminal no stack state acts on was consumed as the end of the broken construct;
+    // the next token resumes in the nearest state that can start a new one.
+    bool resume_on_next;
+    // No token has been shifted since the last recovery; new errors are cascades.
+    bool recovering;
+    // Accepted or failed for good; every further token is rejected.
+    bool finished;
+    int error_count;
+    int error_state;
+    // Reason of an internal (non-syntax) failure, or NULL.
+    const char *internal_error;
+    // Step-by-step trace destination, or NULL for no trace.
+    FILE *trace;
+} push_parser;
+
+/**
+ * @brief Creates a push parser positioned at the start state of a parser table.
+ * @param table ACTION/GOTO table; it is only read and must outlive the parser.
+ * @return Newly allocated parser, or NULL on allocation/input error.
+ */
+push_parser *create_push_parser(const parser_table *table);
+
+/**
+ * @brief Creates a push parser that parses one entry point of the grammar.
+ * @param table ACTION/GOTO table; it is only read and must outlive the parser.
+ * @param entry Entry index from get_entry_index; 0 gives the same parser as create_push_parser.
+ * @return Newly allocated parser, or NULL on allocation/input error or an invalid entry.
+ */
+push_parser *create_push_parser_for_entry(const parser_table *table, int entry);
+
+/**
+ * @brief Releases a push parser and its state stack.
+ * @param parser Parser to free.
+ * @return This function does not return a value.
+ */
+void free_push_parser(push_parser *parser);
+
+/**
+ * @brief Resets a push parser so it can parse a new input with the same table.
+ * @param parser Parser to reset.
+ * @return This function does not return a value.
+ */
+void reset_push_parser(push_parser *parser);
+
+/**
+ * @brief Feeds one token and runs every action it enables.
+ *
+ * Reductions triggered by the token are performed and the token is shifted.
+ * Default reductions of consistent states that follow the shift are performed
+ * right away, before the next token is requested.
+ * On a syntax error with recovery enabled, the parser keeps accepting input:
+ * tokens are discarded until a %sync terminal (or EOF) lets it resume. A
+ * terminator-style %sync terminal that no state on the stack acts on is
+ * consumed, and the parse resumes on the token after it, as yacc does for
+ * `error ';'`.
+ *
+ * @param parser Push parser.
+ * @param terminal_or_eof_id Terminal id, g->num_terminals for EOF, or a negative id for an unmapped token.
+ * @param lexeme Token text shown in the trace; may be NULL.
+ * @return NEED_MORE when the token was consumed, ACCEPT once EOF is accepted without errors,
+ *         ERROR when a new error is detected on this token or the parse ends unsuccessfully.
+ */
+push_parser_status push_parser_feed(push_parser *parser, int terminal_or_eof_id, const char *lexeme);
+
+/**
+ * @brief Feeds a batch of tokens, stopping at the first status other than NEED_MORE.
+ * @param parser Push parser.
+ * @param terminal_ids Terminal ids (g->num_terminals for EOF).
+ * @param count Number of ids in terminal_ids.
+ * @param out_consumed Optional output with the number of tokens consumed.
+ * @return Status of the last consumed token, NEED_MORE for an empty batch.
+ */
+push_parser_status push_parser_feed_batch(
+    push_parser *parser,
+    const int *terminal_ids,
+    int count,
+    int *out_consumed);
+
+#endif // PUSH_PARSER_H
@@ -0,0 +1,660 @@
+#include "table_opt.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct goto_rewrite
+{
+    int state_id;
+    int non_terminal_id;
+    int target_state;
+} goto_rewrite;
+
+typedef struct unit_rows
+{
+    // Rows of the states added by the pass, num_terminals_with_eof / num_non_terminals wide.
+    parser_action *actions;
+    int *gotos;
+    unsigned long *hashes;
+    int count;
+    int capacity;
+} unit_rows;
+
+static bool *find_unit_productions(const grammar *g);
+static bool has_unit_reduction(const parser_table *table, const bool *is_unit, int state_id);
+static bool build_bypass_row(
+    const parser_table *table,
+    const bool *is_unit,
+    int state_id,
+    int non_terminal_id,
+    parser_action *out_actions,
+    int *out_gotos);
+static int intern_row(unit_rows *rows, const parser_table *table, const parser_action *actions, const int *gotos);
+static unsigned long hash_row(const parser_table *table, const parser_action *actions, const int *gotos);
+static bool append_rows(parser_table *table, const unit_rows *rows);
+static int refine_state_classes(
+    const parser_table *table,
+    bool first_round,
+    int *classes,
+    int *signatures,
+    int *buckets,
+    size_t num_buckets,
+    int *next);
+static void build_state_signature(const parser_table *table, const int *classes, int state_id, bool first_round, int *out);
+static bool *find_reachable_states(const parser_table *table);
+static int renumber_states(parser_table *table, const int *classes, int num_classes);
+
+bool eliminate_unit_reductions(parser_table *table, int *out_bypassed, int *out_added_states)
+{
+    if (out_bypassed != NULL)
+    {
+        *out_bypassed = 0;
+    }
+    if (out_added_states != NULL)
+    {
+        *out_added_states = 0;
+    }
+    if (table == NULL || table->g == NULL)
+    {
+        return false;
+    }
+    if (table->has_conflicts)
+    {
+        // GLR keeps extra actions per cell; bypassing them is not supported.
+        return true;
+    }
+
+    bool *is_unit = find_unit_productions(table->g);
+    if (is_unit == NULL)
+    {
+        return false;
+    }
+
+    const int num_states = table->num_states;
+    const int num_non_terminals = table->num_non_terminals;
+    parser_action *row_actions =
+        (parser_action *)malloc((size_t)table->num_terminals_with_eof * sizeof(parser_action));
+    int *row_gotos = (int *)malloc((size_t)num_non_terminals * sizeof(int));
+    goto_rewrite *rewrites = NULL;
+    int num_rewrites = 0;
+    int rewrites_capacity = 0;
+    unit_rows rows = {0};
+    bool ok = row_actions != NULL && row_gotos != NULL;
+
+    // Every row is computed from the original table; rewrites are applied at the end.
+    for (int s = 0; s < num_states && ok; s++)
+    {
+        for (int nt = 0; nt < num_non_terminals && ok; nt++)
+        {
+            int target = table->goto_table[s * num_non_terminals + nt];
+            if (target < 0 || !has_unit_reduction(table, is_unit, target))
+            {
+                continue;
+            }
+            if (!build_bypass_row(table, is_unit, s, nt, row_actions, row_gotos))
+            {
+                continue;
+            }
+
+            int added = intern_row(&rows, table, row_actions, row_gotos);
+            if (added < 0)
+            {
+                ok = false;
+                break;
+            }
+
+            if (num_rewrites >= rewrites_capacity)
+            {
+                int new_capacity = rewrites_capacity == 0 ? 16 : rewrites_capacity * 2;
+                goto_rewrite *resized = (goto_rewrite *)realloc(rewrites, (size_t)new_capacity * sizeof(goto_rewrite));
+                if (resized == NULL)
+                {
+                    ok = false;
+                    break;
+                }
+                rewrites = resized;
+                rewrites_capacity = new_capacity;
+            }
+            rewrites[num_rewrites].state_id = s;
+            rewrites[num_rewrites].non_terminal_id = nt;
+            rewrites[num_rewrites].target_state = num_states + added;
+            num_rewrites++;
+        }
+    }
+
+    ok = ok && append_rows(table, &rows);
+    if (ok)
+    {
+        for (int i = 0; i < num_rewrites; i++)
+        {
+            table->goto_table[rewrites[i].state_id * num_non_terminals + rewrites[i].non_terminal_id] =
+                rewrites[i].target_state;
+        }
+        if (out_bypassed != NULL)
+        {
+            *out_bypassed = num_rewrites;
+        }
+        if (out_added_states != NULL)
+        {
+            *out_added_states = rows.count;
+        }
+    }
+
+    free(rows.actions);
+    free(rows.gotos);
+    free(rows.hashes);
+    free(rewrites);
+    free(row_gotos);
+    free(row_actions);
+    free(is_unit);
+    return ok;
+}
+
+static bool *find_unit_productions(const grammar *g)
+{
+    bool *is_unit = (bool *)calloc((size_t)(g->num_productions > 0 ? g->num_productions : 1), sizeof(bool));
+    if (is_unit == NULL)
+    {
+        return NULL;
+    }
+
+    for (int i = 0; i < g->num_productions; i++)
+    {
+        production p = g->productions[i];
+        is_unit[i] = p.production_length == 1 && p.production_symbol_ids[0] >= g->num_terminals;
+    }
+
+    return is_unit;
+}
+
+static bool has_unit_reduction(const parser_table *table, const bool *is_unit, int state_id)
+{
+    const parser_action *row = &table->action_table[state_id * table->num_terminals_with_eof];
+
+    for (int a = 0; a < table->num_terminals_with_eof; a++)
+    {
+        if (row[a].type == PARSER_ACTION_REDUCE && is_unit[row[a].value])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool build_bypass_row(
+    const parser_table *table,
+    const bool *is_unit,
+    int state_id,
+    int non_terminal_id,
+    parser_action *out_actions,
+    int *out_gotos)
+{
+    const grammar *g = table->g;
+    const int width = table->num_terminals_with_eof;
+    const int num_non_terminals = table->num_non_terminals;
+
+    for (int nt = 0; nt < num_non_terminals; nt++)
+    {
+        out_gotos[nt] = -1;
+    }
+
+    for (int a = 0; a < width; a++)
+    {
+        // The state on top sits right above state_id, so a unit reduction pops it and
+        // goes to GOTO(state_id, lhs); follow that until a non-unit action.
+        int current = table->goto_table[state_id * num_non_terminals + non_terminal_id];
+        parser_action action = table->action_table[current * width + a];
+        int steps = 0;
+        while (action.type == PARSER_ACTION_REDUCE && is_unit[action.value])
+        {
+            if (++steps > num_non_terminals)
+            {
+                // Cyclic unit productions never end; leave this entry alone.
+                return false;
+            }
+
+            int lhs = g->productions[action.value].non_terminal_id;
+            current = table->goto_table[state_id * num_non_terminals + lhs];
+            if (current < 0)
+            {
+                return false;
+            }
+            action = table->action_table[current * width + a];
+        }
+
+        out_actions[a] = action;
+        if (action.type == PARSER_ACTION_ERROR)
+        {
+            continue;
+        }
+
+        // Reductions that later return to the new state continue with the GOTO row of
+        // the state the action came from; the rows of all those states must agree.
+        const int *gotos = &table->goto_table[current * num_non_terminals];
+        for (int nt = 0; nt < num_non_terminals; nt++)
+        {
+            if (gotos[nt] < 0)
+            {
+                continue;
+            }
+            if (out_gotos[nt] >= 0 && out_gotos[nt] != gotos[nt])
+            {
+                return false;
+            }
+            out_gotos[nt] = gotos[nt];
+        }
+    }
+
+    return true;
+}
+
+static int intern_row(unit_rows *rows, const parser_table *table, const parser_action *actions, const int *gotos)
+{
+    const int width = table->num_terminals_with_eof;
+    const int num_non_terminals = table->num_non_terminals;
+    unsigned long hash = hash_row(table, actions, gotos);
+
+    for (int i = 0; i < rows->count; i++)
+    {
+        if (rows->hashes[i] == hash &&
+            memcmp(&rows->actions[(size_t)i * (size_t)width], actions, (size_t)width * sizeof(parser_action)) == 0 &&
+            memcmp(&rows->gotos[(size_t)i * (size_t)num_non_terminals], gotos, (size_t)num_non_terminals * sizeof(int)) == 0)
+        {
+            return i;
+        }
+    }
+
+    if (rows->count >= rows->capacity)
+    {
+        int new_capacity = rows->capacity == 0 ? 16 : rows->capacity * 2;
+        parser_action *new_actions =
+            (parser_action *)realloc(rows->actions, (size_t)new_capacity * (size_t)width * sizeof(parser_action));
+        if (new_actions == NULL)
+        {
+            return -1;
+        }
+        rows->actions = new_actions;
+
+        int *new_gotos = (int *)realloc(rows->gotos, (size_t)new_capacity * (size_t)num_non_terminals * sizeof(int));
+        if (new_gotos == NULL)
+        {
+            return -1;
+        }
+        rows->gotos = new_gotos;
+
+        unsigned long *new_hashes = (unsigned long *)realloc(rows->hashes, (size_t)new_capacity * sizeof(unsigned long));
+        if (new_hashes == NULL)
+        {
+            return -1;
+        }
+        rows->hashes = new_hashes;
+        rows->capacity = new_capacity;
+    }
+
+    memcpy(&rows->actions[(size_t)rows->count * (size_t)width], actions, (size_t)width * sizeof(parser_action));
+    memcpy(&rows->gotos[(size_t)rows->count * (size_t)num_non_terminals], gotos, (size_t)num_non_terminals * sizeof(int));
+    rows->hashes[rows->count] = hash;
+    return rows->count++;
+}
+
+static unsigned long hash_row(const parser_table *table, const parser_action *actions, const int *gotos)
+{
+    // FNV-1a over the action types/values and GOTO targets.
+    unsigned long hash = 2166136261UL;
+
+    for (int a = 0; a < table->num_terminals_with_eof; a++)
+    {
+        hash = (hash ^ (unsigned long)actions[a].type) * 16777619UL;
+        hash = (hash ^ (unsigned long)(unsigned int)actions[a].value) * 16777619UL;
+    }
+    for (int nt = 0; nt < table->num_non_terminals; nt++)
+    {
+        hash = (hash ^ (unsigned long)(unsigned int)gotos[nt]) * 16777619UL;
+    }
+
+    return hash;
+}
+
+static bool append_rows(parser_table *table, const unit_rows *rows)
+{
+    if (rows->count == 0)
+    {
+        return true;
+    }
+
+    const size_t width = (size_t)table->num_terminals_with_eof;
+    const size_t num_non_terminals = (size_t)table->num_non_terminals;
+    const size_t new_states = (size_t)table->num_states + (size_t)rows->count;
+
+    parser_action *actions = (parser_action *)realloc(table->action_table, new_states * width * sizeof(parser_action));
+    if (actions == NULL)
+    {
+        return false;
+    }
+    table->action_table = actions;
+
+    int *gotos = (int *)realloc(table->goto_table, new_states * num_non_terminals * sizeof(int));
+    if (gotos == NULL)
+    {
+        // The grown action table is still valid for the old state count.
+        return false;
+    }
+    table->goto_table = gotos;
+
+    if (table->default_reductions != NULL)
+    {
+        int *defaults = (int *)realloc(table->default_reductions, new_states * sizeof(int));
+        if (defaults == NULL)
+        {
+            return false;
+        }
+        table->default_reductions = defaults;
+
+        // Bypass rows mix the rows of several states; they always read their lookahead.
+        for (size_t s = (size_t)table->num_states; s < new_states; s++)
+        {
+            table->default_reductions[s] = -1;
+        }
+    }
+
+    memcpy(&table->action_table[(size_t)table->num_states * width],
+           rows->actions,
+           (size_t)rows->count * width * sizeof(parser_action));
+    memcpy(&table->goto_table[(size_t)table->num_states * num_non_terminals],
+           rows->gotos,
+           (size_t)rows->count * num_non_terminals * sizeof(int));
+    table->num_states = (int)new_states;
+    return true;
+}
+
+bool minimize_parser_states(parser_table *table, int *out_removed_states)
+{
+    if (out_removed_states != NULL)
+    {
+        *out_removed_states = 0;
+    }
+    if (table == NULL || table->g == NULL)
+    {
+        return false;
+    }
+    if (table->has_conflicts || table->num_states <= 1)
+    {
+        // Conflicting actions are stored per cell; renumbering them is not supported.
+        return true;
+    }
+
+    const size_t num_states = (size_t)table->num_states;
+    const size_t signature_length = 1 + 2 * (size_t)table->num_terminals_with_eof + (size_t)table->num_non_terminals;
+    size_t num_buckets = 16;
+    while (num_buckets < 2 * num_states)
+    {
+        num_buckets *= 2;
+    }
+
+    int *classes = (int *)calloc(num_states, sizeof(int));
+    int *signatures = (int *)malloc(num_states * signature_length * sizeof(int));
+    int *buckets = (int *)malloc(num_buckets * sizeof(int));
+    int *next = (int *)malloc(num_states * sizeof(int));
+    bool ok = classes != NULL && signatures != NULL && buckets != NULL && next != NULL;
+
+    if (ok)
+    {
+        // A round only splits classes, so the partition is stable once the count stops growing.
+        int num_classes = refine_state_classes(table, true, classes, signatures, buckets, num_buckets, next);
+        int previous = 0;
+        while (num_classes != previous)
+        {
+            previous = num_classes;
+            num_classes = refine_state_classes(table, false, classes, signatures, buckets, num_buckets, next);
+        }
+
+        int num_new_states = renumber_states(table, classes, num_classes);
+        ok = num_new_states >= 0;
+        if (ok && out_removed_states != NULL)
+        {
+            *out_removed_states = (int)num_states - num_new_states;
+        }
+    }
+
+    free(next);
+    free(buckets);
+    free(signatures);
+    free(classes);
+    return ok;
+}
+
+static int refine_state_classes(
+    const parser_table *table,
+    bool first_round,
+    int *classes,
+    int *signatures,
+    int *buckets,
+    size_t num_buckets,
+    int *next)
+{
+    const int num_states = table->num_states;
+    const size_t signature_length = 1 + 2 * (size_t)table->num_terminals_with_eof + (size_t)table->num_non_terminals;
+
+    for (int s = 0; s < num_states; s++)
+    {
+        build_state_signature(table, classes, s, first_round, &signatures[(size_t)s * signature_length]);
+    }
+
+    // Chained hash table from a signature to the first state that has it. States are
+    // numbered in order, so state 0 always gets class 0.
+    for (size_t b = 0; b < num_buckets; b++)
+    {
+        buckets[b] = -1;
+    }
+
+    int num_classes = 0;
+    for (int s = 0; s < num_states; s++)
+    {
+        const int *signature = &signatures[(size_t)s * signature_length];
+        unsigned long hash = 2166136261UL;
+        for (size_t i = 0; i < signature_length; i++)
+        {
+            hash = (hash ^ (unsigned long)(unsigned int)signature[i]) * 16777619UL;
+        }
+
+        size_t bucket = (size_t)(hash & (unsigned long)(num_buckets - 1));
+        int found = -1;
+        for (int other = buckets[bucket]; other >= 0; other = next[other])
+        {
+            if (memcmp(&signatures[(size_t)other * signature_length], signature, signature_length * sizeof(int)) == 0)
+            {
+                found = other;
+                break;
+            }
+        }
+
+        // The signatures were built from the previous classes, so they can be overwritten now.
+        if (found >= 0)
+        {
+            classes[s] = classes[found];
+            continue;
+        }
+
+        classes[s] = num_classes++;
+        next[s] = buckets[bucket];
+        buckets[bucket] = s;
+    }
+
+    return num_classes;
+}
+
+static void build_state_signature(const parser_table *table, const int *classes, int state_id, bool first_round, int *out)
+{
+    const int width = table->num_terminals_with_eof;
+    const int num_non_terminals = table->num_non_terminals;
+    const parser_action *actions = &table->action_table[state_id * width];
+    const int *gotos = &table->goto_table[state_id * num_non_terminals];
+
+    // The first round starts from one class; it separates states by everything but targets,
+    // including the default reduction, which %nonassoc can withhold from equal rows.
+    out[0] = first_round ? (table->default_reductions != NULL ? table->default_reductions[state_id] : -1)
+                         : classes[state_id];
+    for (int a = 0; a < width; a++)
+    {
+        out[1 + 2 * a] = (int)actions[a].type;
+        out[2 + 2 * a] = actions[a].type == PARSER_ACTION_SHIFT ? classes[actions[a].value] : actions[a].value;
+    }
+    for (int nt = 0; nt < num_non_terminals; nt++)
+    {
+        out[1 + 2 * width + nt] = gotos[nt] >= 0 ? classes[gotos[nt]] : -1;
+    }
+}
+
+static bool *find_reachable_states(const parser_table *table)
+{
+    const int width = table->num_terminals_with_eof;
+    const int num_non_terminals = table->num_non_terminals;
+    bool *reachable = (bool *)calloc((size_t)table->num_states, sizeof(bool));
+    int *pending = (int *)malloc((size_t)table->num_states * sizeof(int));
+    if (reachable == NULL || pending == NULL)
+    {
+        free(reachable);
+        free(pending);
+        return NULL;
+    }
+
+    int num_pending = 0;
+    reachable[0] = true;
+    pending[num_pending++] = 0;
+    for (int entry = 0; entry < table->num_entries; entry++)
+    {
+        int start = table->entry_states[entry];
+        if (start >= 0 && start < table->num_states && !reachable[start])
+        {
+            reachable[start] = true;
+            pending[num_pending++] = start;
+        }
+    }
+    while (num_pending > 0)
+    {
+        int state_id = pending[--num_pending];
+        for (int a = 0; a < width; a++)
+        {
+            parser_action action = table->action_table[state_id * width + a];
+            if (action.type == PARSER_ACTION_SHIFT && !reachable[action.value])
+            {
+                reachable[action.value] = true;
+                pending[num_pending++] = action.value;
+            }
+        }
+        for (int nt = 0; nt < num_non_terminals; nt++)
+        {
+            int target = table->goto_table[state_id * num_non_terminals + nt];
+            if (target >= 0 && !reachable[target])
+            {
+                reachable[target] = true;
+                pending[num_pending++] = target;
+            }
+        }
+    }
+
+    free(pending);
+    return reachable;
+}
+
+static int renumber_states(parser_table *table, const int *classes, int num_classes)
+{
+    const size_t width = (size_t)table->num_terminals_with_eof;
+    const size_t num_non_terminals = (size_t)table->num_non_terminals;
+
+    bool *reachable = find_reachable_states(table);
+    int *new_ids = (int *)malloc((size_t)num_classes * sizeof(int));
+    int *representatives = (int *)malloc((size_t)num_classes * sizeof(int));
+    if (reachable == NULL || new_ids == NULL || representatives == NULL)
+    {
+        free(reachable);
+        free(new_ids);
+        free(representatives);
+        return -1;
+    }
+
+    // Classes are numbered in the order of their first reachable state, which is the one copied.
+    int num_new_states = 0;
+    for (int c = 0; c < num_classes; c++)
+    {
+        new_ids[c] = -1;
+    }
+    for (int s = 0; s < table->num_states; s++)
+    {
+        if (reachable[s] && new_ids[classes[s]] < 0)
+        {
+            new_ids[classes[s]] = num_new_states;
+            representatives[num_new_states++] = s;
+        }
+    }
+    free(reachable);
+
+    parser_action *actions = (parser_action *)malloc((size_t)num_new_states * width * sizeof(parser_action));
+    int *gotos = (int *)malloc((size_t)num_new_states * num_non_terminals * sizeof(int));
+    int *defaults = NULL;
+    if (table->default_reductions != NULL)
+    {
+        defaults = (int *)malloc((size_t)num_new_states * sizeof(int));
+    }
+    if (actions == NULL || gotos == NULL || (table->default_reductions != NULL && defaults == NULL))
+    {
+        free(actions);
+        free(gotos);
+        free(defaults);
+        free(new_ids);
+        free(representatives);
+        return -1;
+    }
+
+    for (int n = 0; n < num_new_states; n++)
+    {
+        const int s = representatives[n];
+        const parser_action *old_actions = &table->action_table[(size_t)s * width];
+        const int *old_gotos = &table->goto_table[(size_t)s * num_non_terminals];
+        parser_action *new_actions = &actions[(size_t)n * width];
+        int *new_gotos = &gotos[(size_t)n * num_non_terminals];
+        for (size_t a = 0; a < width; a++)
+        {
+            new_actions[a] = old_actions[a];
+            if (old_actions[a].type == PARSER_ACTION_SHIFT)
+            {
+                new_actions[a].value = new_ids[classes[old_actions[a].value]];
+            }
+        }
+        for (size_t nt = 0; nt < num_non_terminals; nt++)
+        {
+            new_gotos[nt] = old_gotos[nt] >= 0 ? new_ids[classes[old_gotos[nt]]] : -1;
+        }
+        if (defaults != NULL)
+        {
+            defaults[n] = table->default_reductions[s];
+        }
+    }
+    for (int entry = 0; entry < table->num_entries; entry++)
+    {
+        table->entry_states[entry] = new_ids[classes[table->entry_states[entry]]];
+    }
+    free(new_ids);
+    free(representatives);
+
+    free(table->action_table);
+    free(table->goto_table);
+    table->action_table = actions;
+    table->goto_table = gotos;
+    if (defaults != NULL)
+    {
+        free(table->default_reductions);
+        table->default_reductions = defaults;
+        table->num_default_reductions = 0;
+        for (int n = 0; n < num_new_states; n++)
+        {
+            if (defaults[n] >= 0)
+            {
+                table->num_default_reductions++;
+            }
+        }
+    }
+    table->num_states = num_new_states;
+    return num_new_states;
+}
@@ -0,0 +1,44 @@
+#ifndef TABLE_OPT_H
+#define TABLE_OPT_H
+
+#include <stdbool.h>
+
+#include "parser.h"
+
+/**
+ * @brief Bypasses unit reductions (A -> B, B a non-terminal) in a built table.
+ *
+ * For every GOTO(s, B) whose target reduces by a unit production on some
+ * lookahead, the chain of unit reductions is followed from s for each lookahead
+ * (A -> B, then C -> A, ...) to the state where it stops. GOTO(s, B) is then
+ * redirected to a new state that takes, per lookahead, the ACTION of that final
+ * state, so the driver never performs the unit reductions. Identical new states
+ * are shared. A GOTO entry is left alone when the GOTO rows of its final states
+ * disagree. Tables with conflicts are not changed.
+ *
+ * @param table Parser table to rewrite in place.
+ * @param out_bypassed Optional output: number of GOTO entries redirected.
+ * @param out_added_states Optional output: number of states appended.
+ * @return true on success, false on allocation error (the table is then unchanged).
+ */
+bool eliminate_unit_reductions(parser_table *table, int *out_bypassed, int *out_added_states);
+
+/**
+ * @brief Merges states whose ACTION and GOTO rows are equivalent and renumbers the table.
+ *
+ * States are first partitioned by their reductions, accepts, default reduction
+ * and the cells that shift or have a GOTO. Classes are then refined on the
+ * classes of their SHIFT and GOTO targets until no class splits. Each class
+ * becomes one state; state 0 keeps number 0 and the other classes are numbered
+ * in the order of their first state. Classes that cannot be reached from
+ * state 0 or an entry state, such as states bypassed by eliminate_unit_reductions,
+ * are dropped; the entry states are renumbered with the table.
+ * Tables with conflicts are not changed.
+ *
+ * @param table Parser table to rewrite in place.
+ * @param out_removed_states Optional output: number of states removed.
+ * @return true on success, false on allocation error (the table is then unchanged).
+ */
+bool minimize_parser_states(parser_table *table, int *out_removed_states);
+
+#endif // TABLE_OPT_H
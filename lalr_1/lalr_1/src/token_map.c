@@ -0,0 +1,91 @@
+#include "token_map.h"
+#include "scanner.h"
+
+static int find_terminal_id(const grammar *g, const char *symbol_name);
+
+int map_lexer_token_to_terminal_id(const grammar *g, int lexer_token, const char *lexeme)
+{
+    if (g == NULL)
+    {
+        return -1;
+    }
+
+    if (lexer_token == TOK_EOF)
+    {
+        return g->num_terminals;
+    }
+
+    if (lexer_token == TOK_ERROR)
+    {
+        return -1;
+    }
+
+    // If grammar terminals are literal lexemes, yytext may directly match.
+    int terminal_id = find_terminal_id(g, lexeme);
+    if (terminal_id >= 0)
+    {
+        return terminal_id;
+    }
+
+    switch (lexer_token)
+    {
+    case TOK_IDENTIFIER:
+        terminal_id = find_terminal_id(g, "IDENTIFIER");
+        if (terminal_id < 0) terminal_id = find_terminal_id(g, "ID");
+        if (terminal_id < 0) terminal_id = find_terminal_id(g, "id");
+        return terminal_id;
+    case TOK_INT_LITERAL:
+        terminal_id = find_terminal_id(g, "INT_LITERAL");
+        if (terminal_id < 0) terminal_id = find_terminal_id(g, "INT");
+        if (terminal_id < 0) terminal_id = find_terminal_id(g, "num");
+        return terminal_id;
+    case TOK_FLOAT_LITERAL:
+        terminal_id = find_terminal_id(g, "FLOAT_LITERAL");
+        if (terminal_id < 0) terminal_id = find_terminal_id(g, "FLOAT");
+        if (terminal_id < 0) terminal_id = find_terminal_id(g, "num");
+        return terminal_id;
+    case TOK_STRING_LITERAL:
+        terminal_id = find_terminal_id(g, "STRING_LITERAL");
+        if (terminal_id < 0) terminal_id = find_terminal_id(g, "STRING");
+        if (terminal_id < 0) terminal_id = find_terminal_id(g, "str");
+        return terminal_id;
+    case TOK_CHAR_LITERAL:
+        terminal_id = find_terminal_id(g, "CHAR_LITERAL");
+        if (terminal_id < 0) terminal_id = find_terminal_id(g, "CHAR");
+        if (terminal_id < 0) terminal_id = find_terminal_id(g, "char_lit");
+        return terminal_id;
+    default:
+        break;
+    }
+
+    // Fallback for lexers that return punctuation as character codes.
+    if (lexer_token > 0 && lexer_token <= 127)
+    {
+        char one_char_symbol[2] = {(char)lexer_token, '\0'};
+        terminal_id = find_terminal_id(g, one_char_symbol);
+        if (terminal_id >= 0)
+        {
+            return terminal_id;
+        }
+    }
+
+    return -1;
+}
+
+static int find_terminal_id(const grammar *g, const char *symbol_name)
+{
+    if (g == NULL || symbol_name == NULL)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < g->num_terminals; i++)
+    {
+        if (strcmp(g->terminals[i].symbol, symbol_name) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,19 @@
+#ifndef TOKEN_MAP_H
+#define TOKEN_MAP_H
+
+#include "grammar.h"
+
+/**
+ * @brief Maps lexer token ids to grammar terminal ids.
+ *
+ * Literal lexemes (`int`, `;`, `(` ...) match terminals directly; token classes
+ * fall back to the usual aliases (IDENTIFIER/ID/id, INT_LITERAL/INT/num, ...).
+ *
+ * @param g Parsed grammar.
+ * @param lexer_token Token returned by yylex().
+ * @param lexeme Lexeme text from yytext.
+ * @return Terminal id, g->num_terminals for EOF, or -1 if unmapped.
+ */
+int map_lexer_token_to_terminal_id(const grammar *g, int lexer_token, const char *lexeme);
+
+#endif // TOKEN_MAP_H
@@ -0,0 +1,309 @@
+#include "token_pipeline.h"
+#include "scanner.h"
+#include "token_map.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Ring slots; a power of two so positions wrap with a mask.
+#define TOKEN_RING_CAPACITY 4096
+#define LEXEME_CHUNK_SIZE (64 * 1024)
+#define LEXEME_CHUNK_COUNT 8
+#define SPINS_BEFORE_YIELD 64
+
+typedef struct token_slot
+{
+    token_stream token;
+    // Sequence number of the lexeme chunk holding token.lexeme.
+    long chunk;
+} token_slot;
+
+typedef struct lexeme_chunk
+{
+    char *text;
+    size_t capacity;
+} lexeme_chunk;
+
+struct token_pipeline
+{
+    const grammar *g;
+    yyscan_t scanner;
+    pthread_t scanner_thread;
+    token_slot *ring;
+    // Chunk sequence n lives in chunks[n % LEXEME_CHUNK_COUNT].
+    lexeme_chunk chunks[LEXEME_CHUNK_COUNT];
+
+    // Written by the parser thread: next slot to read, and the oldest chunk it still uses.
+    _Alignas(64) atomic_size_t head;
+    atomic_long oldest_used_chunk;
+    // Written by the scanner thread: next slot to write.
+    _Alignas(64) atomic_size_t tail;
+    // Set by stop_token_pipeline to end a scanner thread blocked on a full ring.
+    atomic_bool cancelled;
+
+    // Scanner thread only: chunk being filled and the bytes used in it.
+    _Alignas(64) long chunk;
+    size_t chunk_used;
+
+    // Parser thread only: the EOF record, repeated once it has been read.
+    bool at_eof;
+    token_stream eof_token;
+};
+
+static void *scanner_thread_main(void *arg);
+static const char *copy_lexeme(token_pipeline *pipeline, const char *text, size_t length);
+static bool publish_token(token_pipeline *pipeline, const token_stream *token);
+static void publish_out_of_memory(token_pipeline *pipeline, int line);
+static void wait_briefly(int *spins);
+
+token_pipeline *start_token_pipeline(const grammar *g, yyscan_t scanner)
+{
+    if (g == NULL || scanner == NULL)
+    {
+        return NULL;
+    }
+
+    token_pipeline *pipeline = (token_pipeline *)calloc(1, sizeof(token_pipeline));
+    if (pipeline == NULL)
+    {
+        return NULL;
+    }
+
+    pipeline->g = g;
+    pipeline->scanner = scanner;
+    pipeline->ring = (token_slot *)malloc(TOKEN_RING_CAPACITY * sizeof(token_slot));
+    if (pipeline->ring == NULL)
+    {
+        free(pipeline);
+        return NULL;
+    }
+    atomic_init(&pipeline->head, 0);
+    atomic_init(&pipeline->tail, 0);
+    atomic_init(&pipeline->oldest_used_chunk, 0);
+    atomic_init(&pipeline->cancelled, false);
+
+    if (pthread_create(&pipeline->scanner_thread, NULL, scanner_thread_main, pipeline) != 0)
+    {
+        free(pipeline->ring);
+        free(pipeline);
+        return NULL;
+    }
+
+    return pipeline;
+}
+
+bool token_pipeline_next(token_pipeline *pipeline, token_stream *out_token)
+{
+    if (pipeline == NULL || out_token == NULL)
+    {
+        return false;
+    }
+
+    if (pipeline->at_eof)
+    {
+        *out_token = pipeline->eof_token;
+        return out_token->terminal_id >= 0;
+    }
+
+    size_t head = atomic_load_explicit(&pipeline->head, memory_order_relaxed);
+    int spins = 0;
+    while (atomic_load_explicit(&pipeline->tail, memory_order_acquire) == head)
+    {
+        wait_briefly(&spins);
+    }
+
+    const token_slot *slot = &pipeline->ring[head & (TOKEN_RING_CAPACITY - 1)];
+    *out_token = slot->token;
+    // Lexemes of the tokens before this one are no longer referenced.
+    atomic_store_explicit(&pipeline->oldest_used_chunk, slot->chunk, memory_order_release);
+    atomic_store_explicit(&pipeline->head, head + 1, memory_order_release);
+
+    if (out_token->lexer_token == TOK_EOF)
+    {
+        pipeline->at_eof = true;
+        pipeline->eof_token = *out_token;
+    }
+
+    return out_token->terminal_id >= 0;
+}
+
+void stop_token_pipeline(token_pipeline *pipeline)
+{
+    if (pipeline == NULL)
+    {
+        return;
+    }
+
+    atomic_store_explicit(&pipeline->cancelled, true, memory_order_release);
+    pthread_join(pipeline->scanner_thread, NULL);
+
+    for (int i = 0; i < LEXEME_CHUNK_COUNT; i++)
+    {
+        free(pipeline->chunks[i].text);
+    }
+    free(pipeline->ring);
+    free(pipeline);
+}
+
+/**
+ * @brief Scanner thread: lexes, maps and publishes tokens until EOF or cancellation.
+ * @param arg Pointer to the token_pipeline.
+ * @return Always NULL.
+ */
+static void *scanner_thread_main(void *arg)
+{
+    token_pipeline *pipeline = (token_pipeline *)arg;
+
+    while (true)
+    {
+        token_stream token;
+        token.lexer_token = yylex(pipeline->scanner);
+        const char *text = yyget_text(pipeline->scanner);
+        const char *lexeme = text != NULL ? text : "";
+        token.terminal_id = map_lexer_token_to_terminal_id(pipeline->g, token.lexer_token, lexeme);
+        token.line = yyget_lineno(pipeline->scanner);
+        token.lexeme = copy_lexeme(pipeline, lexeme, strlen(lexeme));
+
+        if (token.lexeme == NULL)
+        {
+            if (!atomic_load_explicit(&pipeline->cancelled, memory_order_acquire))
+            {
+                publish_out_of_memory(pipeline, token.line);
+            }
+            break;
+        }
+
+        if (!publish_token(pipeline, &token) || token.lexer_token == TOK_EOF)
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Ends the stream after a failed lexeme copy: a token no terminal matches, then EOF.
+ *
+ * The EOF record lets a parser that recovers from the error still reach the end
+ * of the stream instead of waiting on a ring nothing will fill again.
+ *
+ * @param pipeline Pipeline owning the ring.
+ * @param line Line of the token that could not be copied.
+ * @return This function does not return a value.
+ */
+static void publish_out_of_memory(token_pipeline *pipeline, int line)
+{
+    token_stream token;
+    token.lexer_token = TOK_ERROR;
+    token.terminal_id = -1;
+    token.lexeme = "<out of memory>";
+    token.line = line;
+    if (!publish_token(pipeline, &token))
+    {
+        return;
+    }
+
+    token.lexer_token = TOK_EOF;
+    token.terminal_id = map_lexer_token_to_terminal_id(pipeline->g, TOK_EOF, "");
+    token.lexeme = "";
+    publish_token(pipeline, &token);
+}
+
+/**
+ * @brief Copies a lexeme into the current arena chunk, starting a new chunk when it is full.
+ *
+ * A chunk is reused LEXEME_CHUNK_COUNT chunks later, once the parser thread has
+ * moved past every token whose lexeme it holds.
+ *
+ * @param pipeline Pipeline owning the arena.
+ * @param text Lexeme text.
+ * @param length Lexeme length in bytes.
+ * @return Copy of the lexeme, or NULL on allocation error or cancellation.
+ */
+static const char *copy_lexeme(token_pipeline *pipeline, const char *text, size_t length)
+{
+    lexeme_chunk *chunk = &pipeline->chunks[pipeline->chunk % LEXEME_CHUNK_COUNT];
+    if (chunk->text == NULL || pipeline->chunk_used + length + 1 > chunk->capacity)
+    {
+        if (chunk->text != NULL)
+        {
+            pipeline->chunk++;
+            pipeline->chunk_used = 0;
+            chunk = &pipeline->chunks[pipeline->chunk % LEXEME_CHUNK_COUNT];
+        }
+
+        int spins = 0;
+        while (pipeline->chunk - LEXEME_CHUNK_COUNT >=
+               atomic_load_explicit(&pipeline->oldest_used_chunk, memory_order_acquire))
+        {
+            if (atomic_load_explicit(&pipeline->cancelled, memory_order_acquire))
+            {
+                return NULL;
+            }
+            wait_briefly(&spins);
+        }
+
+        if (chunk->capacity < length + 1)
+        {
+            size_t capacity = length + 1 > LEXEME_CHUNK_SIZE ? length + 1 : LEXEME_CHUNK_SIZE;
+            char *grown = (char *)realloc(chunk->text, capacity);
+            if (grown == NULL)
+            {
+                return NULL;
+            }
+            chunk->text = grown;
+            chunk->capacity = capacity;
+        }
+    }
+
+    char *copy = chunk->text + pipeline->chunk_used;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    pipeline->chunk_used += length + 1;
+    return copy;
+}
+
+/**
+ * @brief Appends a token to the ring, waiting while the ring is full.
+ * @param pipeline Pipeline owning the ring.
+ * @param token Token to publish; its lexeme lies in the current chunk.
+ * @return true once published, false when the pipeline was cancelled.
+ */
+static bool publish_token(token_pipeline *pipeline, const token_stream *token)
+{
+    size_t tail = atomic_load_explicit(&pipeline->tail, memory_order_relaxed);
+    int spins = 0;
+    while (tail - atomic_load_explicit(&pipeline->head, memory_order_acquire) == TOKEN_RING_CAPACITY)
+    {
+        if (atomic_load_explicit(&pipeline->cancelled, memory_order_acquire))
+        {
+            return false;
+        }
+        wait_briefly(&spins);
+    }
+
+    token_slot *slot = &pipeline->ring[tail & (TOKEN_RING_CAPACITY - 1)];
+    slot->token = *token;
+    slot->chunk = pipeline->chunk;
+    atomic_store_explicit(&pipeline->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Busy-waits a few rounds, then gives the core away while the other thread catches up.
+ * @param spins Number of rounds waited so far; updated.
+ * @return This function does not return a value.
+ */
+static void wait_briefly(int *spins)
+{
+    if (*spins < SPINS_BEFORE_YIELD)
+    {
+        (*spins)++;
+        return;
+    }
+    sched_yield();
+}
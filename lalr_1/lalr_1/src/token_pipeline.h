@@ -0,0 +1,54 @@
+#ifndef TOKEN_PIPELINE_H
+#define TOKEN_PIPELINE_H
+
+#include <stdbool.h>
+
+#include "grammar.h"
+#include "scanner_flex.h"
+
+typedef struct token_stream
+{
+    int lexer_token;
+    int terminal_id;
+    const char *lexeme;
+    int line;
+} token_stream;
+
+typedef struct token_pipeline token_pipeline;
+
+/**
+ * @brief Starts a scanner thread that lexes and maps tokens ahead of the parser.
+ *
+ * The thread calls yylex on the scanner, maps every token to its terminal id and
+ * copies the lexeme into a chunked arena, then publishes the token_stream record
+ * in a single-producer/single-consumer lock-free ring. It stops after the EOF
+ * token; when a lexeme cannot be copied, it publishes a token no terminal
+ * matches and then EOF. Lexing and parsing can then overlap when a second core is free; the
+ * pipelined_parse stage of driver_bench measures whether they do.
+ *
+ * @param g Parsed grammar used to map lexer tokens; only read by the thread.
+ * @param scanner Initialized scanner; the thread owns it until stop_token_pipeline.
+ * @return Newly allocated pipeline, or NULL on allocation or thread creation error.
+ */
+token_pipeline *start_token_pipeline(const grammar *g, yyscan_t scanner);
+
+/**
+ * @brief Takes the next token from the ring, waiting for the scanner thread if it is empty.
+ *
+ * The lexeme stays valid until the following call. After the EOF token every
+ * call returns EOF again.
+ *
+ * @param pipeline Running pipeline.
+ * @param out_token Output token descriptor.
+ * @return true on success, false when the token cannot be mapped to a terminal.
+ */
+bool token_pipeline_next(token_pipeline *pipeline, token_stream *out_token);
+
+/**
+ * @brief Stops the scanner thread, even before EOF, and releases the pipeline.
+ * @param pipeline Pipeline to stop; the scanner may be destroyed afterwards.
+ * @return This function does not return a value.
+ */
+void stop_token_pipeline(token_pipeline *pipeline);
+
+#endif // TOKEN_PIPELINE_H
@@ -0,0 +1,53 @@
+# Bounds the parser steps of edits to a long left-recursive declaration list.
+# An edit to the last element must stay constant; one to the first rebuilds the list
+# spine, about two steps per following element, and must stay well below a full parse.
+# Usage: cmake -DFIRST_AND_FOLLOW=<exe> -DTEST_DIR=<dir> -DWORK_DIR=<dir> -P incremental_list_steps.cmake
+
+set(count 10000)
+set(source "")
+foreach(i RANGE 1 ${count})
+    string(APPEND source "int a${i};\n")
+endforeach()
+file(WRITE ${WORK_DIR}/incremental_list_steps.c "${source}")
+
+string(LENGTH "${source}" length)
+string(LENGTH "int a${count};\n" last_length)
+math(EXPR last_offset "${length} - ${last_length}")
+
+execute_process(
+    COMMAND ${FIRST_AND_FOLLOW}
+        ${TEST_DIR}/grammar_decl_list.txt
+        ${WORK_DIR}/incremental_list_steps.c
+        ${WORK_DIR}/incremental_list_steps.csv
+        --edit=${last_offset}:3:float
+        --edit=0:3:float
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors
+)
+
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Edited input was rejected:\n${errors}")
+endif()
+
+foreach(label "Initial parse" "Edit 1" "Edit 2")
+    if(NOT output MATCHES "${label}: accepted \\([0-9]+ tokens lexed, [0-9]+ subtrees reused, ([0-9]+) parser steps\\)")
+        message(FATAL_ERROR "No report for ${label}")
+    endif()
+    string(REPLACE " " "_" name "${label}")
+    set(steps_${name} ${CMAKE_MATCH_1})
+endforeach()
+
+message(STATUS "Full parse ${steps_Initial_parse} steps, "
+    "edit at the end ${steps_Edit_1}, edit at the start ${steps_Edit_2}")
+
+if(steps_Edit_1 GREATER 32)
+    message(FATAL_ERROR "Edit to the last element took ${steps_Edit_1} steps")
+endif()
+
+math(EXPR spine_bound "2 * ${count} + 16")
+math(EXPR full_bound "${steps_Initial_parse} / 2")
+if(steps_Edit_2 GREATER spine_bound OR steps_Edit_2 GREATER full_bound)
+    message(FATAL_ERROR "Edit to the first element took ${steps_Edit_2} steps "
+        "(bound ${spine_bound}, full parse ${steps_Initial_parse})")
+endif()
@@ -0,0 +1,29 @@
+# A reduction that reaches a cell %nonassoc emptied must leave it an error, not count a conflict.
+# In the state after `E < E`, `<` is shifted, reduced by `E -> E < E` (%nonassoc: error) and
+# reduced by `A -> E`; only the reduce/reduce pair on end of input is a conflict.
+# Usage: cmake -DFIRST_AND_FOLLOW=<exe> -DTEST_DIR=<dir> -DWORK_DIR=<dir> -P nonassoc_chain.cmake
+
+execute_process(
+    COMMAND ${FIRST_AND_FOLLOW}
+        ${TEST_DIR}/grammar_nonassoc_chain.txt
+        ${TEST_DIR}/nonassoc_chain.c
+        ${WORK_DIR}/nonassoc_chain.csv
+        --compare-modes
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors
+)
+
+foreach(mode SLR LALR LR)
+    if(NOT output MATCHES "\n${mode}\\(1\\) +[0-9]+ +[0-9]+ +1 ")
+        message(FATAL_ERROR "Expected one conflict in ${mode}(1):\n${output}")
+    endif()
+endforeach()
+
+if(NOT errors MATCHES "has 1 conflicts")
+    message(FATAL_ERROR "Expected one conflict in the table:\n${errors}")
+endif()
+
+if(NOT errors MATCHES "Syntax error at token '<' [^\n]* at line 1\n" OR result EQUAL 0)
+    message(FATAL_ERROR "The second '<' of a non-associative chain was not rejected:\n${errors}")
+endif()
@@ -0,0 +1,7 @@
+int a;
+int ;
+float b;
+float float c;
+int c;
+int d d;
+float e;
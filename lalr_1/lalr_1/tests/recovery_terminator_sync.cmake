@@ -0,0 +1,26 @@
+# Three broken declarations with `%sync ;`: every one must be reported, not only the first.
+# Usage: cmake -DFIRST_AND_FOLLOW=<exe> -DTEST_DIR=<dir> -DWORK_DIR=<dir> -P recovery_terminator_sync.cmake
+
+execute_process(
+    COMMAND ${FIRST_AND_FOLLOW}
+        ${TEST_DIR}/grammar_decl_list.txt
+        ${TEST_DIR}/recovery_terminator_sync.c
+        ${WORK_DIR}/recovery_terminator_sync.csv
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors
+)
+
+foreach(line 2 4 6)
+    if(NOT errors MATCHES "Syntax error at token [^\n]* at line ${line}\n")
+        message(FATAL_ERROR "No syntax error reported at line ${line}:\n${errors}")
+    endif()
+endforeach()
+
+if(NOT errors MATCHES "3 error\\(s\\) reported\\.")
+    message(FATAL_ERROR "Expected exactly 3 errors:\n${errors}")
+endif()
+
+if(result EQUAL 0)
+    message(FATAL_ERROR "Input with syntax errors was accepted")
+endif()
@@ -0,0 +1,40 @@
+# An unterminated comment with `%sync` declared must be reported once and end the parse,
+# in the synchronous, pipelined and batch drivers alike.
+# Usage: cmake -DFIRST_AND_FOLLOW=<exe> -DTEST_DIR=<dir> -DWORK_DIR=<dir> -P recovery_unterminated_comment.cmake
+
+set(source ${TEST_DIR}/recovery_unterminated_comment.c)
+
+foreach(run sync pipeline batch)
+    if(run STREQUAL "pipeline")
+        set(options ${source} --pipeline)
+    elseif(run STREQUAL "batch")
+        set(options ${source} ${TEST_DIR}/recovery_terminator_sync.c --jobs=2)
+    else()
+        set(options ${source})
+    endif()
+
+    execute_process(
+        COMMAND ${FIRST_AND_FOLLOW}
+            ${TEST_DIR}/grammar_decl_list.txt
+            ${options}
+            ${WORK_DIR}/recovery_unterminated_comment.csv
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors
+        TIMEOUT 20
+    )
+
+    if(NOT result MATCHES "^[0-9]+$")
+        message(FATAL_ERROR "${run}: first_and_follow did not finish (${result})")
+    endif()
+
+    string(REGEX MATCHALL "could not be mapped" reports "${errors}")
+    list(LENGTH reports num_reports)
+    if(NOT num_reports EQUAL 1)
+        message(FATAL_ERROR "${run}: expected the unterminated comment to be reported once, got ${num_reports}")
+    endif()
+
+    if(result EQUAL 0)
+        message(FATAL_ERROR "${run}: input with an unterminated comment was accepted")
+    endif()
+endforeach()
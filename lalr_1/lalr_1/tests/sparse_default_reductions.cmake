@@ -0,0 +1,50 @@
+# The sparse JSON export must record default reductions and leave out the reduce cells
+# they cover, so that states which only reduce have empty ACTION rows.
+# Usage: cmake -DFIRST_AND_FOLLOW=<exe> -DTEST_DIR=<dir> -DWORK_DIR=<dir> -P sparse_default_reductions.cmake
+
+set(table ${WORK_DIR}/sparse_default_reductions.sparse.json)
+file(REMOVE ${table})
+execute_process(
+    COMMAND ${FIRST_AND_FOLLOW}
+        ${TEST_DIR}/grammar_decl_list.txt
+        ${TEST_DIR}/recovery_terminator_sync.c
+        ${table}
+    OUTPUT_QUIET
+    ERROR_QUIET
+)
+
+# CMake lists do not split inside square brackets, so the rows are matched with parentheses.
+file(READ ${table} json)
+string(REPLACE "[" "(" json "${json}")
+string(REPLACE "]" ")" json "${json}")
+set(defaults "")
+set(rows "")
+if(json MATCHES "\"defaultReductions\": \\(([-0-9, ]*)\\)")
+    string(REPLACE ", " ";" defaults "${CMAKE_MATCH_1}")
+endif()
+if(json MATCHES "\"action\": \\(\n([^\n]*(\n    [^\n]*)*)\n  \\)")
+    string(REPLACE "\n" ";" rows "${CMAKE_MATCH_1}")
+endif()
+
+list(LENGTH defaults num_states)
+list(LENGTH rows num_rows)
+if(num_states EQUAL 0 OR NOT num_states EQUAL num_rows)
+    message(FATAL_ERROR "Expected defaultReductions and one ACTION row per state in ${table}")
+endif()
+
+set(num_defaults 0)
+math(EXPR last "${num_states} - 1")
+foreach(state RANGE ${last})
+    list(GET defaults ${state} production)
+    list(GET rows ${state} row)
+    if(production GREATER -1)
+        math(EXPR num_defaults "${num_defaults} + 1")
+        if(row MATCHES "\"REDUCE\",${production}\\)")
+            message(FATAL_ERROR "State ${state} lists reduce cells of its default reduction: ${row}")
+        endif()
+    endif()
+endforeach()
+
+if(num_defaults EQUAL 0)
+    message(FATAL_ERROR "No state of the declaration grammar got a default reduction")
+endif()